@@ -0,0 +1,134 @@
+// Crowd pose evaluation: sampling every instance's clip in one AnimationBatch,
+// then forward kinematics and palette rows per instance, inline and on the
+// JobSystem. Uses a character's .skel and .anim files.
+// Build and run with: make bench && ./bench/crowd_bench [data/characters/Model1]
+
+#include "AnimationClip.h"
+#include "Crowd.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int ITERATIONS = 200;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Best of ITERATIONS runs, which filters out scheduler noise
+template <typename Body>
+double bestMs(const Body& body) {
+    double best = 1.0e30;
+    for (int it = 0; it < ITERATIONS; ++it) {
+        Clock::time_point start = Clock::now();
+        body();
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
+
+// Parents, rest offsets and bind transforms from a .skel file ("x y z parent" per joint)
+bool loadSkeleton(const std::string& path, std::vector<int>& parents, std::vector<glm::mat4>& restLocal,
+                  std::vector<glm::mat4>& bindWorldToJoint) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        glm::vec3 offset;
+        int parent;
+        if (!(ss >> offset.x >> offset.y >> offset.z >> parent)) continue;
+
+        glm::mat4 local(1.0f);
+        local[3] = glm::vec4(offset, 1.0f);
+        parents.push_back(parent);
+        restLocal.push_back(local);
+    }
+
+    // .skel lists parents before their children
+    std::vector<glm::mat4> jointToWorld(parents.size());
+    for (size_t j = 0; j < parents.size(); ++j) {
+        jointToWorld[j] = parents[j] < 0 ? restLocal[j] : jointToWorld[parents[j]] * restLocal[j];
+        bindWorldToJoint.push_back(glm::inverse(jointToWorld[j]));
+    }
+    return !parents.empty();
+}
+
+void benchCrowd(const Crowd& prototype, const AnimationClip& clip, size_t count) {
+    Crowd crowd = prototype;
+    crowd.layoutGrid(count, 0.6f, clip.getDuration());
+
+    AnimationBatch batch;
+    const float step = 1.0f / 60.0f;
+
+    double sampleMs = bestMs([&]() {
+        crowd.advance(step, clip.getDuration());
+        batch.clear();
+        crowd.queueAnimation(clip, batch);
+        batch.evaluate();
+    });
+
+    double poseMs = bestMs([&]() {
+        crowd.evaluatePoses(batch, 0, clip.getTrackCount());
+    });
+
+    const size_t paletteBytes = crowd.getPaletteRows().size() * sizeof(float);
+    std::printf("  %4zu instances: sample %7.3f ms, pose %7.3f ms, total %7.3f ms, %6.1f KB palette\n",
+                crowd.getInstanceCount(), sampleMs, poseMs, sampleMs + poseMs, paletteBytes / 1024.0);
+}
+
+void benchAll(const Crowd& prototype, const AnimationClip& clip) {
+    const size_t counts[] = { 1, 100, 500, 1000 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        benchCrowd(prototype, clip, counts[i]);
+    }
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    std::string basePath = argc > 1 ? argv[1] : "data/characters/Model1";
+
+    std::vector<int> parents;
+    std::vector<glm::mat4> restLocal, bindWorldToJoint;
+    AnimationClip clip;
+    if (!loadSkeleton(basePath + ".skel", parents, restLocal, bindWorldToJoint) ||
+        !clip.loadFromFile(basePath + ".anim") || clip.isEmpty()) {
+        std::printf("%s: could not load the skeleton and clip\n", basePath.c_str());
+        return 1;
+    }
+
+    // .skel order is already parent-first, so slots are joint indices
+    std::vector<int> slotJoints(parents.size());
+    for (size_t j = 0; j < slotJoints.size(); ++j) {
+        slotJoints[j] = static_cast<int>(j);
+    }
+
+    Crowd prototype;
+    prototype.setSkeleton(slotJoints, parents, restLocal, bindWorldToJoint);
+    std::printf("%s: %zu joints, %zu tracks, %.2f s clip\n", basePath.c_str(), parents.size(),
+                clip.getTrackCount(), clip.getDuration());
+
+    std::printf("Inline\n");
+    benchAll(prototype, clip);
+
+    JobSystem::start();
+    std::printf("JobSystem, %u workers\n", JobSystem::getWorkerCount());
+    benchAll(prototype, clip);
+    JobSystem::shutdown();
+    return 0;
+}
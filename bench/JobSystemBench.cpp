@@ -0,0 +1,117 @@
+// Micro-benchmark for JobSystem task spawn and parallelFor overhead, plus a
+// check that the main thread runs none of an import thread's chunks.
+// Build and run with: make bench && ./bench/job_bench
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsedNs(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+// Spawn `count` empty jobs and wait for all of them
+double spawnAndWait(int count) {
+    std::vector<JobSystem::JobHandle> handles;
+    handles.reserve(count);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        handles.push_back(JobSystem::run([]() {}));
+    }
+    for (const JobSystem::JobHandle& handle : handles) {
+        JobSystem::wait(handle);
+    }
+    return elapsedNs(start) / count;
+}
+
+// Chain of `count` jobs, each depending on the previous one
+double dependencyChain(int count) {
+    Clock::time_point start = Clock::now();
+    JobSystem::JobHandle previous;
+    for (int i = 0; i < count; ++i) {
+        previous = JobSystem::run([]() {}, std::vector<JobSystem::JobHandle>(1, previous));
+    }
+    JobSystem::wait(previous);
+    return elapsedNs(start) / count;
+}
+
+// Time a parallelFor over a simple per-element workload
+double parallelForMs(std::vector<float>& data, size_t grainSize) {
+    Clock::time_point start = Clock::now();
+    JobSystem::parallelFor(0, data.size(), grainSize, [&data](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            data[i] = std::sqrt(data[i] * data[i] + 1.0f);
+        }
+    });
+    return elapsedNs(start) / 1.0e6;
+}
+
+// An import thread parses in slow chunks while the main thread keeps running
+// its own parallel loops, as a frame does; returns the import chunks the main
+// thread ran, which must be none
+int importChunksOnMainThread(std::vector<float>& data, int& frames) {
+    const std::thread::id mainThread = std::this_thread::get_id();
+    std::atomic<int> chunksOnMain(0);
+    std::atomic<bool> importDone(false);
+
+    std::thread import([&]() {
+        JobSystem::parallelFor(0, 64, 1, [&](size_t, size_t) {
+            if (std::this_thread::get_id() == mainThread) {
+                ++chunksOnMain;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        });
+        importDone = true;
+    });
+
+    frames = 0;
+    while (!importDone) {
+        parallelForMs(data, 16384);
+        ++frames;
+    }
+    import.join();
+    return chunksOnMain;
+}
+
+}
+
+
+int main() {
+    const int jobCount = 100000;
+    std::vector<float> data(1 << 22, 1.0f);
+
+    // Inline baseline, before any worker exists
+    double serialMs = parallelForMs(data, data.size());
+
+    JobSystem::start();
+    std::printf("workers: %u\n", JobSystem::getWorkerCount());
+
+    // Warm up queues and allocator
+    spawnAndWait(jobCount / 10);
+
+    std::printf("spawn + wait (empty job):   %8.1f ns/job\n", spawnAndWait(jobCount));
+    std::printf("dependency chain:           %8.1f ns/job\n", dependencyChain(jobCount));
+    std::printf("parallelFor 4M, serial:     %8.2f ms\n", serialMs);
+
+    const size_t grains[] = { 1024, 16384, 262144 };
+    for (size_t grain : grains) {
+        std::printf("parallelFor 4M, grain %6zu: %8.2f ms\n", grain, parallelForMs(data, grain));
+    }
+
+    int frames = 0;
+    const int foreignChunks = importChunksOnMainThread(data, frames);
+    std::printf("import chunks on main thread: %d (over %d frames)\n", foreignChunks, frames);
+
+    JobSystem::shutdown();
+    return foreignChunks == 0 ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+// Throughput benchmark for ObjParser against the previous getline/istringstream importer,
+// single-threaded and with the chunks spread over the JobSystem.
+// Build and run with: make bench && ./bench/obj_bench [file.obj]
+
+#include "JobSystem.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// What the original importer produced: one index vector per face
+struct StreamObjData {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<std::vector<int>> faces;
+};
+
+// The importer's original loop, kept verbatim as the reference
+bool parseWithStreams(const std::string& path, StreamObjData& out) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::string prefix;
+        ss >> prefix;
+
+        if (prefix == "v") {
+            float x, y, z;
+            ss >> x >> y >> z;
+            out.vertices.push_back(glm::vec3(x, y, z));
+        } else if (prefix == "vn") {
+            float nx, ny, nz;
+            ss >> nx >> ny >> nz;
+            out.normals.push_back(glm::vec3(nx, ny, nz));
+        } else if (prefix == "f") {
+            std::vector<int> face;
+            std::string vertexData;
+            for (int i = 0; i < 3; ++i) {
+                ss >> vertexData;
+                size_t pos1 = vertexData.find('/');
+                size_t pos2 = vertexData.find('/', pos1 + 1);
+                face.push_back(std::stoi(vertexData.substr(0, pos1)) - 1);
+                face.push_back(std::stoi(vertexData.substr(pos2 + 1)) - 1);
+            }
+            out.faces.push_back(face);
+        }
+    }
+    return true;
+}
+
+bool sameFaces(const std::vector<std::vector<int>>& reference, const ObjData& parsed) {
+    if (reference.size() != parsed.getFaceCount()) {
+        return false;
+    }
+    for (size_t i = 0; i < reference.size(); ++i) {
+        if (reference[i].size() != parsed.faceStride ||
+            !std::equal(reference[i].begin(), reference[i].end(), parsed.getFace(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameVectors(const std::vector<glm::vec3>& a, const std::vector<glm::vec3>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Unindexed (position, normal) corners, as ImportShape used to upload them
+void buildCorners(const ObjData& obj, std::vector<float>& corners) {
+    for (size_t i = 0; i < obj.getFaceCount(); ++i) {
+        const int* face = obj.getFace(i);
+        for (int j = 0; j < 3; ++j) {
+            const glm::vec3& position = obj.vertices[face[j * 2]];
+            const glm::vec3& normal = obj.normals[face[j * 2 + 1]];
+            const float corner[6] = { position.x, position.y, position.z, normal.x, normal.y, normal.z };
+            corners.insert(corners.end(), corner, corner + 6);
+        }
+    }
+}
+
+// Best of `runs` timings, so page cache and allocator warm-up do not count
+template <typename Parse>
+double bestMs(int runs, Parse parse) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        Clock::time_point start = Clock::now();
+        parse();
+        double ms = elapsedMs(start);
+        best = ms < best ? ms : best;
+    }
+    return best;
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "data/obj/garg.obj";
+    const int runs = 5;
+
+    MappedFile file;
+    if (!file.open(path)) {
+        std::fprintf(stderr, "Unable to open file: %s\n", path.c_str());
+        return 1;
+    }
+    const double megabytes = file.getSize() / (1024.0 * 1024.0);
+    file.close();
+
+    // Correctness: both parsers must agree exactly
+    StreamObjData reference;
+    ObjData parsed;
+    parseWithStreams(path, reference);
+    ObjParser::parseFile(path, ObjParser::VertexNormalPairs, parsed);
+    const bool identical = sameVectors(reference.vertices, parsed.vertices) &&
+                           sameVectors(reference.normals, parsed.normals) &&
+                           sameFaces(reference.faces, parsed);
+
+    std::printf("%s: %.2f MB, %zu v, %zu vn, %zu f\n", path.c_str(), megabytes,
+                parsed.vertices.size(), parsed.normals.size(), parsed.getFaceCount());
+    std::printf("results identical:  %s\n", identical ? "yes" : "NO");
+
+    const double streamMs = bestMs(runs, [&path]() {
+        StreamObjData data;
+        parseWithStreams(path, data);
+    });
+    const double mappedMs = bestMs(runs, [&path]() {
+        ObjData data;
+        ObjParser::parseFile(path, ObjParser::VertexNormalPairs, data);
+    });
+
+    // Same parse with workers available; results must not depend on the split
+    JobSystem::start();
+    ObjData threaded;
+    ObjParser::parseFile(path, ObjParser::VertexNormalPairs, threaded);
+    const bool threadedIdentical = sameVectors(reference.vertices, threaded.vertices) &&
+                                   sameVectors(reference.normals, threaded.normals) &&
+                                   sameFaces(reference.faces, threaded);
+    const double threadedMs = bestMs(runs, [&path]() {
+        ObjData data;
+        ObjParser::parseFile(path, ObjParser::VertexNormalPairs, data);
+    });
+    const unsigned threads = JobSystem::getWorkerCount() + 1;
+    JobSystem::shutdown();
+
+    std::printf("threaded identical: %s\n", threadedIdentical ? "yes" : "NO");
+    std::printf("istringstream:      %8.2f ms  %8.1f MB/s\n", streamMs, megabytes / (streamMs / 1000.0));
+    std::printf("ObjParser, 1 thread:%8.2f ms  %8.1f MB/s\n", mappedMs, megabytes / (mappedMs / 1000.0));
+    std::printf("ObjParser, %2u thr.: %8.2f ms  %8.1f MB/s\n", threads, threadedMs, megabytes / (threadedMs / 1000.0));
+    std::printf("speedup:            %8.1fx single, %.1fx threaded\n", streamMs / mappedMs, streamMs / threadedMs);
+
+    // Welding and vertex cache ordering, as in ImportShape::buildVertexData
+    std::vector<float> corners, vertexData;
+    std::vector<unsigned int> indexData;
+    buildCorners(parsed, corners);
+    const size_t cornerCount = corners.size() / 6;
+    Clock::time_point optimizeStart = Clock::now();
+    MeshOptimizer::weldVertices(corners, 6, vertexData, indexData);
+    const float weldedAcmr = MeshOptimizer::averageCacheMissRatio(indexData, vertexData.size() / 6);
+    MeshOptimizer::optimizeVertexCache(indexData, vertexData.size() / 6);
+    MeshOptimizer::optimizeVertexFetch(vertexData, 6, indexData);
+    const double optimizeMs = elapsedMs(optimizeStart);
+
+    std::printf("vertices:           %zu corners -> %zu welded\n", cornerCount, vertexData.size() / 6);
+    std::printf("VBO size:           %.2f MB (8-float corners) -> %.2f MB\n",
+                cornerCount * 8 * sizeof(float) / (1024.0 * 1024.0), vertexData.size() * sizeof(float) / (1024.0 * 1024.0));
+    std::printf("ACMR (FIFO %zu):     3.00 unindexed, %.2f welded, %.2f Forsyth\n", MeshOptimizer::VERTEX_CACHE_SIZE,
+                weldedAcmr, MeshOptimizer::averageCacheMissRatio(indexData, vertexData.size() / 6));
+    std::printf("weld + reorder:     %8.2f ms\n", optimizeMs);
+
+    // Quadric-error level-of-detail chain appended to the same index buffer
+    std::vector<MeshLod> lods;
+    Clock::time_point lodStart = Clock::now();
+    MeshSimplifier::buildLodChain(vertexData, 6, indexData, lods);
+    const double lodMs = elapsedMs(lodStart);
+    std::printf("LOD chain:          %8.2f ms ", lodMs);
+    for (size_t i = 0; i < lods.size(); ++i) {
+        std::printf(" %zu", lods[i].indexCount / 3);
+    }
+    std::printf(" triangles\n");
+
+    // Re-import from the binary cache: hash the mapped source, then map the blob
+    const std::string cachePath = path + ".bench.meshcache";
+    {
+        MappedFile source;
+        source.open(path);
+        MeshCache::store(cachePath, MeshCache::hashBytes(source.begin(), source.end()),
+                         vertexData, indexData, lods, glm::vec3(0.0f), glm::vec3(0.0f));
+    }
+    bool cacheHit = true;
+    const double cacheMs = bestMs(runs, [&]() {
+        MappedFile source;
+        source.open(path);
+        CachedMesh cached;
+        cacheHit = MeshCache::load(cachePath, MeshCache::hashBytes(source.begin(), source.end()), cached) &&
+                   cached.vertexFloatCount == vertexData.size() && cached.lods.size() == lods.size() &&
+                   std::memcmp(cached.vertexData, vertexData.data(), vertexData.size() * sizeof(float)) == 0;
+    });
+    std::remove(cachePath.c_str());
+
+    std::printf("mesh cache hit:     %s\n", cacheHit ? "yes" : "NO");
+    std::printf("cached re-import:   %8.2f ms  (%.1fx vs istringstream)\n", cacheMs, streamMs / cacheMs);
+
+    return identical && threadedIdentical && cacheHit ? 0 : 1;
+}
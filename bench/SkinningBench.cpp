@@ -0,0 +1,261 @@
+// CPU skinning throughput against ImportCharacter's original loop, which walked
+// every joint of each vertex's dense .attach row and multiplied the two joint
+// matrices per vertex. Then the same loop on the four strongest influences, the
+// structure-of-arrays scalar kernel, the SIMD kernel, the SIMD kernel spread
+// over the JobSystem, and skinBlocks writing corner slots as the app does.
+// Poses are random rigid transforms per joint.
+// Build and run with: make bench && ./bench/skin_bench [data/characters]
+
+#include "JobSystem.h"
+#include "ObjParser.h"
+#include "Skinning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int ITERATIONS = 500;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Best of ITERATIONS runs, which filters out scheduler noise on small meshes
+template <typename Body>
+double bestMs(const Body& body) {
+    double best = 1.0e30;
+    for (int it = 0; it < ITERATIONS; ++it) {
+        Clock::time_point start = Clock::now();
+        body();
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
+
+bool loadAttachments(const std::string& path, std::vector<std::vector<float>>& attachments,
+                     std::vector<SkinInfluences>& influences) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    std::vector<float> weights;
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        weights.clear();
+        float value;
+        while (ss >> value) {
+            weights.push_back(value);
+        }
+        attachments.push_back(weights);
+        influences.push_back(Skinning::compressAttachment(weights));
+    }
+    return true;
+}
+
+// Rotation about a random axis plus a small translation
+glm::mat4 randomRigidTransform() {
+    glm::vec3 axis(std::rand() / (float)RAND_MAX - 0.5f, std::rand() / (float)RAND_MAX - 0.5f,
+                   std::rand() / (float)RAND_MAX - 0.5f);
+    float length = std::sqrt(axis.x * axis.x + axis.y * axis.y + axis.z * axis.z);
+    axis = axis / (length > 0.0f ? length : 1.0f);
+    float angle = std::rand() / (float)RAND_MAX * 1.5f;
+    float c = std::cos(angle), s = std::sin(angle), t = 1.0f - c;
+
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(t * axis.x * axis.x + c, t * axis.x * axis.y + s * axis.z, t * axis.x * axis.z - s * axis.y, 0.0f);
+    m[1] = glm::vec4(t * axis.x * axis.y - s * axis.z, t * axis.y * axis.y + c, t * axis.y * axis.z + s * axis.x, 0.0f);
+    m[2] = glm::vec4(t * axis.x * axis.z + s * axis.y, t * axis.y * axis.z - s * axis.x, t * axis.z * axis.z + c, 0.0f);
+    m[3] = glm::vec4(std::rand() / (float)RAND_MAX * 0.2f, std::rand() / (float)RAND_MAX * 0.2f,
+                     std::rand() / (float)RAND_MAX * 0.2f, 1.0f);
+    return m;
+}
+
+// ImportCharacter's original loop: every joint with a non-zero weight in the
+// dense row, and T * B_inv formed again for each vertex
+void skinDense(const std::vector<glm::vec3>& bindVertices, const std::vector<std::vector<float>>& attachments,
+               const std::vector<glm::mat4>& jointToWorld, const std::vector<glm::mat4>& bindWorldToJoint,
+               std::vector<glm::vec3>& out) {
+    for (size_t i = 0; i < bindVertices.size(); ++i) {
+        glm::vec3 newPos(0.0f);
+
+        for (size_t j = 0; j < attachments[i].size() && j < jointToWorld.size(); ++j) {
+            float weight = attachments[i][j];
+            if (weight == 0.0f) continue;
+
+            glm::mat4 T = jointToWorld[j];
+            glm::mat4 B_inv = bindWorldToJoint[j];
+
+            glm::vec4 transformed = T * B_inv * glm::vec4(bindVertices[i], 1.0f);
+            newPos += weight * glm::vec3(transformed);
+        }
+
+        out[i] = newPos;
+    }
+}
+
+// The same loop over the four strongest influences and a precomputed palette;
+// the reference the kernels must match
+void skinReference(const std::vector<glm::vec3>& bindVertices, const std::vector<SkinInfluences>& influences,
+                   const std::vector<glm::mat4>& palette, std::vector<glm::vec3>& out) {
+    const float weightScale = 1.0f / 255.0f;
+    for (size_t i = 0; i < bindVertices.size(); ++i) {
+        const glm::vec4 bindPosition(bindVertices[i], 1.0f);
+        const SkinInfluences& influence = influences[i];
+        glm::vec3 newPos(0.0f);
+
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            float weight = influence.weights[k] * weightScale;
+            newPos += weight * glm::vec3(palette[influence.joints[k]] * bindPosition);
+        }
+
+        out[i] = newPos;
+    }
+}
+
+float maxDifference(const std::vector<glm::vec3>& reference, const std::vector<glm::vec3>& other) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        worst = std::max(worst, std::fabs(reference[i].x - other[i].x));
+        worst = std::max(worst, std::fabs(reference[i].y - other[i].y));
+        worst = std::max(worst, std::fabs(reference[i].z - other[i].z));
+    }
+    return worst;
+}
+
+// Against the reference at the face corner each slot draws
+float maxSlotDifference(const std::vector<glm::vec3>& reference, const std::vector<std::vector<int>>& faces,
+                        const SkinningBindData& bind, const std::vector<float>& slots) {
+    float worst = 0.0f;
+    for (size_t s = 0; s < bind.corners.size(); ++s) {
+        const glm::vec3& expected = reference[faces[bind.corners[s] / 3][bind.corners[s] % 3]];
+        const float* slot = &slots[s * 3];
+        worst = std::max(worst, std::fabs(expected.x - slot[0]));
+        worst = std::max(worst, std::fabs(expected.y - slot[1]));
+        worst = std::max(worst, std::fabs(expected.z - slot[2]));
+    }
+    return worst;
+}
+
+float maxDifference(const std::vector<glm::vec3>& reference, const std::vector<float>& x,
+                    const std::vector<float>& y, const std::vector<float>& z) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        worst = std::max(worst, std::fabs(reference[i].x - x[i]));
+        worst = std::max(worst, std::fabs(reference[i].y - y[i]));
+        worst = std::max(worst, std::fabs(reference[i].z - z[i]));
+    }
+    return worst;
+}
+
+void benchModel(const std::string& basePath) {
+    ObjData obj;
+    std::vector<std::vector<float>> attachments;
+    std::vector<SkinInfluences> influences;
+    if (!ObjParser::parseFile(basePath + ".obj", ObjParser::VertexOnly, obj) ||
+        !loadAttachments(basePath + ".attach", attachments, influences) || influences.size() != obj.vertices.size()) {
+        std::printf("%s: could not load mesh and attachments\n", basePath.c_str());
+        return;
+    }
+
+    // One joint per column of the attachment rows, as the skeleton would give
+    size_t jointCount = 1;
+    for (size_t i = 0; i < attachments.size(); ++i) {
+        jointCount = std::max(jointCount, attachments[i].size());
+    }
+    std::vector<glm::mat4> jointToWorld, bindWorldToJoint, palette;
+    for (size_t j = 0; j < jointCount; ++j) {
+        jointToWorld.push_back(randomRigidTransform());
+        bindWorldToJoint.push_back(randomRigidTransform());
+        palette.push_back(jointToWorld[j] * bindWorldToJoint[j]);
+    }
+
+    std::vector<std::vector<int>> faces(obj.getFaceCount());
+    for (size_t f = 0; f < faces.size(); ++f) {
+        faces[f].assign(obj.getFace(f), obj.getFace(f) + 3);
+    }
+
+    SkinningBindData bind;
+    Skinning::prepare(obj.vertices, influences, jointCount, bind);
+    Skinning::mapCorners(faces, bind);
+    std::vector<float> rows;
+    std::vector<float> x(bind.paddedCount), y(bind.paddedCount), z(bind.paddedCount);
+    std::vector<glm::vec3> dense(obj.vertices.size()), reference(obj.vertices.size());
+
+    double denseMs = bestMs([&]() { skinDense(obj.vertices, attachments, jointToWorld, bindWorldToJoint, dense); });
+
+    double referenceMs = bestMs([&]() { skinReference(obj.vertices, influences, palette, reference); });
+    float influenceError = maxDifference(dense, reference);
+
+    double scalarMs = bestMs([&]() {
+        Skinning::packPalette(palette, rows);
+        Skinning::skinRangeScalar(bind, rows.data(), 0, bind.paddedCount, x.data(), y.data(), z.data());
+    });
+    float scalarError = maxDifference(reference, x, y, z);
+
+    double simdMs = bestMs([&]() {
+        Skinning::packPalette(palette, rows);
+        Skinning::skinRange(bind, rows.data(), 0, bind.paddedCount, x.data(), y.data(), z.data());
+    });
+    float simdError = maxDifference(reference, x, y, z);
+
+    JobSystem::start();
+    double threadedMs = bestMs([&]() {
+        Skinning::packPalette(palette, rows);
+        Skinning::skin(bind, rows.data(), x.data(), y.data(), z.data());
+    });
+    float threadedError = maxDifference(reference, x, y, z);
+
+    // Every block into the corner slots, as into the mapped position buffer
+    std::vector<uint32_t> blocks(bind.paddedCount / Skinning::SIMD_WIDTH);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        blocks[b] = static_cast<uint32_t>(b);
+    }
+    std::vector<float> slots(bind.corners.size() * 3);
+    double slotsMs = bestMs([&]() {
+        Skinning::packPalette(palette, rows);
+        Skinning::skinBlocks(bind, rows.data(), blocks, slots.data());
+    });
+    float slotsError = maxSlotDifference(reference, faces, bind, slots);
+    unsigned workers = JobSystem::getWorkerCount();
+    JobSystem::shutdown();
+
+    // Speedups are against the original dense loop; errors against the top-4 loop
+    std::printf("%s: %zu vertices, %zu faces, %zu joints\n", basePath.c_str(), obj.vertices.size(), faces.size(),
+                jointCount);
+    std::printf("  original dense loop  %8.3f ms\n", denseMs);
+    std::printf("  top-4 glm loop       %8.3f ms  (%.2fx, %g from the dense weights)\n", referenceMs,
+                denseMs / referenceMs, influenceError);
+    std::printf("  SoA scalar           %8.3f ms  (%.2fx, max error %g)\n", scalarMs, denseMs / scalarMs, scalarError);
+    std::printf("  SIMD%s           %8.3f ms  (%.2fx, max error %g)\n", Skinning::hasSimd() ? " (SSE)" : " (off)",
+                simdMs, denseMs / simdMs, simdError);
+    std::printf("  SIMD, %2u workers     %8.3f ms  (%.2fx, max error %g)\n", workers, threadedMs,
+                denseMs / threadedMs, threadedError);
+    std::printf("  into corner slots    %8.3f ms  (%.2fx, max error %g)\n", slotsMs, denseMs / slotsMs,
+                slotsError);
+}
+
+}
+
+
+int main(int argc, char** argv) {
+    std::string directory = argc > 1 ? argv[1] : "data/characters";
+    std::srand(1);
+
+    const char* models[] = { "Model1", "Model2", "Model3", "Model4" };
+    for (size_t i = 0; i < sizeof(models) / sizeof(models[0]); ++i) {
+        benchModel(directory + "/" + models[i]);
+    }
+    return 0;
+}
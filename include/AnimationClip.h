@@ -0,0 +1,71 @@
+#ifndef ANIMATIONCLIP_H
+#define ANIMATIONCLIP_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Per-joint rotation keyframes. Tracks are stored back to back: the keys of
+// joint j are [trackOffsets[j], trackOffsets[j + 1]) of the key arrays, sorted
+// by time. Joints without keys are left as posed.
+class AnimationClip {
+public:
+    AnimationClip();
+
+    // Text format, one key per line: "<time> <joint> <rx> <ry> <rz>", with the
+    // rotation in Euler degrees as on the joint sliders; '#' starts a comment
+    bool loadFromFile(const std::string& path);
+
+    size_t getTrackCount() const;
+    float getDuration() const;
+    bool isEmpty() const;
+
+    const std::vector<uint32_t>& getTrackOffsets() const;
+    const std::vector<float>& getKeyTimes() const;
+    const std::vector<glm::quat>& getKeyRotations() const;
+
+    // The rotation SkeletalModel::setJointTransform builds from the same angles (X, then Y, then Z)
+    static glm::quat eulerDegreesToQuat(const glm::vec3& degrees);
+
+private:
+    std::vector<uint32_t> trackOffsets;
+    std::vector<float> keyTimes;
+    std::vector<glm::quat> keyRotations;
+    float duration;
+};
+
+// Samples many clips in one pass. Each add() queues every track of one clip
+// at one time; evaluate() finds the bracketing keys of all queued tracks,
+// then slerps them together over structure-of-arrays inputs, in chunks on
+// the job system.
+class AnimationBatch {
+public:
+    void clear();
+
+    // Queue a sample, wrapping `time` to the clip's duration; returns the index of its first track
+    size_t add(const AnimationClip& clip, float time);
+
+    void evaluate();
+
+    // Results of evaluate(), by track index
+    bool isAnimated(size_t track) const;
+    glm::quat getRotation(size_t track) const;
+
+private:
+    // Bracketing keys and blend factor per queued track
+    std::vector<float> fromX, fromY, fromZ, fromW;
+    std::vector<float> toX, toY, toZ, toW;
+    std::vector<float> blend;
+    std::vector<uint8_t> animated;
+
+    // Interpolated rotations
+    std::vector<float> rotationX, rotationY, rotationZ, rotationW;
+
+    void evaluateRange(size_t first, size_t last);
+};
+
+#endif // ANIMATIONCLIP_H
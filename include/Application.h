@@ -5,12 +5,16 @@
 #include "Renderer.h"
 #include "ShapeManager.h"
 #include "TimeStepper.h"
+#include "SimulationThread.h"
 #include "FileImporter.h"
+#include "AnimationClip.h"
 // #include "FileManager.h"
 #include "ErrorHandling.h"
 
 #include <GLFW/glfw3.h>
 
+#include <vector>
+
 class Application {
 public:
 
@@ -36,6 +40,12 @@ public:
     // Setter to replace the current TimeStepper
     static void setTimeStepper(TimeStepper* newStepper);
 
+    // Particle systems are stepped on this thread; UI edits go through its command queue
+    static SimulationThread& getSimulation();
+
+    // Imports load in the background and are added to the scene when ready
+    static FileImporter& getFileImporter();
+
     // Callback to resize viewport when window changes
     static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
@@ -50,7 +60,14 @@ private:
     static ShapeManager shapeManager;
     static FileImporter fileImporter;
     static TimeStepper* timeStepper; 
+    static SimulationThread simulation; // Declared after shapeManager so it stops before shapes are destroyed
 //    static FileManager fileManager;
+
+    // Keyframed characters, sampled together each frame
+    static AnimationBatch animationBatch;
+    static std::vector<ImportCharacter*> animatedCharacters;
+    static std::vector<size_t> animationFirstTracks; // Each character's first track in the batch
+    static double lastSimulatedTime;
     
     GLFWwindow* window;  // Handle for GLFW window
 
@@ -60,6 +77,9 @@ private:
     // Initialize ImGui settings
     void initImGui();
 
+    // Advance every character's clip by `elapsed` seconds and re-pose the ones that moved
+    static void animateCharacters(float elapsed);
+
     // File manager utilities
     void saveScene();
     void loadScene();
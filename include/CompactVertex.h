@@ -0,0 +1,53 @@
+#ifndef COMPACTVERTEX_H
+#define COMPACTVERTEX_H
+
+#include "glad/glad.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 12-byte lit vertex: position as unorm16 within the mesh AABB, normal as
+// GL_INT_2_10_10_10_REV. Color is not stored; lit draws use material.color.
+struct CompactVertex {
+    uint16_t position[3];
+    uint16_t padding;   // Keeps the normal 4-byte aligned
+    uint32_t normal;
+};
+
+// Optional compact layout for static and skinned meshes. The vertex shader
+// rebuilds positions as positionOffset + positionScale * aPosition; a zero
+// scale (the uniform default) means the mesh uses plain float positions.
+// The setting applies to buffers uploaded after it changes.
+class VertexCompression {
+public:
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+
+    // Signed normalized 10:10:10:2, w = 0
+    static uint32_t packNormal(const glm::vec3& normal);
+
+    // Quantize `count` vertices of `stride` floats (position at 0, normal at
+    // `normalOffset`) against the given bounds
+    static void compress(const float* vertices, size_t stride, size_t normalOffset, size_t count,
+                         const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                         std::vector<CompactVertex>& out);
+
+    // Decode parameters for a mesh with these bounds (scale never exactly zero)
+    static glm::vec3 getDecodeOffset(const glm::vec3& boundsMin);
+    static glm::vec3 getDecodeScale(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Attribute pointers for the bound VBO: position -> location 0, normal -> location 1
+    static void configureAttributes();
+
+    // Set the decode uniforms before a compact draw; clear them afterwards
+    static void setDecodeUniforms(GLuint shaderProgram, const glm::vec3& offset, const glm::vec3& scale);
+    static void clearDecodeUniforms(GLuint shaderProgram);
+
+private:
+    static bool enabled;
+};
+
+#endif // COMPACTVERTEX_H
@@ -0,0 +1,81 @@
+#ifndef CPUPROFILER_H
+#define CPUPROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Records named CPU scopes into a per-thread ring buffer and exports the
+// most recent ones as Chrome trace_event JSON (chrome://tracing, Perfetto).
+// The owning thread is the only writer of its ring; recording takes no locks.
+// Build with ENABLE_PROFILING to compile it in; otherwise PROFILE_SCOPE is a no-op.
+class CpuProfiler {
+public:
+    // Events kept per thread before the oldest are overwritten
+    static const size_t RING_CAPACITY = 1 << 16;
+
+    // One completed scope; name must be a string literal (stored by pointer)
+    struct Event {
+        const char* name;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    // Nanoseconds since the profiler was first used
+    static uint64_t now();
+
+    // Append a completed scope to the calling thread's ring
+    static void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    // Label the calling thread in exported traces
+    static void setThreadName(const std::string& name);
+
+    // Write every thread's events from the last `seconds` to a trace file
+    static bool writeChromeTrace(const std::string& path, double seconds);
+
+    // Write the default window to a timestamped file in the working directory
+    static void dumpRecent();
+
+    // RAII helper behind PROFILE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const char* name) : name(name), start(now()) {}
+        ~Scope() { record(name, start, now()); }
+    private:
+        const char* name;
+        uint64_t start;
+
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+
+    // Seconds of history written by dumpRecent()
+    static double dumpWindowSeconds;
+
+private:
+    // Single-producer ring owned by one thread
+    struct ThreadBuffer {
+        std::vector<Event> events;
+        std::atomic<uint64_t> writeIndex;
+        uint32_t threadId;
+        std::string threadName;
+
+        ThreadBuffer() : events(RING_CAPACITY), writeIndex(0), threadId(0) {}
+    };
+
+    // Every thread's ring, guarded by a mutex only taken on registration and export
+    static std::vector<ThreadBuffer*>* threadBuffers;
+
+    static ThreadBuffer& localBuffer();
+};
+
+#ifdef ENABLE_PROFILING
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) CpuProfiler::Scope CPU_PROFILE_CONCAT(cpuProfileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#endif // CPUPROFILER_H
@@ -0,0 +1,87 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include "AnimationClip.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// Many copies of one skinned character that share its mesh, attachments,
+// skeleton and clip. An instance only adds a placement and a playhead of
+// its own; poses are evaluated in parallel into one array of palette rows
+// that the vertex shader indexes by instance. No GL here: ImportCharacter
+// owns the buffers.
+class Crowd {
+public:
+    struct Instance {
+        glm::vec3 position;   // In the character's model space
+        float heading;        // Degrees about +Y
+        float time;           // Playhead in seconds
+        float rate;           // Playback speed
+        float phase;          // Start of the playhead as a fraction of the clip
+    };
+
+    // Cap on instances, which also bounds the palette texture buffer
+    static const size_t MAX_INSTANCES = 1024;
+
+    Crowd();
+
+    // Square grid of `count` instances `spacing` apart. Instance 0 stays at
+    // the origin in step with the character; the others get staggered
+    // phases, rates and headings so the crowd does not move in lockstep.
+    void layoutGrid(size_t count, float spacing, float clipDuration);
+
+    size_t getInstanceCount() const;
+    const std::vector<Instance>& getInstances() const;
+
+    // Move every playhead by `elapsed` seconds, each at its own rate, looping over the clip
+    void advance(float elapsed, float clipDuration);
+
+    // Put every playhead back at its phase
+    void resetPlayheads(float clipDuration);
+
+    // Shared skeleton in SkeletalModel's compiled order (getSlotJoints and
+    // getParentSlots), plus by joint index the local transform of the
+    // unanimated pose and the bind world-to-joint transform. A parent slot
+    // that does not come before its slot makes that slot a root.
+    void setSkeleton(const std::vector<int>& slotJoints, const std::vector<int>& parentSlots,
+                     const std::vector<glm::mat4>& restLocalTransforms,
+                     const std::vector<glm::mat4>& bindWorldToJoint);
+    size_t getJointCount() const;
+
+    // Queue one sample of the clip per instance; instance i's tracks start at
+    // the returned index plus i * clip.getTrackCount()
+    size_t queueAnimation(const AnimationClip& clip, AnimationBatch& batch) const;
+
+    // Pose every instance from an evaluated batch, `trackStride` tracks per instance
+    void evaluatePoses(const AnimationBatch& batch, size_t firstTrack, size_t trackStride);
+
+    // Pose every instance with one skinning palette (a character without a clip)
+    void evaluateSharedPose(const std::vector<glm::mat4>& skinningPalette);
+
+    // Rows of placement * jointToWorld * bindWorldToJoint in Skinning::packPalette's
+    // layout: instance i, joint j at [(i * getJointCount() + j) * 12, +12)
+    const std::vector<float>& getPaletteRows() const;
+
+    // Box around every instance's posed mesh, from the bind-pose box of each joint's
+    // vertices (empty boxes for joints that move none); false when nothing is posed
+    bool computeBounds(const std::vector<glm::vec3>& jointBoundsMin, const std::vector<glm::vec3>& jointBoundsMax,
+                       glm::vec3& outMin, glm::vec3& outMax) const;
+
+private:
+    std::vector<Instance> instances;
+
+    // Skeleton by slot, parents before children
+    std::vector<int> slotJoints;                // Joint index of each slot
+    std::vector<int> parentSlots;
+    std::vector<glm::mat4> restLocalTransforms;
+    std::vector<glm::mat4> bindWorldToJoint;
+
+    std::vector<float> paletteRows;
+
+    glm::mat4 getPlacement(size_t instance) const;
+};
+
+#endif // CROWD_H
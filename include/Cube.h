@@ -2,6 +2,7 @@
 #define CUBE_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -13,13 +14,15 @@
 class Cube : public Shape {
 public:
     Cube(float x, float y, float z, float scale, int colorIndex, int id);
-    ~Cube();
 
     void draw(GLuint shaderProgram) override; // Render the cube
+    bool submit(RenderQueue& queue) override;
+
+    // Builds the cube geometry for the mesh registry; also used for a skeleton's bones
+    static MeshData buildMesh(int lod);
 
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for the cube geometry
-    void setupCube();     // Initializes the VAO/VBO/EBO for the cube
+    MeshHandle mesh;                    // Geometry shared with every other Cube
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define CUSTOM_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -14,13 +15,13 @@ class Custom : public Shape {
 public:
     Custom(float x, float y, float z, float uniformScale, int colorIndex, int id,
            float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f, bool useUniformScaling = true);
-    ~Custom();
 
     void draw(GLuint shaderProgram) override; // Render the custom shape
+    bool submit(RenderQueue& queue) override;
 
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for custom geometry
-    void setupCustom();   // Initializes the VAO/VBO/EBO for the custom shape
+    MeshHandle mesh;                    // Geometry shared with every other Custom
+    static MeshData buildMesh(int lod); // Builds the custom geometry for the mesh registry
 };
 
 #endif
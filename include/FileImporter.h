@@ -30,8 +30,46 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
 #include <cctype>  // For std::toupper and std::tolower
 
+// One file import running on a background thread. The worker builds the shape
+// on the CPU; the main thread creates its GL buffers once loading has finished.
+class ImportTask {
+public:
+    ImportTask(const std::string& fileName, const std::string& shapeType);
+    ~ImportTask();
+
+    const std::string& getFileName() const { return fileName; }
+    float getProgress() const { return progress.load(std::memory_order_relaxed); }
+    bool isFinished() const { return finished.load(std::memory_order_acquire); }
+
+    // Workers poll this between stages and stop early
+    void cancel() { cancelled = true; }
+    bool isCancelled() const { return cancelled; }
+
+    void setProgress(float fraction) { progress.store(fraction, std::memory_order_relaxed); }
+
+private:
+    friend class FileImporter;
+
+    std::string fileName;
+    std::string shapeType;
+    std::atomic<float> progress;
+    std::atomic<bool> cancelled;
+    std::atomic<bool> finished;
+    std::thread worker;
+
+    Shape* result;                                // Loaded shape without GL buffers, or null on failure
+    std::function<void(Shape*)> createBuffers;    // Main-thread half of the import
+
+    ImportTask(const ImportTask&);
+    ImportTask& operator=(const ImportTask&);
+};
+
 // The FileImporter class encapsulates the logic for importing .obj, .swp, and character files.
 
 class FileImporter {
@@ -43,13 +81,35 @@ public:
     // Retrieve location of executable
     std::string getExecutableDirectory();
     
-    // Imports the .obj file and adds a new shape to the scene
+    // Ask for a file, then load it in the background; the shape is added to the
+    // scene by update() once it is ready. Returns 0 if no file was chosen.
     int importObjFile(ShapeManager& shapeManager);
     int importSwpFile(ShapeManager& shapeManager);
     int importCharacterFile(ShapeManager& shapeManager);
 
+    // Main thread, once per frame: create buffers for finished imports and add them
+    void update(ShapeManager& shapeManager);
+
+    // ImGui window with a progress bar and cancel button per running import
+    void drawProgress();
+
+    // Cancel and join every running import; call while the GL context is alive
+    void cancelAll();
+
 private:
 
+    std::vector<std::unique_ptr<ImportTask>> tasks;
+
+    // Start `load` on its own thread; `createBuffers` runs later on the main thread
+    void startImport(const std::string& fileName, const std::string& shapeType,
+                     const std::function<Shape*(ImportTask&)>& load,
+                     const std::function<void(Shape*)>& createBuffers);
+
+    // Worker-side loaders: CPU work only, no GL calls and no ShapeManager access
+    Shape* loadObjShape(const std::string& fileName, int id, ImportTask& task);
+    Shape* loadSwpShape(const std::string& fileName, int id, ImportTask& task);
+    Shape* loadCharacter(const std::string& fileName, int id, ImportTask& task);
+
     // Extracts the shape type from the file name
     std::string extractShapeType(const std::string& filename);
 	
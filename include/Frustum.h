@@ -0,0 +1,27 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside
+class Frustum {
+public:
+    Frustum();
+
+    // Extract the planes from a projection * view matrix
+    void extractPlanes(const glm::mat4& viewProjection);
+
+    // Conservative visibility tests in world space
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    bool intersectsBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) const;
+
+    // Test a local-space AABB and bounding sphere placed by a model matrix
+    bool intersectsTransformedBounds(const glm::mat4& model,
+                                     const glm::vec3& localMin, const glm::vec3& localMax,
+                                     const glm::vec3& sphereCenter, float sphereRadius) const;
+
+private:
+    glm::vec4 planes[6]; // left, right, bottom, top, near, far
+};
+
+#endif // FRUSTUM_H
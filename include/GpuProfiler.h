@@ -0,0 +1,100 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include "glad/glad.h"
+
+#include <string>
+#include <vector>
+
+// Times named, nestable zones of a frame on both the CPU and the GPU.
+// GPU times come from GL_TIMESTAMP query pairs that are read back a few frames
+// later, so reading them never stalls the pipeline.
+// Build with ENABLE_PROFILING (make PROFILING=1, the default) to compile it in;
+// otherwise the GPU_PROFILE_* macros expand to nothing.
+class GpuProfiler {
+public:
+    // Timings of one zone, as shown in the profiler panel
+    struct ZoneResult {
+        std::string name;
+        int depth;
+        double cpuMs;
+        double gpuMs;
+    };
+
+    // Number of frames in flight before a frame's queries are read back
+    static const int FRAME_LATENCY = 4;
+
+    // Frame boundaries; endFrame() must be called after the last zone closes
+    static void beginFrame();
+    static void endFrame();
+
+    // Open/close a zone; zones nest and must be closed in reverse order
+    static void beginZone(const std::string& name);
+    static void endZone();
+
+    // Per-shape zones cost two queries per shape, so they are opt-in
+    static bool isPerShapeTimingEnabled();
+
+    // Latest frame whose GPU results are complete
+    static const std::vector<ZoneResult>& getResults();
+
+    // Sortable ImGui table of the latest results
+    static void drawPanel(bool* open);
+
+    // Delete every query object
+    static void release();
+
+    // RAII helper behind GPU_PROFILE_SCOPE
+    class Scope {
+    public:
+        explicit Scope(const std::string& name) { beginZone(name); }
+        ~Scope() { endZone(); }
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+    };
+
+private:
+    // One zone recorded during a frame
+    struct Zone {
+        std::string name;
+        int depth;
+        GLuint startQuery;
+        GLuint endQuery;
+        double cpuStartMs;
+        double cpuEndMs;
+    };
+
+    // Queries and zones of one frame in flight
+    struct Frame {
+        std::vector<Zone> zones;
+        std::vector<GLuint> queryPool;
+        size_t queriesUsed = 0;
+        bool pending = false;
+    };
+
+    static Frame frames[FRAME_LATENCY];
+    static int currentFrame;
+    static std::vector<int> openZones;
+    static std::vector<ZoneResult> results;
+    static bool enabled;
+    static bool perShapeTiming;
+    static int droppedFrames;
+
+    static GLuint acquireQuery(Frame& frame);
+    static bool collect(Frame& frame);
+};
+
+#ifdef ENABLE_PROFILING
+#define GPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define GPU_PROFILE_CONCAT(a, b) GPU_PROFILE_CONCAT_INNER(a, b)
+#define GPU_PROFILE_SCOPE(name) GpuProfiler::Scope GPU_PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#define GPU_PROFILE_BEGIN_FRAME() GpuProfiler::beginFrame()
+#define GPU_PROFILE_END_FRAME() GpuProfiler::endFrame()
+#else
+#define GPU_PROFILE_SCOPE(name) ((void)0)
+#define GPU_PROFILE_BEGIN_FRAME() ((void)0)
+#define GPU_PROFILE_END_FRAME() ((void)0)
+#endif
+
+#endif // GPUPROFILER_H
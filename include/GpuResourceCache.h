@@ -0,0 +1,50 @@
+#ifndef GPURESOURCECACHE_H
+#define GPURESOURCECACHE_H
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Owns helper geometry (axes, grids, ...) that is built once and reused every frame,
+// and counts GL object allocations so per-frame churn can be reported.
+class GpuResourceCache {
+public:
+    // Interleaved position (location 0) and color (location 2) line geometry
+    struct HelperMesh {
+        GLuint VAO;
+        GLuint VBO;
+        GLenum mode;
+        GLsizei vertexCount;
+    };
+
+    GpuResourceCache();
+    ~GpuResourceCache();
+
+    // Helpers are uploaded on first use and cached afterwards
+    const HelperMesh& getAxis();
+    const HelperMesh& getGrid();
+
+    // Delete every cached helper
+    void release();
+
+    // Route glad's glGen*/glDelete* entry points through counting wrappers
+    static void installAllocationCounters();
+
+    // Per-frame allocation statistics
+    static void beginFrame();
+    static int getObjectsCreatedLastFrame();
+    static int getObjectsDeletedLastFrame();
+
+private:
+    std::map<std::string, HelperMesh> helpers;
+
+    const HelperMesh& getOrCreate(const std::string& key, GLenum mode, std::vector<float> (*buildVertices)());
+
+    static std::vector<float> buildAxisVertices();
+    static std::vector<float> buildGridVertices();
+};
+
+#endif // GPURESOURCECACHE_H
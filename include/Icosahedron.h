@@ -2,6 +2,7 @@
 #define ICOSAHEDRON_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -14,13 +15,13 @@ class Icosahedron  : public Shape {
 public:
     Icosahedron (float x, float y, float z, float uniformScale, int colorIndex, int id,
            float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f, bool useUniformScaling = true);
-    ~Icosahedron ();
 
     void draw(GLuint shaderProgram) override; // Render the icosahedron  shape
+    bool submit(RenderQueue& queue) override;
 
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for icosahedron  geometry
-    void setupIcosahedron ();   // Initializes the VAO/VBO/EBO for the icosahedron  shape
+    MeshHandle mesh;                    // Geometry shared with every other Icosahedron
+    static MeshData buildMesh(int lod); // Builds the icosahedron geometry for the mesh registry
 };
 
 #endif
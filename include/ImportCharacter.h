@@ -1,8 +1,12 @@
 #ifndef IMPORTCHARACTER_H
 #define IMPORTCHARACTER_H
 
+#include "AnimationClip.h"
+#include "Crowd.h"
+#include "MeshRegistry.h"
 #include "Shape.h"
 #include "SkeletalModel.h"
+#include "Skinning.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -29,9 +33,34 @@ public:
     const std::vector<glm::vec3>& getBindVertices() const;
     void setBindVertices(const std::vector<glm::vec3>& vertices);	
 
-    // Getters and setters for attachments
-    const std::vector<std::vector<float>>& getAttachments() const;
-    void setAttachments(const std::vector<std::vector<float>>& attachments);
+    // Getters and setters for the compressed attachments
+    const std::vector<SkinInfluences>& getInfluences() const;
+    void setInfluences(const std::vector<SkinInfluences>& influences);
+
+    // Keyframe playback. Application samples the clips of all characters in
+    // one AnimationBatch whenever the simulation advances.
+    void setAnimationClip(const AnimationClip& clip);
+    const AnimationClip& getAnimationClip() const;
+    bool hasAnimationClip() const;
+    float getAnimationTime() const;
+    void resetAnimation();
+
+    // Move the playhead by `elapsed` seconds; true when the pose must be re-sampled
+    bool advanceAnimation(float elapsed);
+
+    // Queue this character's samples: its own pose, then one per crowd
+    // instance; returns the first track for applyAnimationPose
+    size_t queueAnimation(AnimationBatch& batch) const;
+
+    // Pose the skeleton, and the crowd, from the tracks queueAnimation returned
+    void applyAnimationPose(const AnimationBatch& batch, size_t firstTrack);
+
+    // Crowd mode: `count` copies of this character that share its mesh,
+    // attachments and skeleton, drawn with one instanced call. Needs GPU
+    // skinning; a count of 1 is just the character.
+    void setCrowd(size_t count, float spacing);
+    size_t getCrowdSize() const;
+    float getCrowdSpacing() const;
 
     // Getter and setter for display mode
     DisplayMode getDisplayMode() const;
@@ -41,43 +70,126 @@ public:
     void updateMeshVertices(); 
     void resetPose();
 
+    // Skin in the vertex shader: the bind pose and influences are uploaded once
+    // and only the joint palette is streamed each frame. Falls back to CPU
+    // skinning when disabled, when the influences do not match the mesh or
+    // when the SKINNED shader variant is missing.
+    static bool isGpuSkinningEnabled();
+    static void setGpuSkinningEnabled(bool enabled);
+
+    // SKINNED variant of the scene shader; only it declares the palette, so
+    // other geometry never runs with an unbound SkinningPalette block
+    static void setSkinnedShaderProgram(GLuint program);
+
+    // Uniform-buffer binding point and capacity of the shader's SkinningPalette block
+    static const GLuint SKINNING_PALETTE_BINDING = 0;
+    static const size_t MAX_SKIN_JOINTS = 256;
+
+    // Texture unit of the crowd's palette texture buffer (ImGui uses unit 0)
+    static const GLuint CROWD_PALETTE_TEXTURE_UNIT = 1;
+
     void setupMeshBuffer();    
-    void setupJointBuffer();    
-    void setupBoneBuffer();    
+    void setupSkeletonMeshes();
 
 
     void draw(GLuint shaderProgram) override;
 
-private:
+    // The GL-free half of updateMeshVertices: pose the skeleton and the crowd
+    // and refit the culling bounds. The renderer calls it before culling, so a
+    // culled character whose pose or crowd changes is still refit.
+    void updateBounds() override;
 
-    // Generate Sphere for Joint
-    void generateSphere(float radius, glm::vec3 centerJoint,
-                         std::vector<glm::vec3>& outVertices,
-                         std::vector<glm::vec3>& outNormals,
-                         std::vector<glm::uvec3>& outFaces);
+    // Skeletal mode queues one shared sphere per joint and one shared cube
+    // per bone, which the render queue batches into instanced draws
+    bool submit(RenderQueue& queue) override;
 
-    // Generate Cuboid for Bone
-    void generateCuboid(const glm::vec3& parentPos, const glm::vec3& childPos,
-                         std::vector<glm::vec3>& boneVertices, std::vector<glm::vec3>& boneNormals,
-                         std::vector<glm::uvec3>& boneFaces);
+private:
+
+    // Marker radius of a joint and width of a bone, in model units
+    static const float JOINT_RADIUS;
+    static const float BONE_WIDTH;
 
     // Current vertex positions after animation
     std::vector<glm::vec3> bindVertices; // Initial vertex positions
 
-    // List of vertex to joint attachments
-    // each element of attachments is a vector< float > containing
-    // one attachment weight per joint
-    std::vector<std::vector<float>> attachments; // Attachment weights
+    // Vertex to joint attachments, one fixed-size entry per bind vertex
+    std::vector<SkinInfluences> influences;
+
+    // currentJointToWorld * bindWorldToJoint for each joint, refreshed for the moved joints
+    std::vector<glm::mat4> skinningPalette;
+    void updateSkinningPalette(const std::vector<int>& joints);
+
+    // What meshVAO holds
+    enum MeshBufferMode {
+        MESH_POSED,         // Posed positions, rebuilt whenever they change
+        MESH_STREAMED,      // Static normals and colors plus a position stream skinned on the CPU
+        MESH_GPU_SKINNED    // The bind pose plus influences, skinned in the vertex shader
+    };
+    MeshBufferMode meshMode;
+
+    // GPU skinning state
+    static bool gpuSkinning;
+    static GLuint skinnedShaderProgram;
+    GLuint meshInfluenceVBO;
+    GLuint paletteUBO;
+    std::vector<glm::vec3> jointBoundsMin, jointBoundsMax; // Bind-pose box of each joint's vertices
+
+    // CPU skinning state
+    GLuint meshPositionVBO;         // One float3 per corner slot, skinned into in place
+    bool streamedPositionsLost;     // meshPositionVBO needs every block re-skinned
+    SkinningBindData skinningBind;
+    std::vector<float> skinningRows;
+    std::vector<uint32_t> skinnedBlocks;    // Blocks re-skinned this pose
+
+    // Joints whose palette entries changed since updateMeshVertices last uploaded them
+    std::vector<int> movedJoints;
+    bool skeletonInstancesStale;    // Joint and bone markers lag the pose
+    void updatePose();
+    void markAllJointsMoved();
+
+    bool canSkinOnGpu() const;
+    void buildMeshBuffer(const std::vector<glm::vec3>& positions, MeshBufferMode mode);
+    void writeSkinnedPositions();
+    void uploadSkinningPalette();
+    void computeJointBounds();
+    void fitPosedBounds();
+
+    // Skeletal display: the unit sphere and cube from MeshRegistry, placed
+    // per joint and per bone in model space
+    struct SkeletonInstance {
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+    };
+    MeshHandle jointMesh, boneMesh;
+    std::vector<SkeletonInstance> jointInstances, boneInstances;
+    void updateSkeletonInstances();
 
     SkeletalModel m_skeletalModel;  // Directly owned skeletal model
+
+    AnimationClip animationClip;
+    float animationTime;
+    bool animationPending;          // Clip or playhead moved since the pose was last sampled
+
+    // Crowd state: every instance's palette rows live in one texture buffer
+    Crowd crowd;
+    float crowdSpacing;
+    bool crowdPoseStale;            // Layout or shared pose changed since the instances were posed
+    bool crowdPaletteStale;         // Posed rows not uploaded yet
+    bool boundsStale;               // Culling bounds lag the pose
+    bool boundsCoverCrowd;          // Culling bounds were fit around the crowd
+    GLuint crowdPaletteBuffer, crowdPaletteTexture;
+    GLsizei crowdDrawCount;         // Instances the palette buffer holds
+
+    bool isCrowd() const;
+    bool isCrowdDrawn() const;
+    void snapshotCrowdSkeleton();
+    void uploadCrowdPalette();
 	
     DisplayMode displayMode = MESH;  // Default to skeletal mode
 
     GLuint meshVAO, meshVBO, meshEBO;
-    GLuint jointVAO, jointVBO, jointEBO;
-    GLuint boneVAO, boneVBO, boneEBO;
-
-    float jointIndexCount, boneIndexCount;
+    bool meshCompact;                       // Mesh buffer uploaded as CompactVertex
+    glm::vec3 meshDecodeOffset, meshDecodeScale;
 };
 
 #endif // IMPORTCHARACTER_H
@@ -66,9 +66,14 @@ private:
     GLuint curveVAO, curveVBO;
     GLuint vectorVAO, vectorVBO;    
     GLuint surfaceVAO, surfaceVBO, surfaceEBO;
+    bool surfaceCompact;                    // Surface buffer uploaded as CompactVertex
+    glm::vec3 surfaceDecodeOffset, surfaceDecodeScale;
     GLuint wireframeVAO, wireframeVBO;    
     GLuint normalVAO, normalVBO;    
 
+    // Fit the local bounds around control points, curve points and surface vertices
+    void fitBounds();
+
 };
 
 #endif // IMPORTCURVE_H
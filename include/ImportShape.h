@@ -2,6 +2,9 @@
 #define IMPORTSHAPE_H
 
 #include "Shape.h"
+#include "MeshCache.h"
+#include "CompactVertex.h"
+#include "MeshSimplifier.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -11,6 +14,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <memory>
 
 class ImportShape : public Shape {
 public:
@@ -18,12 +22,43 @@ public:
     ~ImportShape();
 
     void draw(GLuint shaderProgram) override;
+    bool submit(RenderQueue& queue) override;
+    void selectLod(float projectedRadius) override;
     void setupShape();
+
+    // Floats per vertex in the GPU buffer: position, normal
+    static const size_t VERTEX_STRIDE = 6;
+
+    // Coarsest level whose error projects below this many pixels is drawn;
+    // coarsening waits until the error is below LOD_HYSTERESIS times that
+    static const float LOD_PIXEL_ERROR;
+    static const float LOD_HYSTERESIS;
+
+    // Weld the faces into an indexed, cache-ordered vertex buffer and build the
+    // level-of-detail chain (CPU only, any thread)
+    void buildVertexData();
+    const std::vector<float>& getVertexData() const { return vertexData; }
+    const std::vector<unsigned int>& getIndexData() const { return indexData; }
+    const std::vector<MeshLod>& getLods() const { return lods; }
+    size_t getCurrentLod() const { return currentLod; }
+
+    // Upload a mapped cache blob in setupShape instead of the face lists
+    void setCachedMesh(std::unique_ptr<CachedMesh> mesh);
+
+    // Faces as ObjParser reads them: {v0, n0, v1, n1, v2, n2} per face in one array
+    void setFaceIndices(std::vector<int>&& indices);
     
  private:
     GLuint VAO, VBO, EBO;
+    GLsizei indexCount;
+    bool compact;                   // Uploaded as CompactVertex
+    glm::vec3 decodeOffset, decodeScale;
+    std::vector<int> faceIndices;
     std::vector<float> vertexData;
     std::vector<unsigned int> indexData;   
+    std::vector<MeshLod> lods;             // Ranges of the element buffer, full detail first
+    size_t currentLod;
+    std::unique_ptr<CachedMesh> cachedMesh; // Released once uploaded
 };
 
 #endif
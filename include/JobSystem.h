@@ -0,0 +1,78 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Work-stealing task scheduler shared by every subsystem.
+// Each worker owns a deque: it pushes and pops its own jobs at the back and
+// steals from the front of the others when it runs dry. Threads that are not
+// workers (main, simulation, import) submit through a shared injection queue.
+// Waiting only ever runs the waiter's own work: parallelFor callers claim
+// chunks of their own range, and only workers run queued jobs in wait(), so
+// the main thread never picks up another thread's chunks (an import's parse).
+// Until start() is called every job runs inline on the calling thread.
+class JobSystem {
+private:
+    struct Task;
+
+public:
+    // Completion state of a job; also used to express dependencies
+    class JobState {
+    public:
+        bool isFinished() const { return finished.load(std::memory_order_acquire); }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<bool> finished;
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Task>> dependents; // Jobs waiting on this one
+
+        JobState() : finished(false) {}
+    };
+    typedef std::shared_ptr<JobState> JobHandle;
+
+    // Start `workerCount` workers (0 = one per core, minus the calling thread)
+    static void start(unsigned workerCount = 0);
+    static void shutdown();
+    static unsigned getWorkerCount();
+
+    // Schedule a job once every dependency has finished
+    static JobHandle run(const std::function<void()>& job);
+    static JobHandle run(const std::function<void()>& job, const std::vector<JobHandle>& dependencies);
+
+    // Block until the job has finished; workers run other jobs meanwhile
+    static void wait(const JobHandle& handle);
+
+    // Call body(begin, end) over [first, last) in chunks of at most `grainSize`,
+    // returning when every chunk is done. The caller and up to one helper job
+    // per worker claim chunks from a shared counter, so the caller only runs
+    // chunks of this range. A range within one grain runs inline.
+    static void parallelFor(size_t first, size_t last, size_t grainSize,
+                            const std::function<void(size_t, size_t)>& body);
+
+private:
+    // A job and the number of dependencies it still waits for
+    struct Task {
+        std::function<void()> function;
+        JobHandle state;
+        std::atomic<int> unresolved;
+
+        Task() : unresolved(0) {}
+    };
+
+    // Worker threads and their queues; null until start()
+    struct Scheduler;
+    static Scheduler* scheduler;
+
+    static void schedule(const std::shared_ptr<Task>& task);
+    static void execute(const std::shared_ptr<Task>& task);
+    static bool runOne();
+};
+
+#endif // JOBSYSTEM_H
@@ -20,12 +20,6 @@ public:
     glm::mat4 getTransform() const;
     void setTransform(const glm::mat4& newTransform);
 
-    glm::mat4 getBindWorldToJointTransform() const;
-    void setBindWorldToJointTransform(const glm::mat4& newTransform);
-
-    glm::mat4 getCurrentJointToWorldTransform() const;
-    void setCurrentJointToWorldTransform(const glm::mat4& newTransform);
-
     // Getter and setter for rotation
     glm::vec3 getRotation() const;
     void setRotation(const glm::vec3& newRotation);
@@ -41,8 +35,7 @@ private:
     glm::mat4 transform; // Transform relative to its parent
     std::vector<Joint*> children; // List of children
 
-    glm::mat4 bindWorldToJointTransform; // Maps world space to joint space in bind position
-    glm::mat4 currentJointToWorldTransform; // Maps joint space to world space in current pose
+    // World-space transforms live in SkeletalModel's compiled arrays
 
 };
 
@@ -0,0 +1,79 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include "ObjParser.h"
+#include "MeshSimplifier.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A cached mesh mapped from disk, pointing straight into the mapping so the
+// buffers can be handed to glBufferData without a copy
+struct CachedMesh {
+    MappedFile file;
+    const float* vertexData;        // Interleaved position, normal (MeshCache::VERTEX_FLOATS floats)
+    size_t vertexFloatCount;
+    const unsigned int* indexData;
+    size_t indexCount;
+    std::vector<MeshLod> lods;      // Ranges of indexData, full detail first
+    glm::vec3 boundsMin, boundsMax;
+
+    CachedMesh() : vertexData(nullptr), vertexFloatCount(0), indexData(nullptr), indexCount(0),
+                   boundsMin(0.0f), boundsMax(0.0f) {}
+};
+
+// Binary blobs of imported OBJ meshes, stored next to the source as
+// "<file>.meshcache". A blob holds the welded vertex buffer ready for
+// ImportShape::setupShape, the cache-ordered indices of every level of detail,
+// the level table, the bounds, and a hash of the source
+// text; a changed source or layout version makes the blob stale and it is
+// rebuilt on the next import. Blobs use native byte order.
+class MeshCache {
+public:
+    // Bump whenever the blob layout or the vertex format changes
+    static const uint32_t VERSION = 3;
+
+    // Floats per stored vertex; ImportShape::VERTEX_STRIDE must match
+    static const size_t VERTEX_FLOATS = 6;
+
+    static std::string getCachePath(const std::string& sourcePath);
+
+    // 64-bit hash of the source bytes, a machine word at a time
+    static uint64_t hashBytes(const char* begin, const char* end);
+
+    // Map a blob; false if it is missing, damaged, stale or from another version.
+    // Every index is checked against the vertex count, so a corrupted blob
+    // never reaches glDrawElements.
+    static bool load(const std::string& cachePath, uint64_t sourceHash, CachedMesh& out);
+
+    // Write a blob through a temporary file so readers never see a partial one
+    static bool store(const std::string& cachePath, uint64_t sourceHash,
+                      const std::vector<float>& vertexData, const std::vector<unsigned int>& indexData,
+                      const std::vector<MeshLod>& lods, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t sourceHash;
+        uint64_t vertexFloatCount;
+        uint64_t indexCount;
+        uint32_t lodCount;
+        uint32_t reserved;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    // Level table entry, stored after the indices
+    struct LodEntry {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        float error;
+    };
+};
+
+#endif // MESHCACHE_H
@@ -0,0 +1,32 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+// Index-buffer preparation for static meshes: welding, post-transform vertex
+// cache ordering (Forsyth's linear-speed algorithm) and vertex fetch ordering.
+// Vertices are flat float arrays of `stride` floats each; indices are triangles.
+class MeshOptimizer {
+public:
+    // Cache size the triangle order is tuned for; larger hardware caches still benefit
+    static const size_t VERTEX_CACHE_SIZE = 32;
+
+    // Merge bitwise-identical vertices of an unindexed stream into a unique
+    // vertex table and an index buffer referencing it
+    static void weldVertices(const std::vector<float>& corners, size_t stride,
+                             std::vector<float>& vertices, std::vector<unsigned int>& indices);
+
+    // Reorder triangles so consecutive ones reuse recently transformed vertices
+    static void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+
+    // Renumber vertices in order of first use so fetches walk the buffer forward
+    static void optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+                                    std::vector<unsigned int>& indices);
+
+    // Transformed vertices per triangle for a FIFO cache of `cacheSize` (0.5 is ideal, 3 is no reuse)
+    static float averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                       size_t cacheSize = VERTEX_CACHE_SIZE);
+};
+
+#endif // MESHOPTIMIZER_H
@@ -0,0 +1,57 @@
+#ifndef MESHREGISTRY_H
+#define MESHREGISTRY_H
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// CPU-side geometry produced by a primitive builder: interleaved position + normal, indexed triangles
+struct MeshData {
+    std::vector<float> vertexData;
+    std::vector<unsigned int> indexData;
+
+    void addVertex(const glm::vec3& position, const glm::vec3& normal);
+};
+
+// Uploaded geometry shared by every shape that uses the same primitive and LOD
+struct Mesh {
+    GLuint VAO, VBO, EBO;
+    GLsizei indexCount;
+    glm::vec3 boundsMin, boundsMax; // Local-space AABB of the vertex positions
+
+    Mesh();
+    ~Mesh(); // Frees the GL objects once the last shape releases its handle
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+};
+
+typedef std::shared_ptr<Mesh> MeshHandle;
+
+// Reference-counted cache of primitive meshes keyed by primitive type and LOD
+class MeshRegistry {
+public:
+    typedef MeshData (*MeshBuilder)(int lod);
+
+    // Return the shared mesh for (primitiveType, lod), building and uploading it on first use
+    static MeshHandle acquire(const std::string& primitiveType, int lod, MeshBuilder builder);
+
+    // Number of meshes currently alive in the registry
+    static int getLiveMeshCount();
+
+private:
+    typedef std::pair<std::string, int> MeshKey;
+
+    static std::map<MeshKey, std::weak_ptr<Mesh>> meshes;
+
+    static MeshHandle upload(const MeshData& data);
+};
+
+#endif // MESHREGISTRY_H
@@ -0,0 +1,43 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+// One level of detail: a range of a shared index buffer and the geometric
+// error of that range against the full mesh, in mesh units
+struct MeshLod {
+    size_t firstIndex;
+    size_t indexCount;
+    float error;
+};
+
+// Quadric error metric (Garland-Heckbert) edge-collapse simplifier. Collapses
+// move a vertex onto a neighbour instead of to an optimal position, so only
+// the indices change and every level of detail shares one vertex buffer.
+// Vertices are flat float arrays of `stride` floats, position first; the
+// remaining floats (normals) pick among vertices split along seams.
+class MeshSimplifier {
+public:
+    // Most levels built per mesh, including the full-detail one
+    static const size_t MAX_LOD_COUNT = 6;
+
+    // Each level aims for this fraction of the previous level's triangles
+    static const float LOD_REDUCTION;
+
+    // Coarser levels are not built below this many triangles
+    static const size_t MIN_LOD_TRIANGLES = 128;
+
+    // Collapse edges, cheapest first, until at most `targetIndexCount` indices
+    // remain or no collapse is left. Returns the largest collapse error as a distance.
+    static float simplify(const std::vector<float>& vertices, size_t stride,
+                          const std::vector<unsigned int>& indices, size_t targetIndexCount,
+                          std::vector<unsigned int>& out);
+
+    // Treat `indices` as level 0, append progressively coarser levels to it
+    // (each ordered for the vertex cache) and describe every level in `lods`
+    static void buildLodChain(const std::vector<float>& vertices, size_t stride,
+                              std::vector<unsigned int>& indices, std::vector<MeshLod>& lods);
+};
+
+#endif // MESHSIMPLIFIER_H
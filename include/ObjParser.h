@@ -0,0 +1,80 @@
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Geometry read from an OBJ file. Faces share one flat index array so the
+// parser allocates nothing per face; face i starts at i * faceStride.
+struct ObjData {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<int> faceIndices;   // Zero-based indices, see ObjParser::FaceFormat
+    size_t faceStride;              // Indices per face: 6 for VertexNormalPairs, 3 for VertexOnly
+
+    ObjData() : faceStride(0) {}
+
+    size_t getFaceCount() const { return faceStride ? faceIndices.size() / faceStride : 0; }
+    const int* getFace(size_t i) const { return &faceIndices[i * faceStride]; }
+};
+
+// Read-only view of a whole file, memory-mapped where possible
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+    size_t getSize() const { return size; }
+
+private:
+    const char* data;
+    size_t size;
+    bool mapped;                  // false when the contents live in `fallback`
+    std::vector<char> fallback;   // Used for empty files or when mmap is unavailable
+
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+};
+
+// Zero-copy OBJ parser: scans the mapped file with pointer arithmetic and
+// hand-rolled number parsing, after a counting pass that sizes every array.
+// Large files are split at newline boundaries and parsed on the JobSystem;
+// prefix sums of the per-chunk counts place each chunk's output and resolve
+// relative (negative) indices against the whole file.
+// Only v, vn and the first three corners of each f line are read, matching
+// what the importers have always used.
+class ObjParser {
+public:
+    enum FaceFormat {
+        VertexNormalPairs, // {v0, n0, v1, n1, v2, n2} from "v/t/n" corners
+        VertexOnly         // {v0, v1, v2}
+    };
+
+    // Called with the fraction done after each chunk, possibly from several
+    // threads at once; returning false cancels the remaining chunks
+    typedef std::function<bool(float)> ProgressCallback;
+
+    // Parse a file from disk; false if it cannot be opened or was cancelled
+    static bool parseFile(const std::string& path, FaceFormat format, ObjData& out,
+                          const ProgressCallback& progress = ProgressCallback());
+
+    // Parse an in-memory OBJ buffer, appending to `out` (in the same format
+    // as any faces it already holds); false if cancelled
+    static bool parseBuffer(const char* begin, const char* end, FaceFormat format, ObjData& out,
+                            const ProgressCallback& progress = ProgressCallback());
+
+    // Number parsers; advance `p` past the number (exposed for the benchmark)
+    static float parseFloat(const char*& p, const char* end);
+    static int parseInt(const char*& p, const char* end);
+};
+
+#endif // OBJPARSER_H
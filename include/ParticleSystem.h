@@ -26,9 +26,13 @@ public:
     // Reset the particle system to its initial state
     virtual void reset();
 
+    // Refit the culling bounds around the current particle positions
+    void updateBounds() override;
+
     // Getters and setters for particle states
     std::vector<glm::vec3> getState() const;
     void setState(const std::vector<glm::vec3>& newState);
+    const std::vector<glm::vec3>& getInitialState() const;
     
 
 protected:
@@ -2,6 +2,7 @@
 #define PYRAMID_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -14,13 +15,13 @@ class Pyramid : public Shape {
 public:
     Pyramid(float x, float y, float z, float uniformScale, int colorIndex, int id,
             float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f, bool useUniformScaling = true);
-    ~Pyramid();
     
     void draw(GLuint shaderProgram) override; // Render the pyramid
+    bool submit(RenderQueue& queue) override;
     
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for pyramid geometry
-    void setupPyramid();  // Initializes the VAO/VBO/EBO for the pyramid    
+    MeshHandle mesh;                    // Geometry shared with every other Pyramid
+    static MeshData buildMesh(int lod); // Builds the pyramid geometry for the mesh registry
 };
 
 #endif
@@ -0,0 +1,82 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+
+// One lit, indexed draw collected from a shape
+struct DrawItem {
+    GLuint VAO;
+    GLsizei firstIndex;       // Offset into the element buffer (levels of detail share one)
+    GLsizei indexCount;
+    glm::vec3 color;
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+    glm::vec3 positionOffset; // Compact-vertex decode; zero scale for float meshes
+    glm::vec3 positionScale;
+};
+
+// Collects draw items for a frame, sorts them by mesh and material, and submits them
+// with as few state changes as possible. Items that share a mesh become one instanced draw.
+class RenderQueue {
+public:
+    // Per-instance attribute locations used by the INSTANCED shader variant
+    static const GLuint INSTANCE_MODEL_LOCATION = 5;         // mat4 uses locations 5-8
+    static const GLuint INSTANCE_NORMAL_MATRIX_LOCATION = 9; // mat3 uses locations 9-11
+    static const GLuint INSTANCE_COLOR_LOCATION = 12;
+
+    // Floats per instance: mat4 model, mat3 normal matrix, vec3 color
+    static const int INSTANCE_STRIDE = 16 + 9 + 3;
+
+    RenderQueue();
+    ~RenderQueue();
+
+    // Drop the items of the previous frame
+    void clear();
+
+    // Queue a draw for this frame; meshes in the compact layout pass their decode parameters
+    void submit(GLuint VAO, GLsizei indexCount, const glm::vec3& color,
+                const glm::mat4& model, const glm::mat3& normalMatrix,
+                const glm::vec3& positionOffset = glm::vec3(0.0f), const glm::vec3& positionScale = glm::vec3(0.0f));
+
+    // Queue a draw of part of the element buffer, starting at `firstIndex`
+    void submitRange(GLuint VAO, GLsizei firstIndex, GLsizei indexCount, const glm::vec3& color,
+                     const glm::mat4& model, const glm::mat3& normalMatrix,
+                     const glm::vec3& positionOffset, const glm::vec3& positionScale);
+
+    // Sort and issue every queued draw (single draws use shaderProgram, batches use instancedProgram)
+    void flush(GLuint shaderProgram, GLuint instancedProgram);
+
+    // Statistics from the last flush
+    int getItemCount() const;
+    int getDrawCallCount() const;
+    int getInstancedBatchCount() const;
+    int getTriangleCount() const;
+
+private:
+    std::vector<DrawItem> items;
+    std::vector<float> instanceData;
+    GLuint instanceVBO;
+    GLsizeiptr instanceCapacity;
+
+    int drawCallCount;
+    int instancedBatchCount;
+    int triangleCount;
+
+    // Regular program state tracked during a flush
+    GLint modelLoc, normalMatrixLoc, colorLoc;
+    glm::vec3 lastColor;
+
+    void drawSingles(GLuint shaderProgram, size_t begin, size_t end);
+    void drawInstanced(GLuint instancedProgram, size_t begin, size_t end);
+    void bindInstanceAttributes(size_t firstInstance);
+    void unbindInstanceAttributes();
+};
+
+#endif // RENDERQUEUE_H
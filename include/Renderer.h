@@ -9,6 +9,7 @@
 #include "imgui_impl_opengl3.h"
 
 #include <vector>
+#include <map>
 #include <algorithm>  // For std::find
 
 #include "Globals.h"
@@ -27,6 +28,11 @@
 #include "SimpleChain.h"
 #include "SimpleCloth.h"
 #include "FileImporter.h"
+#include "GpuResourceCache.h"
+#include "RenderQueue.h"
+#include "Frustum.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
 
 class Renderer {
 public:
@@ -35,12 +41,22 @@ public:
     // Shader utilities
     GLuint getShaderProgram() const;
     void setShaderProgram(GLuint shader);
+    GLuint getInstancedShaderProgram() const;
+    void setInstancedShaderProgram(GLuint shader);
+    GLuint getSkinnedShaderProgram() const;
+    void setSkinnedShaderProgram(GLuint shader);
 
     // Public methods for controlling the rendering pipeline
     void setupLighting(GLuint shaderProg);
     void drawAxis(GLuint shaderProgram);
+    void drawGrid(GLuint shaderProgram);
     void renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper);
 
+    // Render thread: capture a particle system's settings before the simulation
+    // thread owns it, and drop them once it has been removed
+    void trackParticleSystem(ParticleSystem* system);
+    void forgetParticleSystem(ParticleSystem* system);
+
 
 private:
     // Camera and transformation variables
@@ -60,10 +76,49 @@ private:
     
     // Boolean variable to track axis visibility
     bool showAxis = true;
+    bool showGrid = false;
+    bool showRenderStats = false;
+    bool showProfiler = false;
+
+    // Helper geometry (axis, grid) uploaded once and reused every frame
+    GpuResourceCache resourceCache;
+
+    void drawHelper(GLuint shaderProgram, const GpuResourceCache::HelperMesh& mesh);
+    void drawRenderStats();
+    void drawShape(Shape& shape);
 
     IntegratorType selectedIntegrator;
 
     GLuint shaderProgram; // Holds the active shader program
+    GLuint instancedShaderProgram; // INSTANCED variant of the same shader sources
+    GLuint skinnedShaderProgram;   // SKINNED variant, used by GPU-skinned characters
+
+    // Draw items collected from the shapes each frame
+    RenderQueue renderQueue;
+
+    // View-frustum culling against projection * view
+    Frustum frustum;
+    bool frustumCulling = true;
+    int culledShapeCount = 0;
+    int consideredShapeCount = 0;
+
+    bool isShapeVisible(const Shape& shape) const;
+
+    // Render-side copies of the settings evalF reads. The UI edits these and
+    // sends every change through SimulationThread::enqueue(), so the render
+    // thread never reads fields the simulation thread writes.
+    struct ParticleControls {
+        float mass;
+        bool movement;
+        bool wind;
+        int windDirection;      // Index into the Wind Direction combo; cloths start at +X
+        float windIntensity;
+    };
+    std::map<const ParticleSystem*, ParticleControls> particleControls;
+
+    // Distance-based level of detail from the projected bounding sphere
+    bool levelOfDetail = true;
+    float getProjectedRadius(const Shape& shape, const glm::mat4& projection, int viewportHeight) const;
 
 };
 
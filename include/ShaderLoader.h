@@ -3,10 +3,19 @@
 
 #include "glad/glad.h"
 
+#include <string>
+
 class ShaderLoader {
 public:
     // Load and compile shaders from files
     static GLuint loadShaderFromFile(const char* vertexPath, const char* fragmentPath);
+
+    // Load a variant of the same sources; defines (e.g. "#define INSTANCED\n") are inserted after #version
+    static GLuint loadShaderFromFile(const char* vertexPath, const char* fragmentPath, const std::string& defines);
+
+private:
+    // Insert preprocessor defines right after the #version line of a shader source
+    static std::string injectDefines(const std::string& source, const std::string& defines);
 };
 
 #endif // SHADERLOADER_H
@@ -13,6 +13,7 @@
 #include <string>
 #include "ColorPresets.h"
 #include "Globals.h"
+#include "RenderQueue.h"
 
 class Shape {
 
@@ -23,6 +24,9 @@ public:
 
     virtual void draw(GLuint shaderProgram) = 0;
 
+    // Queue the shape for batched rendering; shapes that return false are drawn immediately
+    virtual bool submit(RenderQueue& queue);
+
     // Transformation-related methods
     void setRotation(float ax, float ay, float az);
     void rotate(float dAngleX, float dAngleY, float dAngleZ);
@@ -32,7 +36,7 @@ public:
     void setScale(float sx, float sy, float sz); // Non-uniform scale
     void useUniformScaling(bool flag); // Toggle scaling mode
 
-    // Apply transformations using shaders
+    // Apply transformations using shaders (uploads model and normal matrices)
     void applyTransform(GLuint shaderProgram) const;
 
     // Color-related methods
@@ -41,6 +45,8 @@ public:
 
     // Calculate normal values
     void calculateNormals();
+    static std::vector<glm::vec3> calculateFaceNormals(const std::vector<glm::vec3>& vertices,
+                                                       const std::vector<std::vector<int>>& faces);
     
     // Getter methods
     float getX() const;
@@ -57,6 +63,7 @@ public:
 
     int getColorIndex() const;
     const float* getCustomColor() const;
+    glm::vec3 getMaterialColor() const;
     int getId() const;
     std::string getShapeType() const;
 
@@ -83,6 +90,26 @@ public:
     // Reset to default values
     void resetToDefault();
 
+    // Transformation matrices (cached, see updateTransformCache)
+    const glm::mat4& getModelMatrix() const;
+    const glm::mat3& getNormalMatrix() const;
+
+    // Local-space bounding volumes used for frustum culling
+    void setLocalBounds(const glm::vec3& minCorner, const glm::vec3& maxCorner);
+    void computeLocalBounds(const std::vector<glm::vec3>& points);
+    bool hasBounds() const;
+    const glm::vec3& getLocalBoundsMin() const;
+    const glm::vec3& getLocalBoundsMax() const;
+    const glm::vec3& getBoundingSphereCenter() const;
+    float getBoundingSphereRadius() const;
+
+    // Refit the bounds from data that changes every frame (no-op for static shapes)
+    virtual void updateBounds() {}
+
+    // Pick a level of detail from the bounding sphere's projected radius in pixels
+    // (no-op for shapes with a single level)
+    virtual void selectLod(float projectedRadius) {}
+
 
 protected:
     float x, y, z;
@@ -95,14 +122,17 @@ protected:
     int id;
     std::string shapeType;
 
-    // Transformation helpers
-    glm::mat4 getModelMatrix() const;
-
     // Vertices, normals, and faces
     std::vector<glm::vec3> vertices;
     std::vector<glm::vec3> normals;
     std::vector<std::vector<int>> faces;
 
+    // Local-space AABB and enclosing sphere; shapes without bounds are never culled
+    glm::vec3 localBoundsMin, localBoundsMax;
+    glm::vec3 boundingSphereCenter;
+    float boundingSphereRadius;
+    bool boundsValid;
+
 private:
 
     // Default values for reset
@@ -113,6 +143,13 @@ private:
     float defaultRotationX, defaultRotationY, defaultRotationZ;
     int defaultColorIndex;
     float defaultCustomColor[3];  // For custom color if used    
+
+    // Cached model and normal matrices, rebuilt only after a transform setter runs
+    mutable glm::mat4 cachedModelMatrix;
+    mutable glm::mat3 cachedNormalMatrix;
+    mutable bool transformDirty;
+
+    void updateTransformCache() const;
     
 };
 
@@ -2,6 +2,7 @@
 #define SHAPEMANAGER_H
 
 #include <vector>
+#include <functional>
 #include "Shape.h"
 #include "ParticleSystem.h"
 
@@ -44,10 +45,16 @@ public:
 	//Reset all shapes to default
 	void resetAllShapes();
 
+	// Callbacks run after a shape is added and before one is deleted
+	void setShapeListeners(const std::function<void(Shape*)>& onAdded, const std::function<void(Shape*)>& onRemoved);
+
 private:
     std::vector<Shape*> shapes;  // List of shapes
     Shape* selectedShape;        // Currently selected shape
 	int shapeCounter;  // Keeps track of unique IDs for shapes
+
+	std::function<void(Shape*)> shapeAdded;
+	std::function<void(Shape*)> shapeRemoved;
 };
 
 #endif  // SHAPEMANAGER_H
@@ -0,0 +1,110 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "ParticleSystem.h"
+#include "TimeStepper.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Steps every registered particle system on a dedicated thread at a fixed rate.
+// Each step's state is published through a TripleBuffer; the render thread picks
+// up the newest one in syncToRenderer() and rebuilds its GL buffers from it.
+// Anything that changes what evalF reads (mass, wind, ...) must reach the
+// simulation through enqueue(), which runs the command on the simulation thread
+// between steps.
+class SimulationThread {
+public:
+    SimulationThread();
+    ~SimulationThread();
+
+    // Thread lifetime; commands run inline while the thread is stopped
+    void start();
+    void stop();
+
+    // Render thread: register a system, or drop one before it is deleted (blocks)
+    void addSystem(ParticleSystem* system);
+    void removeSystem(ParticleSystem* system);
+
+    // Render thread: restart a system from its initial state
+    void resetSystem(ParticleSystem* system);
+
+    // Run a command on the simulation thread before its next step
+    void enqueue(const std::function<void()>& command);
+
+    // Playback controls, mirrored from the UI every frame
+    void setPlaying(bool playing);
+    void setStepSize(float stepSize);
+    void setIntegrator(IntegratorType type);
+
+    // Render thread: apply the newest published state of every system
+    void syncToRenderer();
+
+    // Measured simulation rate over the last second
+    float getStepsPerSecond() const;
+
+    // Seconds of simulation stepped so far; keyframed characters follow this
+    // clock so they stay in step with the particle systems
+    double getSimulatedTime() const;
+
+    // Steps attempted per second of wall time
+    static const int STEP_RATE = 60;
+
+private:
+    // One published state, tagged with the reset generation it belongs to
+    struct Snapshot {
+        std::vector<glm::vec3> state;
+        unsigned generation = 0;
+    };
+
+    // Handoff shared by both threads for one system
+    struct Channel {
+        TripleBuffer<Snapshot> handoff;
+        unsigned generation = 0; // Render thread's current generation
+    };
+
+    // Simulation thread's private copy of a system's state
+    struct SimEntry {
+        ParticleSystem* system;
+        std::vector<glm::vec3> state;
+        unsigned generation;
+        std::shared_ptr<Channel> channel;
+    };
+
+    // Render thread side
+    std::map<ParticleSystem*, std::shared_ptr<Channel>> channels;
+
+    // Simulation thread side
+    std::vector<SimEntry> entries;
+    std::unique_ptr<TimeStepper> integrator;
+    IntegratorType integratorType;
+
+    // Command queue
+    std::mutex commandMutex;
+    std::condition_variable commandSignal;
+    std::deque<std::function<void()>> commands;
+
+    // Controls written by the render thread
+    std::atomic<bool> running;
+    std::atomic<bool> playing;
+    std::atomic<float> stepSize;
+    std::atomic<int> requestedIntegrator;
+    std::atomic<float> stepsPerSecond;
+    std::atomic<double> simulatedTime; // Written by the simulation thread only
+
+    std::thread worker;
+
+    void threadMain();
+    void runCommands();
+    void step();
+};
+
+#endif // SIMULATIONTHREAD_H
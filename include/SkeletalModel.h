@@ -1,7 +1,6 @@
 #ifndef SKELETALMODEL_H
 #define SKELETALMODEL_H
 
-#include "MatrixStack.h"
 #include "Joint.h"
 
 #include "glad/glad.h"
@@ -9,10 +8,19 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstdint>
 #include <vector>
 
+// The Joint tree is the authoring form of the skeleton; it is compiled into
+// contiguous arrays sorted so every parent precedes its children, which
+// turns forward kinematics into a single linear pass. Joint indices used by
+// the public API are positions in getJoints() (the .skel line order).
+//
+// Changing a joint marks its slot dirty; since a preorder keeps every subtree
+// in one contiguous slot range, an update only recomputes dirty subtrees.
 class SkeletalModel {
 public:
     SkeletalModel();
@@ -23,28 +31,55 @@ public:
 
     const std::vector<Joint*>& getJoints() const;
     void setJoints(const std::vector<Joint*>& joints);
+    size_t getJointCount() const;
 
     const std::vector<glm::vec3>& getJointCenters() const;
     const std::vector<std::pair<glm::vec3, glm::vec3>> getBonePairs() const;
 
-    MatrixStack& getMatrixStack();
-
     void setJointTransform(int jointIndex, float rX, float rY, float rZ);
+    void setJointRotation(int jointIndex, const glm::quat& rotation);
 
     void computeBindWorldToJointTransforms();
     void updateCurrentJointToWorldTransforms();
 
+    // Results of the last computeBind.../updateCurrent... call for one joint
+    const glm::mat4& getBindWorldToJointTransform(int jointIndex) const;
+    const glm::mat4& getCurrentJointToWorldTransform(int jointIndex) const;
+
+    // Parent of a joint, or -1 for the root
+    int getParentIndex(int jointIndex) const;
+
+    // Joints whose joint-to-world transform the last update recomputed
+    const std::vector<int>& getUpdatedJoints() const;
 
-private:   
+    // The compiled order, for callers that run their own forward kinematics:
+    // the joint index of each slot, and each slot's parent slot (-1 for roots,
+    // otherwise an earlier slot). Empty until the skeleton is compiled.
+    const std::vector<int>& getSlotJoints() const;
+    const std::vector<int>& getParentSlots() const;
+
+
+private:
     std::vector<Joint*> m_joints;
     Joint* m_rootJoint;
-    MatrixStack m_matrixStack;
     std::vector<glm::vec3> jointCenters;
-    std::vector<std::pair<glm::vec3, glm::vec3>> bonePairs;    
+    std::vector<std::pair<glm::vec3, glm::vec3>> bonePairs;
+
+    // Compiled skeleton, one entry per slot in parent-first order
+    bool m_compiled;
+    std::vector<int> m_parentSlots;             // -1 for roots
+    std::vector<int> m_subtreeEnds;             // One past the last slot of each slot's subtree
+    std::vector<uint8_t> m_dirty;               // Local transform changed since the last update
+    std::vector<int> m_updatedJoints;
+    std::vector<glm::mat4> m_localTransforms;   // Copy of each Joint's transform
+    std::vector<glm::mat4> m_jointToWorld;
+    std::vector<glm::mat4> m_bindWorldToJoint;  // By joint index; survives recompiling
+    std::vector<int> m_jointSlots;              // Joint index -> slot
+    std::vector<int> m_slotJoints;              // Slot -> joint index
 
-    void bindWorldToJointTransformRecursive(Joint* joint, MatrixStack& myStack);
-    void currentJointToWorldTransformsRecursive(Joint* joint, MatrixStack& myStack);     
- 
+    void setLocalTransform(int jointIndex, const glm::mat4& localTransform);
+    void compile();
+    void evaluateJointToWorld();
 };
 
 #endif
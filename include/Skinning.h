@@ -0,0 +1,89 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Strongest skinning influences of one vertex, strongest first. Weights are
+// unorm8 and sum to 255; unused slots have weight 0. Joint indices are 8-bit,
+// so at most 256 joints can influence a mesh.
+struct SkinInfluences {
+    static const int COUNT = 4;
+
+    uint8_t joints[COUNT];
+    uint8_t weights[COUNT];
+};
+
+// Bind pose and influences laid out for the CPU kernels: one array per
+// coordinate and one per influence slot (slot-major), padded with zero-weight
+// vertices to a multiple of Skinning::SIMD_WIDTH
+struct SkinningBindData {
+    size_t vertexCount;
+    size_t paddedCount;
+    std::vector<float> x, y, z;
+    std::vector<uint8_t> joints;    // joints[slot * paddedCount + vertex]
+    std::vector<float> weights;     // weights[slot * paddedCount + vertex], in [0, 1]
+
+    // SIMD blocks each joint influences: jointBlocks[jointBlockOffsets[j] .. jointBlockOffsets[j + 1])
+    std::vector<uint32_t> jointBlockOffsets;
+    std::vector<uint32_t> jointBlocks;
+
+    // Unindexed output, vertex-major: vertex v is written to corner slots
+    // [cornerOffsets[v], cornerOffsets[v + 1]), and slot s draws face corner
+    // corners[s] (corner c of face f is f * 3 + c); filled by Skinning::mapCorners
+    std::vector<uint32_t> cornerOffsets;
+    std::vector<uint32_t> corners;
+
+    SkinningBindData() : vertexCount(0), paddedCount(0) {}
+};
+
+// CPU linear-blend skinning for when the vertex shader cannot do it. The
+// kernels need no GL context; outputs are structure-of-arrays of paddedCount
+// floats, or the corner slots of SkinningBindData for skinBlocks.
+class Skinning {
+public:
+    // Vertices per SIMD kernel step (SSE); the scalar kernel works in the same blocks
+    static const size_t SIMD_WIDTH = 4;
+
+    // Keep the SkinInfluences::COUNT largest weights of one dense .attach row
+    // (one weight per joint) and renormalize them
+    static SkinInfluences compressAttachment(const std::vector<float>& weights);
+
+    // Rearrange the bind pose; influences on joints >= jointCount are dropped
+    static void prepare(const std::vector<glm::vec3>& bindVertices, const std::vector<SkinInfluences>& influences,
+                        size_t jointCount, SkinningBindData& out);
+
+    // Lay out one corner slot per corner of the triangles `faces`, grouped by vertex
+    static void mapCorners(const std::vector<std::vector<int>>& faces, SkinningBindData& bind);
+
+    // The first three rows of each palette matrix, row-major (12 floats per joint)
+    static void packPalette(const std::vector<glm::mat4>& palette, std::vector<float>& rows);
+
+    // Skin vertices [first, last); both multiples of SIMD_WIDTH
+    static void skinRangeScalar(const SkinningBindData& bind, const float* paletteRows, size_t first, size_t last,
+                                float* outX, float* outY, float* outZ);
+    static void skinRange(const SkinningBindData& bind, const float* paletteRows, size_t first, size_t last,
+                          float* outX, float* outY, float* outZ);
+
+    // Whole mesh, in chunks on the job system (inline when it is not started)
+    static void skin(const SkinningBindData& bind, const float* paletteRows,
+                     float* outX, float* outY, float* outZ);
+
+    // Sorted SIMD blocks (vertices [b * SIMD_WIDTH, (b + 1) * SIMD_WIDTH)) that any of `joints` influences
+    static void findAffectedBlocks(const SkinningBindData& bind, const std::vector<int>& joints,
+                                   std::vector<uint32_t>& blocks);
+
+    // Only the listed blocks, on the job system, each vertex written straight to
+    // its corner slots (3 floats per slot). Slots are vertex-major, so the stores
+    // run front to back, which suits a mapped buffer; other blocks' slots are untouched.
+    static void skinBlocks(const SkinningBindData& bind, const float* paletteRows, const std::vector<uint32_t>& blocks,
+                           float* cornerSlots);
+
+    // Whether skinRange uses SIMD in this build
+    static bool hasSimd();
+};
+
+#endif // SKINNING_H
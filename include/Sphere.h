@@ -2,6 +2,7 @@
 #define SPHERE_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -13,13 +14,15 @@
 class Sphere : public Shape {
 public:
     Sphere(float x, float y, float z, float scale, int colorIndex, int id);
-    ~Sphere();
 
     void draw(GLuint shaderProgram) override;
+    bool submit(RenderQueue& queue) override;
+
+    // Builds the sphere geometry for the mesh registry; also used for a skeleton's joints
+    static MeshData buildMesh(int lod);
 
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for sphere geometry
-    void setupSphere();   // Initializes the sphere's geometry
+    MeshHandle mesh;                    // Geometry shared with every other Sphere
 };
 
 #endif
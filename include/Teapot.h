@@ -2,6 +2,7 @@
 #define TEAPOT_H
 
 #include "Shape.h"
+#include "MeshRegistry.h"
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -12,13 +13,13 @@ class Teapot : public Shape {
 public:
     Teapot(float x, float y, float z, float uniformScale, int colorIndex, int id,
            float scaleX = 1.0f, float scaleY = 1.0f, float scaleZ = 1.0f, bool useUniformScaling = true);
-    ~Teapot();
 
     void draw(GLuint shaderProgram) override; // Render the teapot
+    bool submit(RenderQueue& queue) override;
 
 private:
-    GLuint VAO, VBO, EBO; // OpenGL handles for teapot geometry
-    void setupTeapot();   // Initializes the VAO/VBO/EBO for the teapot
+    MeshHandle mesh;                    // Geometry shared with every other Teapot
+    static MeshData buildMesh(int lod); // Builds the teapot geometry for the mesh registry
 };
 
 #endif
@@ -25,8 +25,15 @@ public:
     TimeStepper();
     virtual ~TimeStepper() = default;
 
-    // Perform one step of simulation
-    virtual void takeStep(ParticleSystem* particleSystem, float stepSize) = 0;
+    // Perform one step of simulation on the system's own state
+    void takeStep(ParticleSystem* particleSystem, float stepSize);
+
+    // Compute the state one step after `state`; only evalF is called on the system,
+    // so this can run off the render thread
+    virtual std::vector<glm::vec3> integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) = 0;
+
+    // Which integrator this is
+    virtual IntegratorType getType() const = 0;
 
     // Animation controls
     void playAnimation();
@@ -51,25 +58,29 @@ private:
 // Forward Euler Integrator
 class ForwardEuler : public TimeStepper {
 public:
-    void takeStep(ParticleSystem* particleSystem, float stepSize) override;
+    std::vector<glm::vec3> integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) override;
+    IntegratorType getType() const override { return IntegratorType::ForwardEuler; }
 };
 
 // Trapezoidal Integrator
 class Trapezoidal : public TimeStepper {
 public:
-    void takeStep(ParticleSystem* particleSystem, float stepSize) override;
+    std::vector<glm::vec3> integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) override;
+    IntegratorType getType() const override { return IntegratorType::Trapezoidal; }
 };
 
 // Midpoint Integrator
 class Midpoint : public TimeStepper {
 public:
-    void takeStep(ParticleSystem* particleSystem, float stepSize) override;
+    std::vector<glm::vec3> integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) override;
+    IntegratorType getType() const override { return IntegratorType::Midpoint; }
 };
 
 // Provided RK4 Integrator
 class RK4 : public TimeStepper {
 public:
-    void takeStep(ParticleSystem* particleSystem, float stepSize) override;
+    std::vector<glm::vec3> integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) override;
+    IntegratorType getType() const override { return IntegratorType::RK4; }
 };
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Lock-free single-producer/single-consumer handoff of the latest value.
+// The writer fills writeBuffer() and publish()es it; the reader calls update()
+// and then reads readBuffer(). Neither side ever waits: the writer always has
+// a free slot, and the reader always sees the newest completed value.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : middle(1), writeSlot(0), readSlot(2) {}
+
+    // Writer side: slot to fill, then hand it over
+    T& writeBuffer() { return slots[writeSlot]; }
+
+    void publish() {
+        const int previous = middle.exchange(writeSlot | FRESH, std::memory_order_acq_rel);
+        writeSlot = previous & INDEX_MASK;
+    }
+
+    // Reader side: swap in the newest published slot; false if nothing new
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        const int previous = middle.exchange(readSlot, std::memory_order_acq_rel);
+        readSlot = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return slots[readSlot]; }
+
+private:
+    // The shared middle slot index, with a flag set when it holds an unread value
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    T slots[3];
+    std::atomic<int> middle;
+    int writeSlot; // Owned by the writer
+    int readSlot;  // Owned by the reader
+
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+};
+
+#endif // TRIPLEBUFFER_H
@@ -20,6 +20,10 @@ in vec3 FragPos;
 in vec3 Normal;
 in vec3 FragColor;
 
+#ifdef INSTANCED
+flat in vec3 MaterialColor; // per-instance material color
+#endif
+
 out vec4 FragColorOutput;
 
 void main() {
@@ -28,6 +32,12 @@ void main() {
         return;
     }
 
+#ifdef INSTANCED
+    vec3 baseColor = MaterialColor;
+#else
+    vec3 baseColor = material.color;
+#endif
+
     // Normalize normal
     vec3 norm = normalize(Normal);
 
@@ -35,11 +45,11 @@ void main() {
     vec3 lightDir = normalize(light.position - FragPos);
 
     // Ambient component
-    vec3 ambient = light.ambient * material.color;
+    vec3 ambient = light.ambient * baseColor;
 
     // Diffuse component
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = light.diffuse * diff * material.color;
+    vec3 diffuse = light.diffuse * diff * baseColor;
 
     // Specular component
     vec3 viewDir = normalize(viewPos - FragPos);
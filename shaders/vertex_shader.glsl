@@ -1,21 +1,95 @@
 #version 330 core
 
+// Variants are built from this one source by ShaderLoader injecting #defines:
+//   INSTANCED - model, normal matrix and material color come from per-instance attributes
+//   SKINNED   - positions and normals are blended from a joint palette (ImportCharacter)
+
 layout(location = 0) in vec3 aPosition;
 layout(location = 1) in vec3 aNormal;
 layout(location = 2) in vec3 aColor;
 
+#ifdef SKINNED
+layout(location = 3) in uvec4 aJoints;   // Four joint indices (SkinInfluences)
+layout(location = 4) in vec4 aWeights;   // and their weights, summing to 1
+#endif
 
+#ifdef INSTANCED
+layout(location = 5) in mat4 instanceModel;         // locations 5-8
+layout(location = 9) in mat3 instanceNormalMatrix;  // locations 9-11
+layout(location = 12) in vec3 instanceColor;
+#else
 uniform mat4 model;
+uniform mat3 normalMatrix; // transpose(inverse(mat3(model))), computed once per shape on the CPU
+#endif
+
 uniform mat4 view;
 uniform mat4 projection;
 
+// Compact meshes store positions as unorm16 within their bounds (see CompactVertex.h);
+// the default zero scale marks plain float positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+#ifdef SKINNED
+// Linear-blend skinning against currentJointToWorld * bindWorldToJoint per joint
+// (ImportCharacter::MAX_SKIN_JOINTS entries, bound at SKINNING_PALETTE_BINDING)
+layout(std140) uniform SkinningPalette {
+    mat4 skinningPalette[256];
+};
+
+// Crowds (ImportCharacter::setCrowd): instance i's matrix for joint j is the
+// three rows at texel 3 * (i * crowdJointCount + j) of crowdPalette, with the
+// instance's placement folded in. crowdJointCount is 0 outside crowd draws.
+uniform samplerBuffer crowdPalette;
+uniform int crowdJointCount;
+
+mat4 crowdJointMatrix(uint joint) {
+    int texel = 3 * (gl_InstanceID * crowdJointCount + int(joint));
+    return transpose(mat4(texelFetch(crowdPalette, texel),
+                          texelFetch(crowdPalette, texel + 1),
+                          texelFetch(crowdPalette, texel + 2),
+                          vec4(0.0, 0.0, 0.0, 1.0)));
+}
+#endif
+
 out vec3 FragPos;
 out vec3 Normal;
 out vec3 FragColor;
 
+#ifdef INSTANCED
+flat out vec3 MaterialColor;
+#endif
+
 void main() {
-    FragPos = vec3(model * vec4(aPosition, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+#ifdef INSTANCED
+    mat4 model = instanceModel;
+    mat3 normalMatrix = instanceNormalMatrix;
+    MaterialColor = instanceColor;
+#endif
+
+    vec3 localPosition = positionScale == vec3(0.0) ? aPosition : positionOffset + positionScale * aPosition;
+    vec3 localNormal = aNormal;
+
+#ifdef SKINNED
+    if (crowdJointCount > 0) {
+        mat4 skin = aWeights.x * crowdJointMatrix(aJoints.x)
+                  + aWeights.y * crowdJointMatrix(aJoints.y)
+                  + aWeights.z * crowdJointMatrix(aJoints.z)
+                  + aWeights.w * crowdJointMatrix(aJoints.w);
+        localPosition = vec3(skin * vec4(localPosition, 1.0));
+        localNormal = mat3(skin) * localNormal;
+    } else {
+        mat4 skin = aWeights.x * skinningPalette[aJoints.x]
+                  + aWeights.y * skinningPalette[aJoints.y]
+                  + aWeights.z * skinningPalette[aJoints.z]
+                  + aWeights.w * skinningPalette[aJoints.w];
+        localPosition = vec3(skin * vec4(localPosition, 1.0));
+        localNormal = mat3(skin) * localNormal;
+    }
+#endif
+
+    FragPos = vec3(model * vec4(localPosition, 1.0));
+    Normal = normalMatrix * localNormal;
     FragColor = aColor;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
@@ -0,0 +1,220 @@
+#include "AnimationClip.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+// One key as read from the file, before it is sorted into its track
+struct ParsedKey {
+    int joint;
+    float time;
+    glm::quat rotation;
+};
+
+bool keyBefore(const ParsedKey& a, const ParsedKey& b) {
+    return a.joint != b.joint ? a.joint < b.joint : a.time < b.time;
+}
+
+// Above this cosine the arc is too short for slerp's division; lerp instead
+const float SLERP_LINEAR_THRESHOLD = 0.9995f;
+
+// Tracks per job; crowds queue thousands
+const size_t EVALUATE_GRAIN = 1024;
+
+}
+
+
+AnimationClip::AnimationClip() : duration(0.0f) {}
+
+bool AnimationClip::loadFromFile(const std::string& path) {
+    std::ifstream file(path.c_str());
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<ParsedKey> keys;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::string::size_type comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+
+        std::istringstream ss(line);
+        ParsedKey key;
+        glm::vec3 degrees;
+        if (!(ss >> key.time)) {
+            continue; // Blank or comment-only line
+        }
+        if (!(ss >> key.joint >> degrees.x >> degrees.y >> degrees.z) || key.joint < 0 || key.time < 0.0f) {
+            std::cerr << "Invalid animation key on line " << lineNumber << " of " << path << std::endl;
+            return false;
+        }
+        key.rotation = eulerDegreesToQuat(degrees);
+        keys.push_back(key);
+    }
+
+    std::stable_sort(keys.begin(), keys.end(), keyBefore);
+
+    const size_t trackCount = keys.empty() ? 0 : keys.back().joint + 1;
+    trackOffsets.assign(trackCount + 1, 0);
+    keyTimes.clear();
+    keyRotations.clear();
+    duration = 0.0f;
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ++trackOffsets[keys[i].joint + 1];
+        keyTimes.push_back(keys[i].time);
+        keyRotations.push_back(keys[i].rotation);
+        duration = std::max(duration, keys[i].time);
+    }
+    for (size_t j = 0; j < trackCount; ++j) {
+        trackOffsets[j + 1] += trackOffsets[j];
+    }
+    return true;
+}
+
+size_t AnimationClip::getTrackCount() const {
+    return trackOffsets.empty() ? 0 : trackOffsets.size() - 1;
+}
+
+float AnimationClip::getDuration() const {
+    return duration;
+}
+
+bool AnimationClip::isEmpty() const {
+    return keyTimes.empty();
+}
+
+const std::vector<uint32_t>& AnimationClip::getTrackOffsets() const {
+    return trackOffsets;
+}
+
+const std::vector<float>& AnimationClip::getKeyTimes() const {
+    return keyTimes;
+}
+
+const std::vector<glm::quat>& AnimationClip::getKeyRotations() const {
+    return keyRotations;
+}
+
+glm::quat AnimationClip::eulerDegreesToQuat(const glm::vec3& degrees) {
+    return glm::angleAxis(glm::radians(degrees.x), glm::vec3(1, 0, 0)) *
+           glm::angleAxis(glm::radians(degrees.y), glm::vec3(0, 1, 0)) *
+           glm::angleAxis(glm::radians(degrees.z), glm::vec3(0, 0, 1));
+}
+
+
+void AnimationBatch::clear() {
+    fromX.clear(); fromY.clear(); fromZ.clear(); fromW.clear();
+    toX.clear(); toY.clear(); toZ.clear(); toW.clear();
+    blend.clear();
+    animated.clear();
+}
+
+size_t AnimationBatch::add(const AnimationClip& clip, float time) {
+    const size_t firstTrack = blend.size();
+    const float duration = clip.getDuration();
+    if (duration > 0.0f) {
+        time = std::fmod(time, duration);
+        if (time < 0.0f) time += duration;
+    } else {
+        time = 0.0f;
+    }
+
+    const std::vector<uint32_t>& offsets = clip.getTrackOffsets();
+    const std::vector<float>& times = clip.getKeyTimes();
+    const std::vector<glm::quat>& rotations = clip.getKeyRotations();
+
+    for (size_t track = 0; track < clip.getTrackCount(); ++track) {
+        const uint32_t first = offsets[track];
+        const uint32_t last = offsets[track + 1];
+
+        // Bracketing keys; outside the track's range both are the nearest end key
+        uint32_t from = first, to = first;
+        float t = 0.0f;
+        if (last - first > 1) {
+            const float* next = std::upper_bound(&times[first], &times[first] + (last - first), time);
+            to = static_cast<uint32_t>(next - &times[0]);
+            if (to == first) {
+                from = first;
+            } else if (to == last) {
+                from = to = last - 1;
+            } else {
+                from = to - 1;
+                const float span = times[to] - times[from];
+                t = span > 0.0f ? (time - times[from]) / span : 0.0f;
+            }
+        }
+
+        const bool hasKeys = last > first;
+        const glm::quat a = hasKeys ? rotations[from] : glm::quat();
+        const glm::quat b = hasKeys ? rotations[to] : glm::quat();
+        fromX.push_back(a.x); fromY.push_back(a.y); fromZ.push_back(a.z); fromW.push_back(a.w);
+        toX.push_back(b.x); toY.push_back(b.y); toZ.push_back(b.z); toW.push_back(b.w);
+        blend.push_back(t);
+        animated.push_back(hasKeys ? 1 : 0);
+    }
+    return firstTrack;
+}
+
+void AnimationBatch::evaluate() {
+    PROFILE_SCOPE("AnimationBatch::evaluate");
+
+    const size_t count = blend.size();
+    rotationX.resize(count);
+    rotationY.resize(count);
+    rotationZ.resize(count);
+    rotationW.resize(count);
+
+    JobSystem::parallelFor(0, count, EVALUATE_GRAIN, [this](size_t first, size_t last) {
+        evaluateRange(first, last);
+    });
+}
+
+void AnimationBatch::evaluateRange(size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+        float cosTheta = fromX[i] * toX[i] + fromY[i] * toY[i] + fromZ[i] * toZ[i] + fromW[i] * toW[i];
+
+        // q and -q are the same rotation; take the shorter arc
+        const float sign = cosTheta < 0.0f ? -1.0f : 1.0f;
+        cosTheta *= sign;
+
+        float fromWeight = 1.0f - blend[i];
+        float toWeight = blend[i];
+        if (cosTheta < SLERP_LINEAR_THRESHOLD) {
+            const float theta = std::acos(cosTheta);
+            const float invSinTheta = 1.0f / std::sin(theta);
+            fromWeight = std::sin(fromWeight * theta) * invSinTheta;
+            toWeight = std::sin(toWeight * theta) * invSinTheta;
+        }
+        toWeight *= sign;
+
+        const float x = fromWeight * fromX[i] + toWeight * toX[i];
+        const float y = fromWeight * fromY[i] + toWeight * toY[i];
+        const float z = fromWeight * fromZ[i] + toWeight * toZ[i];
+        const float w = fromWeight * fromW[i] + toWeight * toW[i];
+        const float invLength = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+
+        rotationX[i] = x * invLength;
+        rotationY[i] = y * invLength;
+        rotationZ[i] = z * invLength;
+        rotationW[i] = w * invLength;
+    }
+}
+
+bool AnimationBatch::isAnimated(size_t track) const {
+    return track < animated.size() && animated[track];
+}
+
+glm::quat AnimationBatch::getRotation(size_t track) const {
+    return glm::quat(rotationW[track], rotationX[track], rotationY[track], rotationZ[track]);
+}
@@ -1,6 +1,9 @@
 #include "Globals.h"
 #include "Application.h"
 #include "ErrorHandling.h"
+#include "GpuProfiler.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -37,6 +40,11 @@ ShapeManager Application::shapeManager;
 FileImporter Application::fileImporter;
 // FileManager Application::fileManager;
 TimeStepper* Application::timeStepper = nullptr;
+SimulationThread Application::simulation;
+AnimationBatch Application::animationBatch;
+std::vector<ImportCharacter*> Application::animatedCharacters;
+std::vector<size_t> Application::animationFirstTracks;
+double Application::lastSimulatedTime = 0.0;
 
 // Initialize the static instance pointer to nullptr
 Application* Application::instance = nullptr;
@@ -66,11 +74,19 @@ Application::~Application() {
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    fileImporter.cancelAll();          // Joins import threads before the job system goes away
+    simulation.stop();                 // Nothing may step the shapes while they are deleted
+    JobSystem::shutdown();
     shapeManager.getShapes().clear();  // Ensure all shapes are deleted before quitting
 
     // Clean up dynamically allocated resources
     delete timeStepper;
     
+#ifdef ENABLE_PROFILING
+    // Profiler queries belong to the GL context
+    GpuProfiler::release();
+#endif
+
     // Cleanup glfw instance
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -132,6 +148,9 @@ void Application::initialize(int argc, char** argv) {
         exit(EXIT_FAILURE);
     }
 
+    // Count GL object allocations so per-frame churn shows up in the render stats
+    GpuResourceCache::installAllocationCounters();
+
 
 	// Enable OpenGL debugging through the ErrorHandling class
 	if (GLAD_GL_VERSION_4_3 || GLAD_GL_KHR_debug) {
@@ -161,6 +180,25 @@ void Application::initialize(int argc, char** argv) {
     // Initialize ImGui settings
     initImGui();
 
+    // One worker pool for simulation, skinning, tessellation and import
+    JobSystem::start();
+
+    // Particle systems join and leave the simulation as they are added and deleted
+    shapeManager.setShapeListeners(
+        [](Shape* shape) {
+            if (ParticleSystem* particleSystem = dynamic_cast<ParticleSystem*>(shape)) {
+                renderer.trackParticleSystem(particleSystem);
+                simulation.addSystem(particleSystem);
+            }
+        },
+        [](Shape* shape) {
+            if (ParticleSystem* particleSystem = dynamic_cast<ParticleSystem*>(shape)) {
+                simulation.removeSystem(particleSystem);
+                renderer.forgetParticleSystem(particleSystem);
+            }
+        });
+    simulation.start();
+
 }
 
 
@@ -190,6 +228,23 @@ void Application::initOpenGL() {
 
     // Pass projection matrix to the shader
     renderer.setShaderProgram(shaderProgram);
+
+    // Instanced variant of the same sources, used for shapes that share a mesh
+    GLuint instancedProgram = ShaderLoader::loadShaderFromFile("shaders/vertex_shader.glsl", "shaders/fragment_shader.glsl",
+                                                               "#define INSTANCED\n");
+    if (instancedProgram == 0) {
+        std::cerr << "Failed to load the instanced shader variant; shared meshes will be drawn one by one." << std::endl;
+    }
+    renderer.setInstancedShaderProgram(instancedProgram);
+
+    // Skinned variant, the only one that declares the joint palette
+    GLuint skinnedProgram = ShaderLoader::loadShaderFromFile("shaders/vertex_shader.glsl", "shaders/fragment_shader.glsl",
+                                                             "#define SKINNED\n");
+    if (skinnedProgram == 0) {
+        std::cerr << "Failed to load the skinned shader variant; characters will be skinned on the CPU." << std::endl;
+    }
+    renderer.setSkinnedShaderProgram(skinnedProgram);
+    ImportCharacter::setSkinnedShaderProgram(skinnedProgram);
         
     GLint projLoc = glGetUniformLocation(shaderProgram, "projection");
     glUseProgram(shaderProgram);
@@ -230,25 +285,46 @@ void Application::run() {
 
     // Main GLFW render loop
     while (!glfwWindowShouldClose(window)) {
+        PROFILE_SCOPE("Application::run frame");
 
         // Get current time and compute time difference from last frame
         float currentTime = glfwGetTime();
         float deltaTime = currentTime - lastTime;
         lastTime = currentTime;
-        
+
+        // Start counting GL allocations for this frame
+        GpuResourceCache::beginFrame();
+
+        // Open this frame's profiler zones; results are read back a few frames later
+        GPU_PROFILE_BEGIN_FRAME();
+
         // Process user input and window events (keyboard, mouse, resize, etc.)
-        glfwPollEvents();
-
-        // Animate the scene if it is playing
-        if (timeStepper->isAnimationPlaying()) {
-            for (Shape* shape : shapeManager.getShapes()) {
-                if (auto* particleSystem = dynamic_cast<ParticleSystem*>(shape)) {
-                    // Take a simulation step using the chosen integrator (Euler, RK4, etc.)
-                    timeStepper->takeStep(particleSystem, timeStepper->getStepSize());
-                }
-            }
+        {
+            PROFILE_SCOPE("Poll events");
+            glfwPollEvents();
         }
 
+        // The simulation thread steps the scene; mirror the playback controls and
+        // upload the newest state it has published
+        {
+            GPU_PROFILE_SCOPE("Simulation sync");
+            simulation.setPlaying(timeStepper->isAnimationPlaying());
+            simulation.setStepSize(timeStepper->getStepSize());
+            simulation.setIntegrator(timeStepper->getType());
+            simulation.syncToRenderer();
+        }
+
+        // Characters play their clips on the simulation's clock, so Play/Stop
+        // and the step size drive them exactly as they drive the particles
+        {
+            const double simulatedTime = simulation.getSimulatedTime();
+            animateCharacters(static_cast<float>(simulatedTime - lastSimulatedTime));
+            lastSimulatedTime = simulatedTime;
+        }
+
+        // Create buffers for imports that finished loading in the background
+        fileImporter.update(shapeManager);
+
         // Start a new ImGui frame
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
@@ -258,18 +334,64 @@ void Application::run() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Render the scene
-        renderer.renderScene(shapeManager, timeStepper);
+        {
+            GPU_PROFILE_SCOPE("Scene");
+            PROFILE_SCOPE("Render scene");
+            renderer.renderScene(shapeManager, timeStepper);
+        }
 
         // Render ImGui
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            GPU_PROFILE_SCOPE("ImGui");
+            PROFILE_SCOPE("ImGui render");
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
+
+        // Close the frame's zones before presenting
+        GPU_PROFILE_END_FRAME();
 
         // Swap buffers
-        glfwSwapBuffers(window);
+        {
+            PROFILE_SCOPE("Swap buffers");
+            glfwSwapBuffers(window);
+        }
 
         // Check for OpenGL errors after each frame
         ErrorHandling::checkOpenGLError("Main Loop");
     }
+
+    // Stop stepping and loading before the shapes and the GL context go away
+    fileImporter.cancelAll();
+    simulation.stop();
+    JobSystem::shutdown();
+}
+
+
+void Application::animateCharacters(float elapsed) {
+    PROFILE_SCOPE("Application::animateCharacters");
+
+    // Queue every character (and crowd) whose pose is due, then sample them all in one pass
+    animationBatch.clear();
+    animatedCharacters.clear();
+    animationFirstTracks.clear();
+    for (Shape* shape : shapeManager.getShapes()) {
+        ImportCharacter* character = dynamic_cast<ImportCharacter*>(shape);
+        if (!character || !character->hasAnimationClip() || !character->advanceAnimation(elapsed)) {
+            continue;
+        }
+        animatedCharacters.push_back(character);
+        animationFirstTracks.push_back(character->queueAnimation(animationBatch));
+    }
+
+    if (animatedCharacters.empty()) {
+        return;
+    }
+
+    animationBatch.evaluate();
+    for (size_t i = 0; i < animatedCharacters.size(); ++i) {
+        animatedCharacters[i]->applyAnimationPose(animationBatch, animationFirstTracks[i]);
+    }
 }
 
 
@@ -284,6 +406,16 @@ TimeStepper& Application::getTimeStepper() {
     return *timeStepper;
 }
 
+// Getter implementation for the simulation thread
+SimulationThread& Application::getSimulation() {
+    return simulation;
+}
+
+// Getter implementation for the background importer
+FileImporter& Application::getFileImporter() {
+    return fileImporter;
+}
+
 // Setter implementation for TimeStepper
 void Application::setTimeStepper(TimeStepper* newStepper) {
     if (timeStepper) {
@@ -0,0 +1,92 @@
+#include "CompactVertex.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+bool VertexCompression::enabled = true;
+
+namespace {
+
+// Smallest decode extent, so flat or single-point meshes still decode
+const float MIN_EXTENT = 1e-6f;
+
+inline uint16_t quantizeUnorm16(float value) {
+    const float clamped = std::min(std::max(value, 0.0f), 1.0f);
+    return static_cast<uint16_t>(clamped * 65535.0f + 0.5f);
+}
+
+inline uint32_t quantizeSnorm10(float value) {
+    const float clamped = std::min(std::max(value, -1.0f), 1.0f);
+    const int bits = static_cast<int>(std::floor(clamped * 511.0f + 0.5f));
+    return static_cast<uint32_t>(bits) & 0x3FFu;
+}
+
+}
+
+
+bool VertexCompression::isEnabled() {
+    return enabled;
+}
+
+void VertexCompression::setEnabled(bool value) {
+    enabled = value;
+}
+
+
+uint32_t VertexCompression::packNormal(const glm::vec3& normal) {
+    return quantizeSnorm10(normal.x) | (quantizeSnorm10(normal.y) << 10) | (quantizeSnorm10(normal.z) << 20);
+}
+
+
+void VertexCompression::compress(const float* vertices, size_t stride, size_t normalOffset, size_t count,
+                                 const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                                 std::vector<CompactVertex>& out) {
+    const glm::vec3 inverseScale = glm::vec3(1.0f) / getDecodeScale(boundsMin, boundsMax);
+
+    out.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        const float* vertex = vertices + i * stride;
+        CompactVertex& compact = out[i];
+        for (int axis = 0; axis < 3; ++axis) {
+            compact.position[axis] = quantizeUnorm16((vertex[axis] - boundsMin[axis]) * inverseScale[axis]);
+        }
+        compact.padding = 0;
+        compact.normal = packNormal(glm::vec3(vertex[normalOffset], vertex[normalOffset + 1], vertex[normalOffset + 2]));
+    }
+}
+
+
+glm::vec3 VertexCompression::getDecodeOffset(const glm::vec3& boundsMin) {
+    return boundsMin;
+}
+
+glm::vec3 VertexCompression::getDecodeScale(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    return glm::max(boundsMax - boundsMin, glm::vec3(MIN_EXTENT));
+}
+
+
+void VertexCompression::configureAttributes() {
+    const GLsizei stride = sizeof(CompactVertex);
+
+    // Position -> location 0, normalized to [0, 1]
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Normal -> location 1, normalized to [-1, 1]
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)(4 * sizeof(uint16_t)));
+    glEnableVertexAttribArray(1);
+}
+
+
+void VertexCompression::setDecodeUniforms(GLuint shaderProgram, const glm::vec3& offset, const glm::vec3& scale) {
+    GLint offsetLoc = glGetUniformLocation(shaderProgram, "positionOffset");
+    GLint scaleLoc = glGetUniformLocation(shaderProgram, "positionScale");
+    if (offsetLoc != -1) glUniform3fv(offsetLoc, 1, glm::value_ptr(offset));
+    if (scaleLoc != -1) glUniform3fv(scaleLoc, 1, glm::value_ptr(scale));
+}
+
+void VertexCompression::clearDecodeUniforms(GLuint shaderProgram) {
+    setDecodeUniforms(shaderProgram, glm::vec3(0.0f), glm::vec3(0.0f));
+}
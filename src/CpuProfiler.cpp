@@ -0,0 +1,153 @@
+#include "CpuProfiler.h"
+
+#ifdef ENABLE_PROFILING
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+// Static members
+double CpuProfiler::dumpWindowSeconds = 5.0;
+std::vector<CpuProfiler::ThreadBuffer*>* CpuProfiler::threadBuffers = nullptr;
+
+namespace {
+
+// Guards threadBuffers; buffers are never freed so a dump can still read exited threads
+std::mutex registryMutex;
+std::atomic<uint32_t> nextThreadId(1);
+
+// Escape a scope or thread name for a JSON string
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+}
+
+
+uint64_t CpuProfiler::now() {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+
+// First use on a thread registers its ring; every later call is a thread_local lookup
+CpuProfiler::ThreadBuffer& CpuProfiler::localBuffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (!buffer) {
+        buffer = new ThreadBuffer();
+        buffer->threadId = nextThreadId++;
+        buffer->threadName = buffer->threadId == 1 ? "Main" : "Thread " + std::to_string(buffer->threadId);
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        if (!threadBuffers) {
+            threadBuffers = new std::vector<ThreadBuffer*>();
+        }
+        threadBuffers->push_back(buffer);
+    }
+    return *buffer;
+}
+
+
+void CpuProfiler::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    ThreadBuffer& buffer = localBuffer();
+
+    // Only this thread writes the ring; publish the slot after filling it
+    const uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+    Event& event = buffer.events[index % RING_CAPACITY];
+    event.name = name;
+    event.startNs = startNs;
+    event.durationNs = endNs - startNs;
+    buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+
+void CpuProfiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.threadName = name;
+}
+
+
+bool CpuProfiler::writeChromeTrace(const std::string& path, double seconds) {
+    std::ofstream out(path.c_str());
+    if (!out) {
+        std::cerr << "CpuProfiler: could not open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    const uint64_t nowNs = now();
+    const uint64_t windowNs = static_cast<uint64_t>(seconds * 1.0e9);
+    const uint64_t cutoffNs = nowNs > windowNs ? nowNs - windowNs : 0;
+
+    // Microsecond timestamps with sub-microsecond precision, never in scientific notation
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (threadBuffers) {
+        std::vector<Event> events;
+        for (ThreadBuffer* buffer : *threadBuffers) {
+
+            // Snapshot the ring without stopping its writer
+            const uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+            const uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+            events.clear();
+            for (uint64_t i = begin; i < end; ++i) {
+                events.push_back(buffer->events[i % RING_CAPACITY]);
+            }
+
+            // Drop the slots the writer may have overwritten while we copied,
+            // including the one it may be filling right now for index `after`
+            const uint64_t after = buffer->writeIndex.load(std::memory_order_acquire);
+            const uint64_t oldestIntact = after >= RING_CAPACITY ? after - RING_CAPACITY + 1 : 0;
+            const size_t skip = static_cast<size_t>(std::min<uint64_t>(oldestIntact > begin ? oldestIntact - begin : 0, events.size()));
+
+            // Thread label
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"args\":{\"name\":\"" << jsonEscape(buffer->threadName) << "\"}}";
+            first = false;
+
+            // Complete ("X") events in microseconds
+            for (size_t i = skip; i < events.size(); ++i) {
+                const Event& event = events[i];
+                if (event.startNs + event.durationNs < cutoffNs) {
+                    continue;
+                }
+                out << ",\n{\"name\":\"" << jsonEscape(event.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                    << ",\"ts\":" << event.startNs / 1000.0 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+            }
+        }
+    }
+
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+
+void CpuProfiler::dumpRecent() {
+
+    // trace_YYYYMMDD_HHMMSS.json
+    char stamp[32];
+    std::time_t t = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&t));
+    std::string path = std::string("trace_") + stamp + ".json";
+
+    if (writeChromeTrace(path, dumpWindowSeconds)) {
+        std::cout << "Wrote the last " << dumpWindowSeconds << " s of CPU scopes to " << path << std::endl;
+    }
+}
+
+#endif // ENABLE_PROFILING
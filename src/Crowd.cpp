@@ -0,0 +1,242 @@
+#include "Crowd.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+const size_t Crowd::MAX_INSTANCES;
+
+namespace {
+
+// Instances per job; one instance is a few dozen matrix products
+const size_t CROWD_GRAIN = 16;
+
+const size_t PALETTE_ROW_FLOATS = 12;
+
+// Deterministic value in [0, 1) per instance, so a layout looks the same every time
+float unitHash(uint32_t value) {
+    value ^= value >> 16;
+    value *= 0x7feb352du;
+    value ^= value >> 15;
+    value *= 0x846ca68bu;
+    value ^= value >> 16;
+    return (value & 0xFFFFFFu) / 16777216.0f;
+}
+
+// First three rows of an affine matrix, row-major (glm is column-major)
+void writeRows(float* rows, const glm::mat4& m) {
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            rows[r * 4 + c] = m[c][r];
+        }
+    }
+}
+
+}
+
+
+Crowd::Crowd() {}
+
+void Crowd::layoutGrid(size_t count, float spacing, float clipDuration) {
+    count = std::min(std::max<size_t>(count, 1), MAX_INSTANCES);
+    const size_t columns = static_cast<size_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+
+    instances.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Instance& instance = instances[i];
+        instance.position = glm::vec3((i % columns) * spacing, 0.0f, -static_cast<float>(i / columns) * spacing);
+        if (i == 0) {
+            instance.heading = 0.0f;
+            instance.rate = 1.0f;
+            instance.phase = 0.0f;
+        } else {
+            const uint32_t seed = static_cast<uint32_t>(i) * 3u;
+            instance.heading = 30.0f * unitHash(seed) - 15.0f;
+            instance.rate = 0.85f + 0.3f * unitHash(seed + 1);
+            instance.phase = unitHash(seed + 2);
+        }
+    }
+    resetPlayheads(clipDuration);
+}
+
+size_t Crowd::getInstanceCount() const {
+    return instances.size();
+}
+
+const std::vector<Crowd::Instance>& Crowd::getInstances() const {
+    return instances;
+}
+
+void Crowd::advance(float elapsed, float clipDuration) {
+    for (size_t i = 0; i < instances.size(); ++i) {
+        Instance& instance = instances[i];
+        instance.time += elapsed * instance.rate;
+        instance.time = clipDuration > 0.0f ? std::fmod(instance.time, clipDuration) : 0.0f;
+    }
+}
+
+void Crowd::resetPlayheads(float clipDuration) {
+    for (size_t i = 0; i < instances.size(); ++i) {
+        instances[i].time = instances[i].phase * clipDuration;
+    }
+}
+
+
+// Transforms are gathered into slot order so the pose pass reads them linearly
+void Crowd::setSkeleton(const std::vector<int>& slotJoints, const std::vector<int>& parentSlots,
+                        const std::vector<glm::mat4>& restLocalTransforms,
+                        const std::vector<glm::mat4>& bindWorldToJoint) {
+    const size_t jointCount = std::min(slotJoints.size(), parentSlots.size());
+    this->slotJoints.clear();
+    this->parentSlots.clear();
+    this->restLocalTransforms.clear();
+    this->bindWorldToJoint.clear();
+
+    // Every slot must name a joint both transform arrays cover
+    for (size_t slot = 0; slot < jointCount; ++slot) {
+        const int joint = slotJoints[slot];
+        if (joint < 0 || static_cast<size_t>(joint) >= std::min(restLocalTransforms.size(), bindWorldToJoint.size())) {
+            return;
+        }
+    }
+
+    this->slotJoints.assign(slotJoints.begin(), slotJoints.begin() + jointCount);
+    this->parentSlots.resize(jointCount);
+    this->restLocalTransforms.resize(jointCount);
+    this->bindWorldToJoint.resize(jointCount);
+    for (size_t slot = 0; slot < jointCount; ++slot) {
+        const int parentSlot = parentSlots[slot];
+        this->parentSlots[slot] = (parentSlot >= 0 && static_cast<size_t>(parentSlot) < slot) ? parentSlot : -1;
+        this->restLocalTransforms[slot] = restLocalTransforms[slotJoints[slot]];
+        this->bindWorldToJoint[slot] = bindWorldToJoint[slotJoints[slot]];
+    }
+}
+
+size_t Crowd::getJointCount() const {
+    return slotJoints.size();
+}
+
+
+size_t Crowd::queueAnimation(const AnimationClip& clip, AnimationBatch& batch) const {
+    size_t firstTrack = 0;
+    for (size_t i = 0; i < instances.size(); ++i) {
+        const size_t track = batch.add(clip, instances[i].time);
+        if (i == 0) {
+            firstTrack = track;
+        }
+    }
+    return firstTrack;
+}
+
+
+void Crowd::evaluatePoses(const AnimationBatch& batch, size_t firstTrack, size_t trackStride) {
+    PROFILE_SCOPE("Crowd::evaluatePoses");
+
+    const size_t jointCount = getJointCount();
+    paletteRows.resize(instances.size() * jointCount * PALETTE_ROW_FLOATS);
+
+    JobSystem::parallelFor(0, instances.size(), CROWD_GRAIN,
+                           [this, &batch, firstTrack, trackStride, jointCount](size_t first, size_t last) {
+        std::vector<glm::mat4> jointToWorld(jointCount);
+
+        for (size_t i = first; i < last; ++i) {
+            const size_t instanceTrack = firstTrack + i * trackStride;
+            const glm::mat4 placement = getPlacement(i);
+            float* rows = &paletteRows[i * jointCount * PALETTE_ROW_FLOATS];
+
+            // Forward kinematics in slot order; animated joints keep their rest offset.
+            // Tracks and palette rows are by joint index.
+            for (size_t slot = 0; slot < jointCount; ++slot) {
+                const int j = slotJoints[slot];
+                glm::mat4 local = restLocalTransforms[slot];
+                if (static_cast<size_t>(j) < trackStride && batch.isAnimated(instanceTrack + j)) {
+                    local = glm::mat4_cast(batch.getRotation(instanceTrack + j));
+                    local[3] = restLocalTransforms[slot][3];
+                }
+                const int parentSlot = parentSlots[slot];
+                jointToWorld[slot] = parentSlot < 0 ? local : jointToWorld[parentSlot] * local;
+
+                writeRows(rows + j * PALETTE_ROW_FLOATS, placement * jointToWorld[slot] * bindWorldToJoint[slot]);
+            }
+        }
+    });
+}
+
+
+void Crowd::evaluateSharedPose(const std::vector<glm::mat4>& skinningPalette) {
+    PROFILE_SCOPE("Crowd::evaluateSharedPose");
+
+    const size_t jointCount = std::min(getJointCount(), skinningPalette.size());
+    paletteRows.assign(instances.size() * getJointCount() * PALETTE_ROW_FLOATS, 0.0f);
+
+    JobSystem::parallelFor(0, instances.size(), CROWD_GRAIN,
+                           [this, &skinningPalette, jointCount](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const glm::mat4 placement = getPlacement(i);
+            float* rows = &paletteRows[i * getJointCount() * PALETTE_ROW_FLOATS];
+            for (size_t j = 0; j < jointCount; ++j) {
+                writeRows(rows + j * PALETTE_ROW_FLOATS, placement * skinningPalette[j]);
+            }
+        }
+    });
+}
+
+const std::vector<float>& Crowd::getPaletteRows() const {
+    return paletteRows;
+}
+
+
+// Same fit as ImportCharacter::fitPosedBounds, per instance: skinned
+// positions are convex blends, so the transformed joint boxes bound them
+bool Crowd::computeBounds(const std::vector<glm::vec3>& jointBoundsMin, const std::vector<glm::vec3>& jointBoundsMax,
+                          glm::vec3& outMin, glm::vec3& outMax) const {
+    const size_t jointCount = getJointCount();
+    if (paletteRows.size() != instances.size() * jointCount * PALETTE_ROW_FLOATS) {
+        return false;
+    }
+
+    glm::vec3 crowdMin(std::numeric_limits<float>::max());
+    glm::vec3 crowdMax(-std::numeric_limits<float>::max());
+
+    for (size_t j = 0; j < jointCount && j < jointBoundsMin.size() && j < jointBoundsMax.size(); ++j) {
+        if (jointBoundsMin[j].x > jointBoundsMax[j].x) continue;  // Joint moves no vertices
+
+        const glm::vec3 localCenter = 0.5f * (jointBoundsMin[j] + jointBoundsMax[j]);
+        const glm::vec3 localExtent = 0.5f * (jointBoundsMax[j] - jointBoundsMin[j]);
+        for (size_t i = 0; i < instances.size(); ++i) {
+            const float* m = &paletteRows[(i * jointCount + j) * PALETTE_ROW_FLOATS];
+            for (int r = 0; r < 3; ++r) {
+                const float* row = m + r * 4;
+                const float center = row[0] * localCenter.x + row[1] * localCenter.y + row[2] * localCenter.z + row[3];
+                const float extent = std::fabs(row[0]) * localExtent.x + std::fabs(row[1]) * localExtent.y +
+                                     std::fabs(row[2]) * localExtent.z;
+                crowdMin[r] = std::min(crowdMin[r], center - extent);
+                crowdMax[r] = std::max(crowdMax[r], center + extent);
+            }
+        }
+    }
+
+    if (crowdMin.x > crowdMax.x) {
+        return false;
+    }
+    outMin = crowdMin;
+    outMax = crowdMax;
+    return true;
+}
+
+
+// Heading about +Y, then the grid offset
+glm::mat4 Crowd::getPlacement(size_t instance) const {
+    const Instance& placement = instances[instance];
+    const float angle = glm::radians(placement.heading);
+    const float c = std::cos(angle), s = std::sin(angle);
+
+    glm::mat4 m(1.0f);
+    m[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+    m[2] = glm::vec4(s, 0.0f, c, 0.0f);
+    m[3] = glm::vec4(placement.position, 1.0f);
+    return m;
+}
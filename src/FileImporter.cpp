@@ -1,7 +1,13 @@
 #include "FileImporter.h"
+#include "CpuProfiler.h"
+#include "ObjParser.h"
+#include "MeshCache.h"
+
+#include "imgui.h"
 
 // Read control points from a file
 std::vector<glm::vec3> FileImporter::readCps(std::istream &file, unsigned dim) {    
+    PROFILE_SCOPE("FileImporter::readCps");
    
     // Number of control points    
     unsigned n;
@@ -46,6 +52,7 @@ std::string FileImporter::getExecutableDirectory() {
 
 // Function to import a selected obj file
 int FileImporter::importObjFile(ShapeManager& shapeManager) {
+    PROFILE_SCOPE("FileImporter::importObjFile");
 
     std::string execDir = getExecutableDirectory();
     
@@ -81,65 +88,11 @@ int FileImporter::importObjFile(ShapeManager& shapeManager) {
             newShapeType[i] = std::tolower(newShapeType[i]);
         }
 							
-        std::vector<glm::vec3> vertices;
-        std::vector<glm::vec3> normals;
-        std::vector<std::vector<int>> faces;
-
-	std::ifstream file(selectedFile);
-        if (!file.is_open()) {
-            std::cerr << "Unable to open file: " << selectedFile << std::endl;
-            return 0;
-        }
-
-        std::string line;
-        while (std::getline(file, line)) {
-            std::istringstream ss(line);
-            std::string prefix;
-            ss >> prefix;
-
-            if (prefix == "v") {
-                float x, y, z;
-                ss >> x >> y >> z;
-                vertices.push_back(glm::vec3(x, y, z));
-            } else if (prefix == "vn") {
-                float nx, ny, nz;
-                ss >> nx >> ny >> nz;
-                normals.push_back(glm::vec3(nx, ny, nz));
-            } else if (prefix == "f") {
-                std::vector<int> face;
-                std::string vertexData;
-
-	        // Parse all three vertex groups (a/b/c, d/e/f, g/h/i)
-	        for (int i = 0; i < 3; ++i) {
-                    ss >> vertexData;
-                    size_t pos1 = vertexData.find('/');
-                    size_t pos2 = vertexData.find('/', pos1 + 1);
-
-		    // Parse the vertex and normal indices
-		    int vertexIndex = std::stoi(vertexData.substr(0, pos1)) - 1;  // Vertex index (a, d, g)
-		    int normalIndex = std::stoi(vertexData.substr(pos2 + 1)) - 1;  // Normal index (c, f, i)
-
-		    face.push_back(vertexIndex);  // Push vertex index
-		    face.push_back(normalIndex);  // Push normal index
-
-		}
-
-		faces.push_back(face);  // Add face to the list
-            } 
-        }
-	file.close();
-
-	// Create the new ImportShape and populate it
-	ImportShape* newShape = new ImportShape(0.0f, 0.0f, 0.0f, 1.0f, 1, shapeManager.incrementShapeCounter());
-	newShape->setVertices(vertices);
-	newShape->setNormals(normals);
-	newShape->setFaces(faces);	
-	newShape->setupShape();
-	
-	// Add importedShape to your list of shapes or render it directly
-	shapeManager.addShape(newShape);
-	shapeManager.setSelectedShapeByLastAdded();  // Select the last shape added
-	shapeManager.getSelectedShape()->setShapeType(newShapeType);
+        // Parse on a worker; only the GL upload comes back to this thread
+        const int id = shapeManager.incrementShapeCounter();
+        startImport(selectedFile, newShapeType,
+                    [this, id](ImportTask& task) { return loadObjShape(task.getFileName(), id, task); },
+                    [](Shape* shape) { static_cast<ImportShape*>(shape)->setupShape(); });
 
     }
   
@@ -147,8 +100,59 @@ int FileImporter::importObjFile(ShapeManager& shapeManager) {
     
 }
 
+// Worker half of importObjFile
+Shape* FileImporter::loadObjShape(const std::string& fileName, int id, ImportTask& task) {
+    PROFILE_SCOPE("FileImporter::loadObjShape");
+
+    MappedFile source;
+    if (!source.open(fileName)) {
+        std::cerr << "Unable to open file: " << fileName << std::endl;
+        return nullptr;
+    }
+
+    // A blob built from exactly this source skips parsing and interleaving altogether
+    const std::string cachePath = MeshCache::getCachePath(fileName);
+    const uint64_t sourceHash = MeshCache::hashBytes(source.begin(), source.end());
+    std::unique_ptr<CachedMesh> cached(new CachedMesh());
+    static_assert(MeshCache::VERTEX_FLOATS == ImportShape::VERTEX_STRIDE, "mesh cache and ImportShape vertex layouts differ");
+    if (MeshCache::load(cachePath, sourceHash, *cached)) {
+        ImportShape* newShape = new ImportShape(0.0f, 0.0f, 0.0f, 1.0f, 1, id);
+        newShape->setCachedMesh(std::move(cached));
+        task.setProgress(1.0f);
+        return newShape;
+    }
+
+    // Memory-mapped parse; faces come out as {v0, n0, v1, n1, v2, n2}
+    ObjData obj;
+    const bool parsed = ObjParser::parseBuffer(source.begin(), source.end(), ObjParser::VertexNormalPairs, obj,
+                                               [&task](float fraction) {
+        task.setProgress(0.9f * fraction);
+        return !task.isCancelled();
+    });
+    if (!parsed) {
+        return nullptr;
+    }
+
+    // Create the new ImportShape and populate it
+    ImportShape* newShape = new ImportShape(0.0f, 0.0f, 0.0f, 1.0f, 1, id);
+    newShape->setVertices(obj.vertices);
+    newShape->setNormals(obj.normals);
+    newShape->setFaceIndices(std::move(obj.faceIndices));
+
+    // Interleave and simplify here rather than in setupShape, and keep the result for next time
+    newShape->buildVertexData();
+    if (!MeshCache::store(cachePath, sourceHash, newShape->getVertexData(), newShape->getIndexData(),
+                          newShape->getLods(), newShape->getLocalBoundsMin(), newShape->getLocalBoundsMax())) {
+        std::cerr << "Could not write mesh cache: " << cachePath << std::endl;
+    }
+    task.setProgress(1.0f);
+
+    return newShape;
+}
+
 // Function to import a selected obj file
 int FileImporter::importSwpFile(ShapeManager& shapeManager) {
+    PROFILE_SCOPE("FileImporter::importSwpFile");
 
     std::string execDir = getExecutableDirectory();
     if (!execDir.empty()) {
@@ -183,119 +187,134 @@ int FileImporter::importSwpFile(ShapeManager& shapeManager) {
             newShapeType[i] = std::tolower(newShapeType[i]);
 	}
 		
-        std::ifstream file(selectedFile);
-        if (!file.is_open()) {
-            std::cerr << "Unable to open file: " << selectedFile << std::endl;
-            return 0;
-        }
+        // Evaluate curves and surfaces on a worker; buffers are created on this thread
+        const int id = shapeManager.incrementShapeCounter();
+        startImport(selectedFile, newShapeType,
+                    [this, id](ImportTask& task) { return loadSwpShape(task.getFileName(), id, task); },
+                    [](Shape* shape) {
+                        ImportCurve* importCurve = static_cast<ImportCurve*>(shape);
+                        importCurve->setupCurveBuffer();
+                        importCurve->setupSurfaceBuffer();
+                    });
+
+    }
+    return 1;
+}
+
+
+// Worker half of importSwpFile
+Shape* FileImporter::loadSwpShape(const std::string& fileName, int id, ImportTask& task) {
+    PROFILE_SCOPE("FileImporter::loadSwpShape");
+
+    std::ifstream file(fileName);
+    if (!file.is_open()) {
+        std::cerr << "Unable to open file: " << fileName << std::endl;
+        return nullptr;
+    }
 
-        ImportCurve* importCurve = new ImportCurve(0.0f, 0.0f, 0.0f, 1.0f, 30, shapeManager.incrementShapeCounter());
+    // Progress follows the read position
+    file.seekg(0, std::ios::end);
+    const float fileSize = static_cast<float>(file.tellg());
+    file.seekg(0, std::ios::beg);
 
-        std::string objType, objName;
-        unsigned steps;
-        float radius; // Variable to store radius for circle
+    ImportCurve* importCurve = new ImportCurve(0.0f, 0.0f, 0.0f, 1.0f, 30, id);
+
+    std::string objType, objName;
+    unsigned steps;
+    float radius; // Variable to store radius for circle
 		
-        while (file >> objType >> objName) {
+    while (!task.isCancelled() && file >> objType >> objName) {
 
-            if (objType == "bez2" || objType == "bsp2" || objType == "bez3" || objType == "bsp3") {
+        if (objType == "bez2" || objType == "bsp2" || objType == "bez3" || objType == "bsp3") {
+        
+            file >> steps;
             
-                file >> steps;
-                
 		// Create the new curve
 		Curve curve(objName, steps, objType);
 
-                // Determine the dimension based on the curve type
-                unsigned dim = (objType == "bez2" || objType == "bsp2") ? 2 : 3;
+            // Determine the dimension based on the curve type
+            unsigned dim = (objType == "bez2" || objType == "bsp2") ? 2 : 3;
 
-                // Pass the correct dimension to readCps
-                std::vector<glm::vec3> controlPoints = readCps(file, dim);
+            // Pass the correct dimension to readCps
+            std::vector<glm::vec3> controlPoints = readCps(file, dim);
 
 		// Read the controlpoints into the curve		
-                curve.setControlPoints(controlPoints);
-                
+            curve.setControlPoints(controlPoints);
+            
 		// Evaluate the controlpoints to vertices
 		CurvePoints newCurvePoints = (objType == "bez2" || objType == "bez3") ? 
-                    Curve::evalBezier(controlPoints, steps) : Curve::evalBspline(controlPoints, steps);
-                curve.setCurvePoints(newCurvePoints);
-                
-                // Add the curve to the ImportCurve object                
-                importCurve->addCurve(curve);
-                
-            } else if (objType == "circ") {
+                Curve::evalBezier(controlPoints, steps) : Curve::evalBspline(controlPoints, steps);
+            curve.setCurvePoints(newCurvePoints);
             
-                // Read the radius
-                file >> steps >> radius;
-                
-               // Create a new Curve object for the circle
-                Curve circleCurve(objName, steps, objType);
-
-                // Generate circle points using Curve::evalCircle
-                CurvePoints circlePoints = Curve::evalCircle(radius, steps);
-                circleCurve.setCurvePoints(circlePoints);
-
-                // Add the circle to the ImportCurve object
-                importCurve->addCurve(circleCurve);
-                
-            } else if (objType == "srev") {
-
-                // Read the curve name
-                file >> steps >> objName;
-
-                // Find the profile curve by name and add to the ImportCurve object
-                for (const auto& curve : importCurve->getCurves()) {
-                    if (curve.getName() == objName) {
-                        importCurve->addSurface(Surface::makeSurfRev(curve, steps));
-                    }
-                }
-                
-            } else if (objType == "gcyl") {
-
-                // Read the profile and sweep curve names
-                std::string profName, sweepName;
-                file >> profName >> sweepName;
-
-                // Find the profile and sweep curves by name
-                const Curve* profile = nullptr;
-                const Curve* sweep = nullptr;
-                for (const auto& curve : importCurve->getCurves()) {
-                    if (curve.getName() == profName) profile = &curve;
-                    if (curve.getName() == sweepName) sweep = &curve;
-                }
-
-                // Find the profile and sweep curves by name and add to the ImportCurve object
-                if (profile && sweep) {
-                    Surface surface = Surface::makeGenCyl(*profile, *sweep);
-                    importCurve->addSurface(surface);
-                } else {
-                    std::cerr << "Error: Could not find matching profile or sweep curve for gcyl.\n";
-                }
-                
-            }        
+            // Add the curve to the ImportCurve object                
+            importCurve->addCurve(curve);
+            
+        } else if (objType == "circ") {
+        
+            // Read the radius
+            file >> steps >> radius;
+            
+           // Create a new Curve object for the circle
+            Curve circleCurve(objName, steps, objType);
 
-        }
+            // Generate circle points using Curve::evalCircle
+            CurvePoints circlePoints = Curve::evalCircle(radius, steps);
+            circleCurve.setCurvePoints(circlePoints);
 
-        file.close();
-        
-        importCurve->setupCurveBuffer();
-        importCurve->setupSurfaceBuffer();
+            // Add the circle to the ImportCurve object
+            importCurve->addCurve(circleCurve);
+            
+        } else if (objType == "srev") {
 
-        // Add the ImportCurve object to ShapeManager
-        shapeManager.addShape(importCurve);
+            // Read the curve name
+            file >> steps >> objName;
 
-	// Add importedShape to your list of shapes or render it directly
-	shapeManager.setSelectedShapeByLastAdded();  // Select the last shape added
-	shapeManager.getSelectedShape()->setShapeType(newShapeType);
-	
-	// For debug
-        // importCurve->printControlPointsAndCurvePoints();
+            // Find the profile curve by name and add to the ImportCurve object
+            for (const auto& curve : importCurve->getCurves()) {
+                if (curve.getName() == objName) {
+                    importCurve->addSurface(Surface::makeSurfRev(curve, steps));
+                }
+            }
+            
+        } else if (objType == "gcyl") {
+
+            // Read the profile and sweep curve names
+            std::string profName, sweepName;
+            file >> profName >> sweepName;
+
+            // Find the profile and sweep curves by name
+            const Curve* profile = nullptr;
+            const Curve* sweep = nullptr;
+            for (const auto& curve : importCurve->getCurves()) {
+                if (curve.getName() == profName) profile = &curve;
+                if (curve.getName() == sweepName) sweep = &curve;
+            }
+
+            // Find the profile and sweep curves by name and add to the ImportCurve object
+            if (profile && sweep) {
+                Surface surface = Surface::makeGenCyl(*profile, *sweep);
+                importCurve->addSurface(surface);
+            } else {
+                std::cerr << "Error: Could not find matching profile or sweep curve for gcyl.\n";
+            }
+            
+        }        
 
+        const std::streamoff position = file.tellg();
+        if (fileSize > 0.0f && position >= 0) {
+            task.setProgress(0.95f * static_cast<float>(position) / fileSize);
+        }
     }
-    return 1;
-}
 
+    file.close();
+    task.setProgress(1.0f);
+
+    return importCurve;
+}
 
 // Function to import a selected obj file
 int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
+    PROFILE_SCOPE("FileImporter::importCharacterFile");
 
     std::string execDir = getExecutableDirectory();
     if (!execDir.empty()) {
@@ -330,172 +349,281 @@ int FileImporter::importCharacterFile(ShapeManager& shapeManager) {
 		newShapeType[i] = std::tolower(newShapeType[i]);
 	}
 							
-        std::vector<glm::vec3> vertices;
-	std::vector<std::vector<int>> faces;
-			
-	std::ifstream file(selectedFile);
-	if (!file.is_open()) {
-		std::cerr << "Unable to open file: " << selectedFile << std::endl;
-		return 0;
-	}
+	// Skeleton and mesh are read on a worker; buffers are created on this thread
+	const int id = shapeManager.incrementShapeCounter();
+	startImport(selectedFile, newShapeType,
+	            [this, id](ImportTask& task) { return loadCharacter(task.getFileName(), id, task); },
+	            [](Shape* shape) {
+	                ImportCharacter* importCharacter = static_cast<ImportCharacter*>(shape);
+	                importCharacter->setupMeshBuffer();
+	                importCharacter->setupSkeletonMeshes();
+	            });
 
-	std::string line;
-	while (std::getline(file, line)) {
-		std::istringstream ss(line);
-		std::string prefix;
-		std::vector<int> face;  // Store vertex and normal indices
-			
-		ss >> prefix;
-
-		if (prefix == "v") {
-			float x, y, z;
-			ss >> x >> y >> z;
-                        vertices.push_back(glm::vec3(x, y, z));
-		} else if (prefix == "f") {
-			int fx, fy, fz;
-			ss >> fx >> fy >> fz;
-			face.push_back(fx - 1);
-			face.push_back(fy - 1);
-			face.push_back(fz - 1);					
-			faces.push_back(face);
-		}
-	}
-	file.close();
-			
-	std::string selectedFileSkel = selectedFile;			
-	std::size_t pos = selectedFileSkel.find_last_of('.');
-
-	// Check if an extension exists; if so, replace it
-	if (pos != std::string::npos) {
-		selectedFileSkel = selectedFileSkel.substr(0, pos) + ".skel";
-	} else {
-		selectedFileSkel = selectedFileSkel + ".skel";				
-	}
+    }
 
-	Joint* rootJoint;
-	std::vector<Joint*> joints;
-	std::vector<int> parentIndices;
+    return 1;
 
-	std::ifstream fileSkel(selectedFileSkel);
-	if (!fileSkel.is_open()) {
-		std::cerr << "Unable to open .skel file: " << selectedFileSkel << std::endl;
-		return 0;
-	} else {
+}
 
-				std::string lineSkel;
 
-								
-				while(getline(fileSkel, lineSkel)){
-	
-					float x, y, z;
-					int parentIndex;
-					
+// Worker half of importCharacterFile: mesh, .skel and .attach next to it, plus an optional .anim clip
+Shape* FileImporter::loadCharacter(const std::string& fileName, int id, ImportTask& task) {
+    PROFILE_SCOPE("FileImporter::loadCharacter");
+
+    // Memory-mapped parse; faces come out as {v0, v1, v2}
+    ObjData obj;
+    const bool parsed = ObjParser::parseFile(fileName, ObjParser::VertexOnly, obj, [&task](float fraction) {
+        task.setProgress(0.6f * fraction);
+        return !task.isCancelled();
+    });
+    if (!parsed) {
+        if (!task.isCancelled()) {
+            std::cerr << "Unable to open file: " << fileName << std::endl;
+        }
+        return nullptr;
+    }
+    std::vector<glm::vec3>& vertices = obj.vertices;
+
+    // Shapes keep one index list per face
+    std::vector<std::vector<int>> faces(obj.getFaceCount());
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const int* face = obj.getFace(i);
+        faces[i].assign(face, face + 3);
+    }
+
+    std::string selectedFileSkel = fileName;
+    std::size_t pos = selectedFileSkel.find_last_of('.');
+
+    // Check if an extension exists; if so, replace it
+    if (pos != std::string::npos) {
+        selectedFileSkel = selectedFileSkel.substr(0, pos) + ".skel";
+    } else {
+        selectedFileSkel = selectedFileSkel + ".skel";
+    }
+
+    Joint* rootJoint;
+    std::vector<Joint*> joints;
+    std::vector<int> parentIndices;
+
+    std::ifstream fileSkel(selectedFileSkel);
+    if (!fileSkel.is_open()) {
+        std::cerr << "Unable to open .skel file: " << selectedFileSkel << std::endl;
+        return nullptr;
+    } else {
+
+        std::string lineSkel;
 
-					std::istringstream skeletonString;
-					skeletonString.str(lineSkel);
-					skeletonString >> x >> y >> z >> parentIndex;
+        while (getline(fileSkel, lineSkel)) {
 
-					Joint *joint = new Joint;
-                                       joint->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)));
+            float x, y, z;
+            int parentIndex;
 
-					joints.push_back(joint);
-					parentIndices.push_back(parentIndex);
+            std::istringstream skeletonString;
+            skeletonString.str(lineSkel);
+            skeletonString >> x >> y >> z >> parentIndex;
 
-				}
+            Joint *joint = new Joint;
+            joint->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, z)));
 
+            joints.push_back(joint);
+            parentIndices.push_back(parentIndex);
 
-				for (size_t i = 1; i < joints.size(); ++i) {
-					int parentIndex = parentIndices[i];
-					joints[parentIndex]->addChild(joints[i]);
-				}
+        }
 
-				rootJoint = joints.front();
+        for (size_t i = 1; i < joints.size(); ++i) {
+            int parentIndex = parentIndices[i];
+            joints[parentIndex]->addChild(joints[i]);
+        }
 
-			}
+        rootJoint = joints.front();
 
-			fileSkel.close();
+    }
 
-			
-			std::vector< std::vector< float > > attachments;
+    fileSkel.close();
+    task.setProgress(0.7f);
 
-			
-			std::string selectedFileAttach = selectedFile;			
-			pos = selectedFileAttach.find_last_of('.');
+    // The root owns every other joint
+    if (task.isCancelled()) {
+        delete rootJoint;
+        return nullptr;
+    }
 
-			// Check if an extension exists; if so, replace it
-			if (pos != std::string::npos) {
-				selectedFileAttach = selectedFileAttach.substr(0, pos) + ".attach";
-			} else {
-				selectedFileAttach = selectedFileAttach + ".attach";				
-			}
+    std::vector<SkinInfluences> influences;
 
-			std::ifstream fileAttach(selectedFileAttach);
-			if (!fileAttach.is_open()) {
-				std::cerr << "Unable to open .skel file: " << selectedFileAttach << std::endl;
-				return 0;
-			} else {
+    std::string selectedFileAttach = fileName;
+    pos = selectedFileAttach.find_last_of('.');
 
-				// Read the attachment weights
+    // Check if an extension exists; if so, replace it
+    if (pos != std::string::npos) {
+        selectedFileAttach = selectedFileAttach.substr(0, pos) + ".attach";
+    } else {
+        selectedFileAttach = selectedFileAttach + ".attach";
+    }
 
-				std::string lineAttach;
-								
-				while(getline(fileAttach, lineAttach)){
+    std::ifstream fileAttach(selectedFileAttach);
+    if (!fileAttach.is_open()) {
+        std::cerr << "Unable to open .skel file: " << selectedFileAttach << std::endl;
+        delete rootJoint;
+        return nullptr;
+    } else {
 
-					std::istringstream attachString;
+        // Read the attachment weights, keeping only the strongest few per vertex
 
-					float val;
-					attachString.str(lineAttach);
-					std::vector<float> attachList;
+        std::string lineAttach;
+        std::vector<float> attachList;
 
-					while(attachString >> val){
+        while (getline(fileAttach, lineAttach)) {
 
-						attachList.push_back(val);
+            std::istringstream attachString;
 
-					}
+            float val;
+            attachString.str(lineAttach);
+            attachList.clear();
 
-					attachments.push_back(attachList);
+            while (attachString >> val) {
 
-				}
+                attachList.push_back(val);
 
-			}
-			
-			// Get the shape type from the filename without the extension
-			
-			ImportCharacter* importCharacter = new ImportCharacter(0.0f, 0.0f, 0.0f, 1.0f, 12, shapeManager.incrementShapeCounter());
+            }
 
-			importCharacter->setVertices(vertices);
-			importCharacter->setFaces(faces);
-			importCharacter->calculateNormals();
-			importCharacter->setBindVertices(vertices);
-			importCharacter->getSkeletalModel().setRootJoint(rootJoint);
-			importCharacter->getSkeletalModel().setJoints(joints);
-			importCharacter->setAttachments(attachments);
+            influences.push_back(Skinning::compressAttachment(attachList));
 
-			importCharacter->getSkeletalModel().computeBindWorldToJointTransforms();
-			importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
+        }
 
-                        importCharacter->setupMeshBuffer();
-                        importCharacter->setupJointBuffer();
-                        importCharacter->setupBoneBuffer();
+    }
+    task.setProgress(0.85f);
 
-			// Add the ImportCharacter object to ShapeManager
-			shapeManager.addShape(importCharacter);	
+    if (task.isCancelled()) {
+        delete rootJoint;
+        return nullptr;
+    }
 
-			// Add ImportCharacter to your list of shapes or render it directly
+    ImportCharacter* importCharacter = new ImportCharacter(0.0f, 0.0f, 0.0f, 1.0f, 12, id);
 
-			shapeManager.setSelectedShapeByLastAdded();  // Select the last shape added
-			shapeManager.getSelectedShape()->setShapeType(newShapeType); 
-			
+    importCharacter->setVertices(vertices);
+    importCharacter->setFaces(faces);
+    importCharacter->calculateNormals();
+    importCharacter->setBindVertices(vertices);
+    importCharacter->getSkeletalModel().setRootJoint(rootJoint);
+    importCharacter->getSkeletalModel().setJoints(joints);
+    importCharacter->setInfluences(influences);
 
+    importCharacter->getSkeletalModel().computeBindWorldToJointTransforms();
+    importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
 
-		}
-	
+    // A keyframe clip is optional; without one the character is posed by hand
+    std::string selectedFileAnim = fileName;
+    pos = selectedFileAnim.find_last_of('.');
+    if (pos != std::string::npos) {
+        selectedFileAnim = selectedFileAnim.substr(0, pos) + ".anim";
+    } else {
+        selectedFileAnim = selectedFileAnim + ".anim";
+    }
 
-	return 1;
+    AnimationClip clip;
+    if (clip.loadFromFile(selectedFileAnim) && !clip.isEmpty()) {
+        importCharacter->setAnimationClip(clip);
+    }
+    task.setProgress(1.0f);
 
+    return importCharacter;
 }
 
 
+ImportTask::ImportTask(const std::string& fileName, const std::string& shapeType)
+    : fileName(fileName), shapeType(shapeType), progress(0.0f), cancelled(false), finished(false),
+      result(nullptr) {}
+
+ImportTask::~ImportTask() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+
+void FileImporter::startImport(const std::string& fileName, const std::string& shapeType,
+                               const std::function<Shape*(ImportTask&)>& load,
+                               const std::function<void(Shape*)>& createBuffers) {
+    tasks.push_back(std::unique_ptr<ImportTask>(new ImportTask(fileName, shapeType)));
+    ImportTask* task = tasks.back().get();
+    task->createBuffers = createBuffers;
+
+    // A dedicated thread rather than a job, so a whole import never occupies a
+    // worker that the frame's parallel loops need; its parse still fans out
+    task->worker = std::thread([task, load]() {
+#ifdef ENABLE_PROFILING
+        CpuProfiler::setThreadName("Import");
+#endif
+        task->result = load(*task);
+        task->finished.store(true, std::memory_order_release);
+    });
+}
+
+
+void FileImporter::update(ShapeManager& shapeManager) {
+    for (size_t i = 0; i < tasks.size();) {
+        ImportTask& task = *tasks[i];
+        if (!task.isFinished()) {
+            ++i;
+            continue;
+        }
+        task.worker.join();
+
+        if (task.result && !task.isCancelled()) {
+            PROFILE_SCOPE("FileImporter::update createBuffers");
+            task.createBuffers(task.result);
+
+            // Add the imported shape to the scene and select it
+            shapeManager.addShape(task.result);
+            shapeManager.setSelectedShapeByLastAdded();
+            shapeManager.getSelectedShape()->setShapeType(task.shapeType);
+        } else {
+            delete task.result; // Destructors touch GL, so this stays on the main thread
+        }
+
+        tasks.erase(tasks.begin() + i);
+    }
+}
+
+
+void FileImporter::drawProgress() {
+    if (tasks.empty()) {
+        return;
+    }
+
+    ImGuiIO& io = ImGui::GetIO();
+    ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x * 0.5f, io.DisplaySize.y - 20.0f), ImGuiCond_Always, ImVec2(0.5f, 1.0f));
+    ImGui::Begin("Importing", NULL, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoCollapse);
+
+    for (const std::unique_ptr<ImportTask>& task : tasks) {
+        ImGui::PushID(task.get());
+        ImGui::TextUnformatted(extractShapeType(task->getFileName()).c_str());
+        ImGui::ProgressBar(task->getProgress(), ImVec2(240.0f, 0.0f));
+        ImGui::SameLine();
+        if (task->isCancelled()) {
+            ImGui::TextDisabled("Cancelling...");
+        } else if (ImGui::Button("Cancel")) {
+            task->cancel();
+        }
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
+
+
+void FileImporter::cancelAll() {
+    for (const std::unique_ptr<ImportTask>& task : tasks) {
+        task->cancel();
+    }
+    for (const std::unique_ptr<ImportTask>& task : tasks) {
+        if (task->worker.joinable()) {
+            task->worker.join();
+        }
+        delete task->result;
+    }
+    tasks.clear();
+}
 
 
 // Extract shape type from file name
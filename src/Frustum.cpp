@@ -0,0 +1,85 @@
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+Frustum::Frustum() {
+    for (int i = 0; i < 6; ++i) {
+        planes[i] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+// Gribb-Hartmann plane extraction from the rows of the combined matrix
+void Frustum::extractPlanes(const glm::mat4& viewProjection) {
+    // glm is column-major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+    glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+    glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+    glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+    planes[0] = row3 + row0; // Left
+    planes[1] = row3 - row0; // Right
+    planes[2] = row3 + row1; // Bottom
+    planes[3] = row3 - row1; // Top
+    planes[4] = row3 + row2; // Near
+    planes[5] = row3 - row2; // Far
+
+    // Normalize so plane distances are in world units
+    for (int i = 0; i < 6; ++i) {
+        float length = glm::length(glm::vec3(planes[i]));
+        if (length > 0.0f) {
+            planes[i] /= length;
+        }
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int i = 0; i < 6; ++i) {
+        if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) const {
+    for (int i = 0; i < 6; ++i) {
+        glm::vec3 normal(planes[i]);
+
+        // Corner furthest along the plane normal
+        glm::vec3 positive(normal.x >= 0.0f ? maxCorner.x : minCorner.x,
+                           normal.y >= 0.0f ? maxCorner.y : minCorner.y,
+                           normal.z >= 0.0f ? maxCorner.z : minCorner.z);
+
+        if (glm::dot(normal, positive) + planes[i].w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::intersectsTransformedBounds(const glm::mat4& model,
+                                          const glm::vec3& localMin, const glm::vec3& localMax,
+                                          const glm::vec3& sphereCenter, float sphereRadius) const {
+
+    // Cheap sphere rejection first; the radius grows with the largest axis scale
+    glm::vec3 worldCenter = glm::vec3(model * glm::vec4(sphereCenter, 1.0f));
+    float maxScale = std::max(glm::length(glm::vec3(model[0])),
+                              std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    if (!intersectsSphere(worldCenter, sphereRadius * maxScale)) {
+        return false;
+    }
+
+    // Tighter test against the world-space AABB of the transformed local box
+    glm::vec3 localCenter = 0.5f * (localMin + localMax);
+    glm::vec3 localExtent = 0.5f * (localMax - localMin);
+
+    glm::vec3 boxCenter = glm::vec3(model * glm::vec4(localCenter, 1.0f));
+    glm::vec3 boxExtent(0.0f);
+    for (int column = 0; column < 3; ++column) {
+        glm::vec3 axis = glm::vec3(model[column]);
+        boxExtent += glm::abs(axis) * localExtent[column];
+    }
+
+    return intersectsBox(boxCenter - boxExtent, boxCenter + boxExtent);
+}
@@ -0,0 +1,234 @@
+#include "GpuProfiler.h"
+
+#ifdef ENABLE_PROFILING
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+// Static members
+GpuProfiler::Frame GpuProfiler::frames[GpuProfiler::FRAME_LATENCY];
+int GpuProfiler::currentFrame = 0;
+std::vector<int> GpuProfiler::openZones;
+std::vector<GpuProfiler::ZoneResult> GpuProfiler::results;
+bool GpuProfiler::enabled = true;
+bool GpuProfiler::perShapeTiming = false;
+int GpuProfiler::droppedFrames = 0;
+
+namespace {
+
+// Milliseconds on a monotonic clock
+double cpuNowMs() {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+
+void GpuProfiler::beginFrame() {
+
+    // Reuse the slot written FRAME_LATENCY frames ago, harvesting its results first
+    currentFrame = (currentFrame + 1) % FRAME_LATENCY;
+    Frame& frame = frames[currentFrame];
+    if (frame.pending && !collect(frame)) {
+        ++droppedFrames; // GPU is more than FRAME_LATENCY frames behind; never wait for it
+    }
+
+    frame.zones.clear();
+    frame.queriesUsed = 0;
+    frame.pending = false;
+    openZones.clear();
+
+    // Root zone spanning the whole frame
+    beginZone("Frame");
+}
+
+
+void GpuProfiler::endFrame() {
+
+    // Close the root zone and anything left open by mistake
+    while (!openZones.empty()) {
+        endZone();
+    }
+
+    // Only frames whose root zone was recorded can be read back
+    const Frame& frame = frames[currentFrame];
+    frames[currentFrame].pending = !frame.zones.empty() && frame.zones.front().depth == 0;
+}
+
+
+void GpuProfiler::beginZone(const std::string& name) {
+    if (!enabled) {
+        openZones.push_back(-1); // Keep begin/end balanced while disabled
+        return;
+    }
+
+    Frame& frame = frames[currentFrame];
+
+    Zone zone;
+    zone.name = name;
+    zone.depth = static_cast<int>(openZones.size());
+    zone.startQuery = acquireQuery(frame);
+    zone.endQuery = acquireQuery(frame);
+    zone.cpuStartMs = cpuNowMs();
+    zone.cpuEndMs = zone.cpuStartMs;
+
+    // Timestamps (unlike GL_TIME_ELAPSED queries) may nest and overlap
+    glQueryCounter(zone.startQuery, GL_TIMESTAMP);
+
+    openZones.push_back(static_cast<int>(frame.zones.size()));
+    frame.zones.push_back(zone);
+}
+
+
+void GpuProfiler::endZone() {
+    if (openZones.empty()) {
+        std::cerr << "GpuProfiler: endZone() without a matching beginZone()" << std::endl;
+        return;
+    }
+
+    int index = openZones.back();
+    openZones.pop_back();
+    if (index < 0) {
+        return;
+    }
+
+    Zone& zone = frames[currentFrame].zones[index];
+    glQueryCounter(zone.endQuery, GL_TIMESTAMP);
+    zone.cpuEndMs = cpuNowMs();
+}
+
+
+bool GpuProfiler::isPerShapeTimingEnabled() {
+    return enabled && perShapeTiming;
+}
+
+
+const std::vector<GpuProfiler::ZoneResult>& GpuProfiler::getResults() {
+    return results;
+}
+
+
+// Query objects are pooled per frame slot and only created when a frame needs more
+GLuint GpuProfiler::acquireQuery(Frame& frame) {
+    if (frame.queriesUsed == frame.queryPool.size()) {
+        GLuint query = 0;
+        glGenQueries(1, &query);
+        frame.queryPool.push_back(query);
+    }
+
+    return frame.queryPool[frame.queriesUsed++];
+}
+
+
+// Copy a finished frame into the results; returns false if the GPU is not done with it yet
+bool GpuProfiler::collect(Frame& frame) {
+
+    // Queries complete in order, and the root zone's end is issued last
+    GLint available = 0;
+    glGetQueryObjectiv(frame.zones.front().endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+        return false;
+    }
+
+    results.clear();
+    results.reserve(frame.zones.size());
+    for (const Zone& zone : frame.zones) {
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(zone.startQuery, GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(zone.endQuery, GL_QUERY_RESULT, &end);
+
+        ZoneResult result;
+        result.name = zone.name;
+        result.depth = zone.depth;
+        result.cpuMs = zone.cpuEndMs - zone.cpuStartMs;
+        result.gpuMs = end > start ? static_cast<double>(end - start) / 1.0e6 : 0.0;
+        results.push_back(result);
+    }
+
+    return true;
+}
+
+
+void GpuProfiler::drawPanel(bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(420, 300), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("GPU Profiler", open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Checkbox("Enabled", &enabled);
+    ImGui::SameLine();
+    ImGui::Checkbox("Per-shape zones", &perShapeTiming);
+    ImGui::Text("Results lag %d frames; dropped frames: %d", FRAME_LATENCY, droppedFrames);
+
+    ImGuiTableFlags flags = ImGuiTableFlags_Sortable | ImGuiTableFlags_SortTristate | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("GpuProfilerZones", 3, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Zone", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableSetupColumn("CPU ms", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableSetupColumn("GPU ms", ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+
+        // Unsorted rows keep call order and show nesting; sorted rows are flat
+        std::vector<size_t> order(results.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+
+        const ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+        bool sorted = sortSpecs && sortSpecs->SpecsCount > 0;
+        if (sorted) {
+            const int column = sortSpecs->Specs[0].ColumnIndex;
+            const bool ascending = sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+            std::stable_sort(order.begin(), order.end(), [column, ascending](size_t a, size_t b) {
+                const ZoneResult& ra = results[ascending ? a : b];
+                const ZoneResult& rb = results[ascending ? b : a];
+                if (column == 0) return ra.name < rb.name;
+                if (column == 1) return ra.cpuMs < rb.cpuMs;
+                return ra.gpuMs < rb.gpuMs;
+            });
+        }
+
+        for (size_t index : order) {
+            const ZoneResult& result = results[index];
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            const float indent = sorted ? 0.0f : result.depth * 10.0f;
+            if (indent > 0.0f) {
+                ImGui::Indent(indent);
+            }
+            ImGui::TextUnformatted(result.name.c_str());
+            if (indent > 0.0f) {
+                ImGui::Unindent(indent);
+            }
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", result.cpuMs);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", result.gpuMs);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+
+void GpuProfiler::release() {
+    for (Frame& frame : frames) {
+        if (!frame.queryPool.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queryPool.size()), frame.queryPool.data());
+        }
+        frame.queryPool.clear();
+        frame.zones.clear();
+        frame.queriesUsed = 0;
+        frame.pending = false;
+    }
+    results.clear();
+}
+
+#endif // ENABLE_PROFILING
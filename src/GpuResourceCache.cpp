@@ -0,0 +1,206 @@
+#include "GpuResourceCache.h"
+
+#include <iostream>
+
+namespace {
+
+// Allocation counters for the current and the previous frame
+int objectsCreated = 0;
+int objectsDeleted = 0;
+int objectsCreatedLastFrame = 0;
+int objectsDeletedLastFrame = 0;
+
+// Original glad entry points, captured before the counting wrappers are installed
+PFNGLGENBUFFERSPROC originalGenBuffers = nullptr;
+PFNGLDELETEBUFFERSPROC originalDeleteBuffers = nullptr;
+PFNGLGENVERTEXARRAYSPROC originalGenVertexArrays = nullptr;
+PFNGLDELETEVERTEXARRAYSPROC originalDeleteVertexArrays = nullptr;
+PFNGLGENTEXTURESPROC originalGenTextures = nullptr;
+PFNGLDELETETEXTURESPROC originalDeleteTextures = nullptr;
+PFNGLGENQUERIESPROC originalGenQueries = nullptr;
+PFNGLDELETEQUERIESPROC originalDeleteQueries = nullptr;
+
+void APIENTRY countingGenBuffers(GLsizei n, GLuint* buffers) {
+    objectsCreated += n;
+    originalGenBuffers(n, buffers);
+}
+
+void APIENTRY countingDeleteBuffers(GLsizei n, const GLuint* buffers) {
+    objectsDeleted += n;
+    originalDeleteBuffers(n, buffers);
+}
+
+void APIENTRY countingGenVertexArrays(GLsizei n, GLuint* arrays) {
+    objectsCreated += n;
+    originalGenVertexArrays(n, arrays);
+}
+
+void APIENTRY countingDeleteVertexArrays(GLsizei n, const GLuint* arrays) {
+    objectsDeleted += n;
+    originalDeleteVertexArrays(n, arrays);
+}
+
+void APIENTRY countingGenTextures(GLsizei n, GLuint* textures) {
+    objectsCreated += n;
+    originalGenTextures(n, textures);
+}
+
+void APIENTRY countingDeleteTextures(GLsizei n, const GLuint* textures) {
+    objectsDeleted += n;
+    originalDeleteTextures(n, textures);
+}
+
+void APIENTRY countingGenQueries(GLsizei n, GLuint* ids) {
+    objectsCreated += n;
+    originalGenQueries(n, ids);
+}
+
+void APIENTRY countingDeleteQueries(GLsizei n, const GLuint* ids) {
+    objectsDeleted += n;
+    originalDeleteQueries(n, ids);
+}
+
+}
+
+
+GpuResourceCache::GpuResourceCache() {}
+
+GpuResourceCache::~GpuResourceCache() {
+    release();
+}
+
+void GpuResourceCache::release() {
+    for (auto& entry : helpers) {
+        glDeleteVertexArrays(1, &entry.second.VAO);
+        glDeleteBuffers(1, &entry.second.VBO);
+    }
+    helpers.clear();
+}
+
+
+// Axis lines along X (red), Y (green) and Z (blue)
+std::vector<float> GpuResourceCache::buildAxisVertices() {
+    return {
+        // Positions             // Colors
+        -50.0f,  0.0f,  0.0f,    1.0f, 0.0f, 0.0f,
+         50.0f,  0.0f,  0.0f,    1.0f, 0.0f, 0.0f,
+
+          0.0f,-50.0f,  0.0f,    0.0f, 1.0f, 0.0f,
+          0.0f, 50.0f,  0.0f,    0.0f, 1.0f, 0.0f,
+
+          0.0f,  0.0f,-50.0f,    0.0f, 0.0f, 1.0f,
+          0.0f,  0.0f, 50.0f,    0.0f, 0.0f, 1.0f
+    };
+}
+
+// Ground grid on the XZ plane
+std::vector<float> GpuResourceCache::buildGridVertices() {
+    const int halfLines = 10;
+    const float spacing = 0.5f;
+    const float extent = halfLines * spacing;
+    const float shade = 0.35f;
+
+    std::vector<float> gridVertices;
+    gridVertices.reserve((2 * halfLines + 1) * 4 * 6);
+
+    for (int i = -halfLines; i <= halfLines; ++i) {
+        float offset = i * spacing;
+
+        // Line parallel to X
+        gridVertices.insert(gridVertices.end(), {-extent, 0.0f, offset, shade, shade, shade});
+        gridVertices.insert(gridVertices.end(), { extent, 0.0f, offset, shade, shade, shade});
+
+        // Line parallel to Z
+        gridVertices.insert(gridVertices.end(), {offset, 0.0f, -extent, shade, shade, shade});
+        gridVertices.insert(gridVertices.end(), {offset, 0.0f,  extent, shade, shade, shade});
+    }
+
+    return gridVertices;
+}
+
+
+const GpuResourceCache::HelperMesh& GpuResourceCache::getAxis() {
+    return getOrCreate("axis", GL_LINES, &GpuResourceCache::buildAxisVertices);
+}
+
+const GpuResourceCache::HelperMesh& GpuResourceCache::getGrid() {
+    return getOrCreate("grid", GL_LINES, &GpuResourceCache::buildGridVertices);
+}
+
+
+const GpuResourceCache::HelperMesh& GpuResourceCache::getOrCreate(const std::string& key, GLenum mode,
+                                                                  std::vector<float> (*buildVertices)()) {
+    auto it = helpers.find(key);
+    if (it != helpers.end()) {
+        return it->second;
+    }
+
+    std::vector<float> vertexData = buildVertices();
+
+    HelperMesh mesh;
+    mesh.mode = mode;
+    mesh.vertexCount = static_cast<GLsizei>(vertexData.size() / 6);
+
+    glGenVertexArrays(1, &mesh.VAO);
+    glGenBuffers(1, &mesh.VBO);
+
+    glBindVertexArray(mesh.VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+
+    // Positions -> location 0
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // Colors -> location 2
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return helpers.insert(std::make_pair(key, mesh)).first->second;
+}
+
+
+void GpuResourceCache::installAllocationCounters() {
+
+    // Only install once, and only after glad has loaded the entry points
+    if (originalGenBuffers != nullptr || glad_glGenBuffers == nullptr) {
+        return;
+    }
+
+    originalGenBuffers = glad_glGenBuffers;
+    originalDeleteBuffers = glad_glDeleteBuffers;
+    originalGenVertexArrays = glad_glGenVertexArrays;
+    originalDeleteVertexArrays = glad_glDeleteVertexArrays;
+    originalGenTextures = glad_glGenTextures;
+    originalDeleteTextures = glad_glDeleteTextures;
+    originalGenQueries = glad_glGenQueries;
+    originalDeleteQueries = glad_glDeleteQueries;
+
+    glad_glGenBuffers = countingGenBuffers;
+    glad_glDeleteBuffers = countingDeleteBuffers;
+    glad_glGenVertexArrays = countingGenVertexArrays;
+    glad_glDeleteVertexArrays = countingDeleteVertexArrays;
+    glad_glGenTextures = countingGenTextures;
+    glad_glDeleteTextures = countingDeleteTextures;
+    glad_glGenQueries = countingGenQueries;
+    glad_glDeleteQueries = countingDeleteQueries;
+}
+
+// Latch the counts of the frame that just finished and start counting the next one
+void GpuResourceCache::beginFrame() {
+    objectsCreatedLastFrame = objectsCreated;
+    objectsDeletedLastFrame = objectsDeleted;
+    objectsCreated = 0;
+    objectsDeleted = 0;
+}
+
+int GpuResourceCache::getObjectsCreatedLastFrame() {
+    return objectsCreatedLastFrame;
+}
+
+int GpuResourceCache::getObjectsDeletedLastFrame() {
+    return objectsDeletedLastFrame;
+}
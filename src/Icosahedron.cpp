@@ -2,23 +2,18 @@
 
 Icosahedron::Icosahedron(float x, float y, float z, float uniformScale, int colorIndex, int id,
                float scaleX, float scaleY, float scaleZ, bool useUniformScaling)
-    : Shape(x, y, z, uniformScale, colorIndex, id, scaleX, scaleY, scaleZ, useUniformScaling), VAO(0), VBO(0), EBO(0) {
+    : Shape(x, y, z, uniformScale, colorIndex, id, scaleX, scaleY, scaleZ, useUniformScaling) {
     shapeType = "Icosahedron";
 
-    setupIcosahedron();      // Prepare OpenGL buffers
+    mesh = MeshRegistry::acquire("Icosahedron", 0, &Icosahedron::buildMesh); // Shared geometry, uploaded once per primitive type
+    setLocalBounds(mesh->boundsMin, mesh->boundsMax);
 
 }
 
-Icosahedron::~Icosahedron() {
-    // Cleanup OpenGL resources
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-}
-
-void Icosahedron::setupIcosahedron() {
-    std::vector<float> vertexData;
-    std::vector<unsigned int> indexData;
+MeshData Icosahedron::buildMesh(int lod) {
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<std::vector<int>> faces;
 
     // Scale factor
     float scaleFactor = 0.7f;  // Adjust this value to make the shape smaller or larger
@@ -50,63 +45,29 @@ void Icosahedron::setupIcosahedron() {
         {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
     };
 
-    calculateNormals(); // Compute normals for lighting
+    normals = calculateFaceNormals(vertices, faces); // Compute normals for lighting
 
     // Build vertex data and index data for OpenGL
     
+    MeshData data;
+    data.vertexData.reserve(faces.size() * 3 * 6);
+    data.indexData.reserve(faces.size() * 3);
+
     for (size_t i = 0; i < faces.size(); ++i) {
     
         glm::vec3 normal = normals[i]; // Assign face normal
-        glm::vec3 color = (colorIndex == 31) 
-            ? glm::vec3(
-                customColor[0], 
-                customColor[1], 
-                customColor[2]
-            )
-            : glm::vec3(
-                colorPresets[colorIndex].color[0], 
-                colorPresets[colorIndex].color[1], 
-                colorPresets[colorIndex].color[2]
-             );
 
         for (int j = 0; j < 3; ++j) {
             int vertexIndex = faces[i][j];
-            const glm::vec3& position = vertices[vertexIndex];
 
-            // Append position, normal, and color to vertexData
-            vertexData.insert(vertexData.end(), {position.x, position.y, position.z});
-            vertexData.insert(vertexData.end(), {normal.x, normal.y, normal.z});
-            vertexData.insert(vertexData.end(), {color.r, color.g, color.b});
+            // Append position and normal; the color comes from the material uniform
+            data.addVertex(vertices[vertexIndex], normal);
         }
 
-        indexData.insert(indexData.end(), {static_cast<unsigned int>(i * 3), static_cast<unsigned int>(i * 3 + 1), static_cast<unsigned int>(i * 3 + 2)});
+        data.indexData.insert(data.indexData.end(), {static_cast<unsigned int>(i * 3), static_cast<unsigned int>(i * 3 + 1), static_cast<unsigned int>(i * 3 + 2)});
     }
 
-    // Create and bind VAO, VBO, and EBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
-
-    // Configure vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0); // Position
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float))); // Color
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0); // Unbind VAO
-    
+    return data;
 }
 
 void Icosahedron::draw(GLuint shaderProgram) {
@@ -130,8 +91,8 @@ void Icosahedron::draw(GLuint shaderProgram) {
     }
 
     // Render the cube
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(mesh->VAO);
+    glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 
     // Disable lighting after drawing the cube (for axis rendering)
@@ -140,3 +101,9 @@ void Icosahedron::draw(GLuint shaderProgram) {
     }
 }
 
+
+// Queue the icosahedron for batched rendering
+bool Icosahedron::submit(RenderQueue& queue) {
+    queue.submit(mesh->VAO, mesh->indexCount, getMaterialColor(), getModelMatrix(), getNormalMatrix());
+    return true;
+}
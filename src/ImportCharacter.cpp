@@ -1,35 +1,84 @@
 #include "ImportCharacter.h"
+#include "CompactVertex.h"
+#include "CpuProfiler.h"
+#include "Cube.h"
+#include "Skinning.h"
+#include "Sphere.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <limits>
+
+const GLuint ImportCharacter::SKINNING_PALETTE_BINDING;
+const size_t ImportCharacter::MAX_SKIN_JOINTS;
+const GLuint ImportCharacter::CROWD_PALETTE_TEXTURE_UNIT;
+const float ImportCharacter::JOINT_RADIUS = 0.02f;
+const float ImportCharacter::BONE_WIDTH = 0.01f;
+
+bool ImportCharacter::gpuSkinning = true;
+GLuint ImportCharacter::skinnedShaderProgram = 0;
 
 ImportCharacter::ImportCharacter(float x, float y, float z, float scale, int colorIndex, int id)
-    : Shape(x, y, z, scale, colorIndex, id), m_skeletalModel(),
+    : Shape(x, y, z, scale, colorIndex, id),
+      meshMode(MESH_POSED), meshInfluenceVBO(0), paletteUBO(0), meshPositionVBO(0), streamedPositionsLost(true),
+      skeletonInstancesStale(true),
+      m_skeletalModel(),
+      animationTime(0.0f), animationPending(false),
+      crowdSpacing(0.6f), crowdPoseStale(false), crowdPaletteStale(false), boundsStale(true), boundsCoverCrowd(false),
+      crowdPaletteBuffer(0), crowdPaletteTexture(0), crowdDrawCount(0),
       meshVAO(0), meshVBO(0), meshEBO(0), 
-      jointVAO(0), jointVBO(0), jointEBO(0), 
-      boneVAO(0), boneVBO(0), boneEBO(0),
-      jointIndexCount(0), boneIndexCount(0) {
+      meshCompact(false), meshDecodeOffset(0.0f), meshDecodeScale(0.0f) {
 
+    crowd.layoutGrid(1, crowdSpacing, 0.0f);
 }
 
 ImportCharacter::~ImportCharacter() {
     glDeleteVertexArrays(1, &meshVAO);
     glDeleteBuffers(1, &meshVBO);
     glDeleteBuffers(1, &meshEBO);
+    glDeleteBuffers(1, &meshInfluenceVBO);
+    glDeleteBuffers(1, &meshPositionVBO);
+    glDeleteBuffers(1, &paletteUBO);
+    glDeleteBuffers(1, &crowdPaletteBuffer);
+    glDeleteTextures(1, &crowdPaletteTexture);
+}
 
-    glDeleteVertexArrays(1, &jointVAO);
-    glDeleteBuffers(1, &jointVBO);
-    glDeleteBuffers(1, &jointEBO);
+bool ImportCharacter::isGpuSkinningEnabled() {
+    return gpuSkinning;
+}
 
-    glDeleteVertexArrays(1, &boneVAO);
-    glDeleteBuffers(1, &boneVBO);
-    glDeleteBuffers(1, &boneEBO);
+void ImportCharacter::setGpuSkinningEnabled(bool enabled) {
+    gpuSkinning = enabled;
 }
 
+void ImportCharacter::setSkinnedShaderProgram(GLuint program) {
+    skinnedShaderProgram = program;
+}
+
+
+// Posed mesh, skinned on the CPU
 void ImportCharacter::setupMeshBuffer() {
+    buildMeshBuffer(vertices, MESH_POSED);
+}
+
+// One vertex per face corner with the face normal. MESH_GPU_SKINNED adds the
+// corner's influences at locations 3 (joints) and 4 (weights); MESH_STREAMED
+// moves positions into their own dynamic buffer for writeSkinnedPositions and
+// stores corners in skinningBind's vertex-major slot order
+void ImportCharacter::buildMeshBuffer(const std::vector<glm::vec3>& positions, MeshBufferMode mode) {
+    const bool skinned = (mode == MESH_GPU_SKINNED);
+    meshMode = mode;
 
     // Clear existing data
     if (meshVAO) glDeleteVertexArrays(1, &meshVAO);
     if (meshVBO) glDeleteBuffers(1, &meshVBO);
     if (meshEBO) glDeleteBuffers(1, &meshEBO);
+    if (meshInfluenceVBO) glDeleteBuffers(1, &meshInfluenceVBO);
+    if (meshPositionVBO) glDeleteBuffers(1, &meshPositionVBO);
+    meshInfluenceVBO = 0;
+    meshPositionVBO = 0;
 
     // Collect vertices, normals, colors, and indices
     std::vector<float> meshVertices;
@@ -52,7 +101,7 @@ void ImportCharacter::setupMeshBuffer() {
 
         for (int j = 0; j < 3; ++j) {
             int vertexIndex = faces[i][j];
-            const glm::vec3& position = vertices[vertexIndex];
+            const glm::vec3& position = positions[vertexIndex];
 
             // Append position, normal, and color to meshVertices
             meshVertices.insert(meshVertices.end(), {position.x, position.y, position.z});
@@ -63,6 +112,14 @@ void ImportCharacter::setupMeshBuffer() {
         meshIndices.insert(meshIndices.end(), {static_cast<unsigned int>(i * 3), static_cast<unsigned int>(i * 3 + 1), static_cast<unsigned int>(i * 3 + 2)});
     }
 
+    // Each streamed face corner is drawn from the slot the skinning kernel fills
+    const std::vector<uint32_t>& slotCorners = skinningBind.corners;
+    if (mode == MESH_STREAMED) {
+        for (size_t s = 0; s < slotCorners.size(); ++s) {
+            meshIndices[slotCorners[s]] = static_cast<unsigned int>(s);
+        }
+    }
+
     // Create and bind meshVAO, meshVBO, and meshEBO
     glGenVertexArrays(1, &meshVAO);
     glGenBuffers(1, &meshVBO);
@@ -70,216 +127,242 @@ void ImportCharacter::setupMeshBuffer() {
 
     glBindVertexArray(meshVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
-    glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(float), meshVertices.data(), GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshEBO);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshIndices.size() * sizeof(unsigned int), meshIndices.data(), GL_STATIC_DRAW);
 
-    // Configure vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0); // Position
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float))); // Color
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0); // Unbind meshVAO
-}
+    // Quantization box: the culling bounds for a posed mesh, the bind pose's own box when skinned
+    glm::vec3 boundsMin = getLocalBoundsMin();
+    glm::vec3 boundsMax = getLocalBoundsMax();
+    if (skinned && !positions.empty()) {
+        boundsMin = boundsMax = positions[0];
+        for (size_t i = 1; i < positions.size(); ++i) {
+            boundsMin = glm::min(boundsMin, positions[i]);
+            boundsMax = glm::max(boundsMax, positions[i]);
+        }
+    }
 
+    // Configure vertex attributes
+    glBindBuffer(GL_ARRAY_BUFFER, meshVBO);
+    meshCompact = VertexCompression::isEnabled() && !positions.empty() && (skinned || hasBounds()) &&
+                  mode != MESH_STREAMED;
+    if (mode == MESH_STREAMED) {
+        // Normals and colors never change; positions are rewritten in place each pose
+        meshDecodeOffset = glm::vec3(0.0f);
+        meshDecodeScale = glm::vec3(0.0f);
+
+        std::vector<float> staticAttributes;
+        staticAttributes.reserve(slotCorners.size() * 6);
+        for (size_t s = 0; s < slotCorners.size(); ++s) {
+            const size_t corner = slotCorners[s] * 9;
+            staticAttributes.insert(staticAttributes.end(), meshVertices.begin() + corner + 3, meshVertices.begin() + corner + 9);
+        }
+        glBufferData(GL_ARRAY_BUFFER, staticAttributes.size() * sizeof(float), staticAttributes.data(), GL_STATIC_DRAW);
 
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); // Normal
+        glEnableVertexAttribArray(1);
 
-void ImportCharacter::setupJointBuffer() {
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); // Color
+        glEnableVertexAttribArray(2);
 
-    // 3.2.2.1. Build the joint mesh using GL_POINTS or you can
-    // build a sphere mesh, and create the buffer VAO, VBO, and  
-    // EBO for use.
-    // 
-    
-    if (jointVAO) glDeleteVertexArrays(1, &jointVAO);
-    if (jointVBO) glDeleteBuffers(1, &jointVBO);
-    if (jointEBO) glDeleteBuffers(1, &jointEBO);
+        glGenBuffers(1, &meshPositionVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, meshPositionVBO);
+        glBufferData(GL_ARRAY_BUFFER, slotCorners.size() * 3 * sizeof(float), nullptr, GL_STREAM_DRAW);
 
-    std::vector<glm::vec3> jointVertices;
-    std::vector<glm::vec3> jointNormals;
-    std::vector<glm::uvec3> jointFaces;
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0); // Position
+        glEnableVertexAttribArray(0);
+    } else if (meshCompact) {
+        // 12 bytes per vertex instead of 36; the lit shader takes color from material.color
+        std::vector<CompactVertex> compactVertices;
+        VertexCompression::compress(meshVertices.data(), 9, 3, meshVertices.size() / 9,
+                                    boundsMin, boundsMax, compactVertices);
+        meshDecodeOffset = VertexCompression::getDecodeOffset(boundsMin);
+        meshDecodeScale = VertexCompression::getDecodeScale(boundsMin, boundsMax);
 
-    for (const auto& joint : m_skeletalModel.getJoints()) {
-        glm::vec3 center = glm::vec3(joint->getCurrentJointToWorldTransform() * glm::vec4(0,0,0,1));
+        glBufferData(GL_ARRAY_BUFFER, compactVertices.size() * sizeof(CompactVertex), compactVertices.data(), GL_STATIC_DRAW);
+        VertexCompression::configureAttributes();
+    } else {
+        meshDecodeOffset = glm::vec3(0.0f);
+        meshDecodeScale = glm::vec3(0.0f);
 
-        unsigned int baseIndex = jointVertices.size();
+        glBufferData(GL_ARRAY_BUFFER, meshVertices.size() * sizeof(float), meshVertices.data(), GL_STATIC_DRAW);
 
-        std::vector<glm::vec3> localVertices;
-        std::vector<glm::vec3> localNormals;
-        std::vector<glm::uvec3> localFaces;
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0); // Position
+        glEnableVertexAttribArray(0);
 
-        generateSphere(0.02f, center, localVertices, localNormals, localFaces);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
+        glEnableVertexAttribArray(1);
 
-        jointVertices.insert(jointVertices.end(), localVertices.begin(), localVertices.end());
-        jointNormals.insert(jointNormals.end(), localNormals.begin(), localNormals.end());
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float))); // Color
+        glEnableVertexAttribArray(2);
+    }
 
-        for (auto& f : localFaces) {
-            jointFaces.push_back(glm::uvec3(f.x + baseIndex, f.y + baseIndex, f.z + baseIndex));
+    if (skinned) {
+        std::vector<SkinInfluences> cornerInfluences;
+        cornerInfluences.reserve(faces.size() * 3);
+        for (size_t i = 0; i < faces.size(); ++i) {
+            for (int j = 0; j < 3; ++j) {
+                cornerInfluences.push_back(influences[faces[i][j]]);
+            }
         }
-    }
 
-    jointIndexCount = jointFaces.size() * 3;
+        glGenBuffers(1, &meshInfluenceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, meshInfluenceVBO);
+        glBufferData(GL_ARRAY_BUFFER, cornerInfluences.size() * sizeof(SkinInfluences), cornerInfluences.data(), GL_STATIC_DRAW);
 
-    std::vector<float> vertexData;
-    for (size_t i = 0; i < jointVertices.size(); ++i) {
-        vertexData.push_back(jointVertices[i].x);
-        vertexData.push_back(jointVertices[i].y);
-        vertexData.push_back(jointVertices[i].z);
+        // Joint indices -> location 3 (integer), weights -> location 4 (normalized to [0, 1])
+        glVertexAttribIPointer(3, 4, GL_UNSIGNED_BYTE, sizeof(SkinInfluences), (void*)offsetof(SkinInfluences, joints));
+        glEnableVertexAttribArray(3);
 
-        vertexData.push_back(jointNormals[i].x);
-        vertexData.push_back(jointNormals[i].y);
-        vertexData.push_back(jointNormals[i].z);
+        glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SkinInfluences), (void*)offsetof(SkinInfluences, weights));
+        glEnableVertexAttribArray(4);
     }
 
-    std::vector<unsigned int> indices;
-    for (auto& f : jointFaces) {
-        indices.push_back(f.x);
-        indices.push_back(f.y);
-        indices.push_back(f.z);
-    }
+    glBindVertexArray(0); // Unbind meshVAO
+}
 
-    glGenVertexArrays(1, &jointVAO);
-    glGenBuffers(1, &jointVBO);
-    glGenBuffers(1, &jointEBO);
 
-    glBindVertexArray(jointVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, jointVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
+// Joints and bones reuse the primitives' shared meshes: the 0.5-radius
+// sphere and the unit cube, uploaded once however many characters draw them
+void ImportCharacter::setupSkeletonMeshes() {
+    jointMesh = MeshRegistry::acquire("Sphere", 0, &Sphere::buildMesh);
+    boneMesh = MeshRegistry::acquire("Cube", 0, &Cube::buildMesh);
+    skeletonInstancesStale = true;
+}
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, jointEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+// Getter for bindVertices
+const std::vector<glm::vec3>& ImportCharacter::getBindVertices() const {
+    return bindVertices;
+}
 
-    glBindVertexArray(0);
+// Setter for bindVertices
+void ImportCharacter::setBindVertices(const std::vector<glm::vec3>& vertices) {
+    bindVertices = vertices;
+    jointBoundsMin.clear();
+    boundsStale = true;
+}
 
+// Getter for skeletal model
+SkeletalModel& ImportCharacter::getSkeletalModel() {
+    return m_skeletalModel;
 }
 
-void ImportCharacter::setupBoneBuffer() {
+// Set joint transform by index
+void ImportCharacter::setJointTransform(int jointIndex, float rX, float rY, float rZ) {
+    m_skeletalModel.setJointTransform(jointIndex, rX, rY, rZ);
+}
 
-    // 3.2.2.2. Build the bone mesh using GL_LINES or you can
-    // build a cube or cuboid mesh, and create the buffer VAO, VBO, and  
-    // EBO for use.
-    // 
-    //
-    
-    if (boneVAO) glDeleteVertexArrays(1, &boneVAO);
-    if (boneVBO) glDeleteBuffers(1, &boneVBO);
-    if (boneEBO) glDeleteBuffers(1, &boneEBO);
+// Getter for attachments
+const std::vector<SkinInfluences>& ImportCharacter::getInfluences() const {
+    return influences;
+}
 
-    std::vector<glm::vec3> boneVertices;
-    std::vector<glm::vec3> boneNormals;
-    std::vector<glm::uvec3> boneFaces;
+// Setter for attachments
+void ImportCharacter::setInfluences(const std::vector<SkinInfluences>& influences) {
+    this->influences = influences;
+    jointBoundsMin.clear();
+    boundsStale = true;
+}
 
-    for (const auto& joint : m_skeletalModel.getJoints()) {
-        glm::vec3 parentPos = glm::vec3(joint->getCurrentJointToWorldTransform() * glm::vec4(0,0,0,1));
+void ImportCharacter::setAnimationClip(const AnimationClip& clip) {
+    animationClip = clip;
+    animationTime = 0.0f;
+    animationPending = true;
+    crowd.resetPlayheads(animationClip.getDuration());
+}
 
-        for (const auto& child : joint->getChildren()) {
-            glm::vec3 childPos = glm::vec3(child->getCurrentJointToWorldTransform() * glm::vec4(0,0,0,1));
+const AnimationClip& ImportCharacter::getAnimationClip() const {
+    return animationClip;
+}
 
-            unsigned int baseIndex = boneVertices.size();
+bool ImportCharacter::hasAnimationClip() const {
+    return !animationClip.isEmpty();
+}
 
-            std::vector<glm::vec3> localVertices;
-            std::vector<glm::vec3> localNormals;
-            std::vector<glm::uvec3> localFaces;
+float ImportCharacter::getAnimationTime() const {
+    return animationTime;
+}
 
-            generateCuboid(parentPos, childPos, localVertices, localNormals, localFaces);
+void ImportCharacter::resetAnimation() {
+    animationTime = 0.0f;
+    animationPending = true;
+    crowd.resetPlayheads(animationClip.getDuration());
+}
 
-            boneVertices.insert(boneVertices.end(), localVertices.begin(), localVertices.end());
-            boneNormals.insert(boneNormals.end(), localNormals.begin(), localNormals.end());
+bool ImportCharacter::advanceAnimation(float elapsed) {
+    if (elapsed > 0.0f) {
+        // Loop, keeping the playhead small so it does not lose precision
+        animationTime += elapsed;
+        const float duration = animationClip.getDuration();
+        animationTime = duration > 0.0f ? std::fmod(animationTime, duration) : 0.0f;
+        animationPending = true;
 
-            for (auto& f : localFaces) {
-                boneFaces.push_back(glm::uvec3(f.x + baseIndex, f.y + baseIndex, f.z + baseIndex));
-            }
+        if (isCrowd()) {
+            crowd.advance(elapsed, duration);
         }
     }
 
-    boneIndexCount = boneFaces.size() * 3;
-
-    std::vector<float> vertexData;
-    for (size_t i = 0; i < boneVertices.size(); ++i) {
-        vertexData.push_back(boneVertices[i].x);
-        vertexData.push_back(boneVertices[i].y);
-        vertexData.push_back(boneVertices[i].z);
+    const bool pending = animationPending;
+    animationPending = false;
+    return pending;
+}
 
-        vertexData.push_back(boneNormals[i].x);
-        vertexData.push_back(boneNormals[i].y);
-        vertexData.push_back(boneNormals[i].z);
+size_t ImportCharacter::queueAnimation(AnimationBatch& batch) const {
+    const size_t firstTrack = batch.add(animationClip, animationTime);
+    if (isCrowdDrawn()) {
+        crowd.queueAnimation(animationClip, batch);
     }
+    return firstTrack;
+}
 
-    // Flatten face indices
-    std::vector<unsigned int> indices;
-    for (auto& f : boneFaces) {
-        indices.push_back(f.x);
-        indices.push_back(f.y);
-        indices.push_back(f.z);
+void ImportCharacter::applyAnimationPose(const AnimationBatch& batch, size_t firstTrack) {
+    const size_t trackStride = animationClip.getTrackCount();
+    const size_t trackCount = std::min(trackStride, m_skeletalModel.getJointCount());
+    for (size_t j = 0; j < trackCount; ++j) {
+        if (batch.isAnimated(firstTrack + j)) {
+            m_skeletalModel.setJointRotation(static_cast<int>(j), batch.getRotation(firstTrack + j));
+        }
     }
 
-    glGenVertexArrays(1, &boneVAO);
-    glGenBuffers(1, &boneVBO);
-    glGenBuffers(1, &boneEBO);
-
-    glBindVertexArray(boneVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, boneVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boneEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
-
-    // Position (3 floats) + Normal (3 floats)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-    
+    // The crowd's samples follow the character's own; an undrawn crowd is not posed
+    if (isCrowdDrawn()) {
+        snapshotCrowdSkeleton();
+        crowd.evaluatePoses(batch, firstTrack + trackStride, trackStride);
+        crowdPoseStale = false;
+        crowdPaletteStale = true;
+        boundsStale = true;
+    }
 }
 
+void ImportCharacter::setCrowd(size_t count, float spacing) {
+    crowdSpacing = spacing;
+    crowd.layoutGrid(count, spacing, animationClip.getDuration());
 
-
-// Getter for bindVertices
-const std::vector<glm::vec3>& ImportCharacter::getBindVertices() const {
-    return bindVertices;
-}
-
-// Setter for bindVertices
-void ImportCharacter::setBindVertices(const std::vector<glm::vec3>& vertices) {
-    bindVertices = vertices;
+    // Instances follow the clip when there is one, the character's pose otherwise
+    crowdPoseStale = true;
+    boundsStale = true;
+    if (hasAnimationClip()) {
+        animationPending = true;
+    }
 }
 
-// Getter for skeletal model
-SkeletalModel& ImportCharacter::getSkeletalModel() {
-    return m_skeletalModel;
+size_t ImportCharacter::getCrowdSize() const {
+    return crowd.getInstanceCount();
 }
 
-// Set joint transform by index
-void ImportCharacter::setJointTransform(int jointIndex, float rX, float rY, float rZ) {
-    m_skeletalModel.setJointTransform(jointIndex, rX, rY, rZ);
+float ImportCharacter::getCrowdSpacing() const {
+    return crowdSpacing;
 }
 
-// Getter for attachments
-const std::vector<std::vector<float>>& ImportCharacter::getAttachments() const {
-    return attachments;
+bool ImportCharacter::isCrowd() const {
+    return crowd.getInstanceCount() > 1;
 }
 
-// Setter for attachments
-void ImportCharacter::setAttachments(const std::vector<std::vector<float>>& attachments) {
-    this->attachments = attachments;
+// Only the skinned shader draws instances, so without it the crowd is idle
+bool ImportCharacter::isCrowdDrawn() const {
+    return isCrowd() && canSkinOnGpu();
 }
 
 // Getter for display mode
@@ -292,7 +375,83 @@ void ImportCharacter::setDisplayMode(DisplayMode mode) {
     displayMode = mode;
 }
 
+// One matrix product per moved joint per pose instead of one per skinned vertex and joint
+void ImportCharacter::updateSkinningPalette(const std::vector<int>& joints) {
+    for (size_t i = 0; i < joints.size(); ++i) {
+        const int j = joints[i];
+        skinningPalette[j] = m_skeletalModel.getCurrentJointToWorldTransform(j) *
+                             m_skeletalModel.getBindWorldToJointTransform(j);
+    }
+}
+
+
+bool ImportCharacter::canSkinOnGpu() const {
+    return gpuSkinning && skinnedShaderProgram != 0 && !bindVertices.empty() && influences.size() == bindVertices.size() &&
+           m_skeletalModel.getJoints().size() <= MAX_SKIN_JOINTS;
+}
+
+
+// Stream the palette into the uniform buffer; the buffer always holds a full
+// block so the binding never covers less than the shader declares
+void ImportCharacter::uploadSkinningPalette() {
+    if (paletteUBO == 0) {
+        glGenBuffers(1, &paletteUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, paletteUBO);
+        glBufferData(GL_UNIFORM_BUFFER, MAX_SKIN_JOINTS * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+    } else {
+        glBindBuffer(GL_UNIFORM_BUFFER, paletteUBO);
+    }
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, skinningPalette.size() * sizeof(glm::mat4), skinningPalette.data());
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+
+// Box around the bind-pose vertices each joint influences
+void ImportCharacter::computeJointBounds() {
+    const size_t jointCount = m_skeletalModel.getJoints().size();
+    jointBoundsMin.assign(jointCount, glm::vec3(std::numeric_limits<float>::max()));
+    jointBoundsMax.assign(jointCount, glm::vec3(-std::numeric_limits<float>::max()));
+
+    for (size_t i = 0; i < bindVertices.size() && i < influences.size(); ++i) {
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            if (influences[i].weights[k] == 0) continue;
+            size_t joint = influences[i].joints[k];
+            if (joint >= jointCount) continue;
+            jointBoundsMin[joint] = glm::min(jointBoundsMin[joint], bindVertices[i]);
+            jointBoundsMax[joint] = glm::max(jointBoundsMax[joint], bindVertices[i]);
+        }
+    }
+}
+
+
+// Skinned positions are convex blends of palette-transformed bind positions,
+// so the union of the transformed joint boxes bounds the posed mesh
+void ImportCharacter::fitPosedBounds() {
+    glm::vec3 posedMin(std::numeric_limits<float>::max());
+    glm::vec3 posedMax(-std::numeric_limits<float>::max());
+
+    for (size_t j = 0; j < jointBoundsMin.size() && j < skinningPalette.size(); ++j) {
+        if (jointBoundsMin[j].x > jointBoundsMax[j].x) continue;  // Joint moves no vertices
+
+        const glm::mat4& palette = skinningPalette[j];
+        glm::vec3 center = glm::vec3(palette * glm::vec4(0.5f * (jointBoundsMin[j] + jointBoundsMax[j]), 1.0f));
+        glm::vec3 localExtent = 0.5f * (jointBoundsMax[j] - jointBoundsMin[j]);
+        glm::vec3 extent(0.0f);
+        for (int column = 0; column < 3; ++column) {
+            extent += glm::abs(glm::vec3(palette[column])) * localExtent[column];
+        }
+        posedMin = glm::min(posedMin, center - extent);
+        posedMax = glm::max(posedMax, center + extent);
+    }
+
+    if (posedMin.x <= posedMax.x) {
+        setLocalBounds(posedMin, posedMax);
+    }
+}
+
+
 void ImportCharacter::updateMeshVertices() {
+    PROFILE_SCOPE("ImportCharacter::updateMeshVertices");
 
     // 4.4.2. This is the core of SSD.
     // Implement this method to update the vertices of the mesh
@@ -300,192 +459,392 @@ void ImportCharacter::updateMeshVertices() {
     // You will need both the bind pose world --> joint transforms.
     // and the current joint --> world transforms.
 
-    m_skeletalModel.updateCurrentJointToWorldTransforms();
+    // Pose and bounds need no GL; after the renderer's cull they are current
+    updateBounds();
 
-    vertices.clear();
-    vertices.resize(bindVertices.size(), glm::vec3(0.0f));
+    // Only joints that moved since the last upload need new palette entries
+    // and vertices; a new mesh buffer starts from every joint
+    const size_t jointCount = m_skeletalModel.getJointCount();
+    const bool gpuPath = canSkinOnGpu();
+    const MeshBufferMode wantedMode = gpuPath ? MESH_GPU_SKINNED : MESH_STREAMED;
+    if (meshMode != wantedMode) {
+        markAllJointsMoved();
+    }
 
-    for (size_t i = 0; i < bindVertices.size(); ++i) {
-        glm::vec3 newPos(0.0f);
+    // GPU path: upload the bind pose once, then only the palettes
+    if (gpuPath) {
+        if (meshMode != MESH_GPU_SKINNED) {
+            vertices = bindVertices;
+            buildMeshBuffer(bindVertices, MESH_GPU_SKINNED);
+        }
+        if (!movedJoints.empty()) {
+            uploadSkinningPalette();
+        }
+        if (isCrowd() && crowdPaletteStale) {
+            uploadCrowdPalette();
+            crowdPaletteStale = false;
+        }
+    } else {
+
+        // CPU path: rearrange the bind pose for the SIMD kernel once, then
+        // re-skin only the vertex blocks the moved joints influence, straight
+        // into the position stream. A new or lost stream needs every block.
+        if (meshMode != MESH_STREAMED) {
+            Skinning::prepare(bindVertices, influences, jointCount, skinningBind);
+            Skinning::mapCorners(faces, skinningBind);
+            vertices = bindVertices;
+            buildMeshBuffer(bindVertices, MESH_STREAMED);
+            streamedPositionsLost = true;
+        }
 
-        for (size_t j = 0; j < attachments[i].size(); ++j) {
-            float weight = attachments[i][j];
-            if (weight == 0.0f) continue;
+        Skinning::packPalette(skinningPalette, skinningRows);
+        if (streamedPositionsLost) {
+            skinnedBlocks.resize(skinningBind.paddedCount / Skinning::SIMD_WIDTH);
+            for (size_t b = 0; b < skinnedBlocks.size(); ++b) {
+                skinnedBlocks[b] = static_cast<uint32_t>(b);
+            }
+        } else {
+            Skinning::findAffectedBlocks(skinningBind, movedJoints, skinnedBlocks);
+        }
+        if (!skinnedBlocks.empty()) {
+            writeSkinnedPositions();
+        }
+    }
+
+    movedJoints.clear();
+}
 
-            Joint* joint = m_skeletalModel.getJoints()[j];
-            glm::mat4 T = joint->getCurrentJointToWorldTransform();
-            glm::mat4 B_inv = joint->getBindWorldToJointTransform();
 
-            glm::vec4 transformed = T * B_inv * glm::vec4(bindVertices[i], 1.0f);
-            newPos += weight * glm::vec3(transformed);
+// Forward kinematics and the palette entries of the joints it moved. Moved
+// joints accumulate until updateMeshVertices uploads them, so poses reached
+// while the character is culled are not lost.
+void ImportCharacter::updatePose() {
+    m_skeletalModel.updateCurrentJointToWorldTransforms();
+
+    const std::vector<int>& updated = m_skeletalModel.getUpdatedJoints();
+    if (skinningPalette.size() != m_skeletalModel.getJointCount()) {
+        skinningPalette.resize(m_skeletalModel.getJointCount());
+        markAllJointsMoved();
+        updateSkinningPalette(movedJoints);
+    } else if (!updated.empty()) {
+        updateSkinningPalette(updated);
+        const bool merge = !movedJoints.empty();
+        movedJoints.insert(movedJoints.end(), updated.begin(), updated.end());
+        if (merge) {
+            std::sort(movedJoints.begin(), movedJoints.end());
+            movedJoints.erase(std::unique(movedJoints.begin(), movedJoints.end()), movedJoints.end());
         }
+    } else {
+        return;
+    }
 
-        vertices[i] = newPos;
+    skeletonInstancesStale = true;
+    boundsStale = true;
+
+    // A crowd without a clip copies this pose
+    if (!hasAnimationClip()) {
+        crowdPoseStale = true;
     }
-   
-    setupMeshBuffer();
-    setupJointBuffer();
-    setupBoneBuffer();
+}
+
 
+void ImportCharacter::markAllJointsMoved() {
+    movedJoints.resize(m_skeletalModel.getJointCount());
+    for (size_t j = 0; j < movedJoints.size(); ++j) {
+        movedJoints[j] = static_cast<int>(j);
+    }
 }
 
 
-void ImportCharacter::draw(GLuint shaderProgram) {
-    
-    glUseProgram(shaderProgram);
-    
-    // Lighting setup
-    GLint lightingLoc = glGetUniformLocation(shaderProgram, "useLighting");
-    if (lightingLoc != -1) glUniform1i(lightingLoc, 1);
+void ImportCharacter::updateBounds() {
+    updatePose();
 
-    // Critical fix: Apply transforms AFTER updating vertices
-    if (displayMode == SKELETAL) {
-        updateMeshVertices(); // Update before applying transforms
+    // A crowd that starts being drawn was left unposed while it was not
+    const bool crowdDrawn = isCrowdDrawn();
+    if (crowdDrawn != boundsCoverCrowd) {
+        boundsCoverCrowd = crowdDrawn;
+        boundsStale = true;
+        if (crowdDrawn) {
+            crowdPoseStale = true;
+            if (hasAnimationClip()) {
+                animationPending = true;
+            }
+        }
     }
-    applyTransform(shaderProgram); // Applies to current geometry
 
-    // Material properties
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "material.color");
-    if (colorLoc != -1) {
-        glUniform3fv(colorLoc, 1, (colorIndex == 31) ? customColor : colorPresets[colorIndex].color);
+    // Without a clip the instances copy this character's pose; with one,
+    // applyAnimationPose poses them and until it has the character is alone
+    if (crowdDrawn && crowdPoseStale && !hasAnimationClip()) {
+        snapshotCrowdSkeleton();
+        crowd.evaluateSharedPose(skinningPalette);
+        crowdPoseStale = false;
+        crowdPaletteStale = true;
+        boundsStale = true;
     }
 
-    updateMeshVertices();
-
-    if (displayMode == MESH) {
-        glBindVertexArray(meshVAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-    } 
-    else if (displayMode == SKELETAL) {
-            float white[3] = {1.0f, 1.0f, 1.0f};
-            glUniform3fv(colorLoc, 1, white);
-
-        // Draw joints
-        glBindVertexArray(jointVAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(jointIndexCount), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+    if (!boundsStale) {
+        return;
+    }
 
-        // Draw bones (as cuboids)
-        glBindVertexArray(boneVAO);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(boneIndexCount), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0); 
+    if (jointBoundsMin.size() != m_skeletalModel.getJointCount()) {
+        computeJointBounds();
+    }
+    glm::vec3 crowdMin, crowdMax;
+    if (crowdDrawn && crowd.computeBounds(jointBoundsMin, jointBoundsMax, crowdMin, crowdMax)) {
+        setLocalBounds(crowdMin, crowdMax);
+    } else {
+        fitPosedBounds();
     }
+    boundsStale = false;
+}
 
-    if (lightingLoc != -1) glUniform1i(lightingLoc, 0);
 
+// Joint markers follow the joint-to-world transforms; a bone is the unit cube
+// stretched from its parent joint to its joint. Joint transforms are rigid,
+// so their rotation is also the normal matrix.
+void ImportCharacter::updateSkeletonInstances() {
+    const size_t jointCount = m_skeletalModel.getJointCount();
+    const float jointScale = 2.0f * JOINT_RADIUS; // The shared sphere has radius 0.5
+
+    jointInstances.resize(jointCount);
+    boneInstances.clear();
+    for (size_t j = 0; j < jointCount; ++j) {
+        const glm::mat4& jointToWorld = m_skeletalModel.getCurrentJointToWorldTransform(j);
+
+        SkeletonInstance& joint = jointInstances[j];
+        joint.model = jointToWorld;
+        joint.model[0] *= jointScale;
+        joint.model[1] *= jointScale;
+        joint.model[2] *= jointScale;
+        joint.normalMatrix = glm::mat3(jointToWorld);
+
+        int parent = m_skeletalModel.getParentIndex(j);
+        if (parent < 0) continue;
+
+        glm::vec3 parentPos = glm::vec3(m_skeletalModel.getCurrentJointToWorldTransform(parent)[3]);
+        glm::vec3 childPos = glm::vec3(jointToWorld[3]);
+        float length = glm::length(childPos - parentPos);
+        if (length <= 1.0e-6f) continue; // Coincident joints have no bone to draw
+
+        // Bone frame: z along the bone, x and y from a helper axis not parallel to it
+        glm::vec3 z = (childPos - parentPos) / length;
+        glm::vec3 helper(0.0f, 0.0f, 1.0f);
+        if (glm::abs(glm::dot(z, helper)) > 0.99f) {
+            helper = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        glm::vec3 y = glm::normalize(glm::cross(z, helper));
+        glm::vec3 x = glm::normalize(glm::cross(y, z));
+
+        SkeletonInstance bone;
+        bone.model = glm::mat4(1.0f);
+        bone.model[0] = glm::vec4(x * BONE_WIDTH, 0.0f);
+        bone.model[1] = glm::vec4(y * BONE_WIDTH, 0.0f);
+        bone.model[2] = glm::vec4(z * length, 0.0f);
+        bone.model[3] = glm::vec4(0.5f * (parentPos + childPos), 1.0f);
+        bone.normalMatrix = glm::mat3(x / BONE_WIDTH, y / BONE_WIDTH, z / length);
+        boneInstances.push_back(bone);
+    }
 }
 
 
-void ImportCharacter::resetPose() {
-    for (size_t i = 0; i < m_skeletalModel.getJoints().size(); ++i) {
-        m_skeletalModel.setJointTransform(i, 0.0f, 0.0f, 0.0f);
+// In skeletal mode the character is two instanced batches in the render
+// queue; the mesh is drawn directly by draw()
+bool ImportCharacter::submit(RenderQueue& queue) {
+    if (displayMode != SKELETAL || !jointMesh || !boneMesh) {
+        return false;
     }
 
-    m_skeletalModel.updateCurrentJointToWorldTransforms();
     updateMeshVertices();
+    if (skeletonInstancesStale) {
+        updateSkeletonInstances();
+        skeletonInstancesStale = false;
+    }
+
+    const glm::vec3 white(1.0f);
+    const glm::mat4& model = getModelMatrix();
+    const glm::mat3& normalMatrix = getNormalMatrix();
+    for (size_t i = 0; i < jointInstances.size(); ++i) {
+        queue.submit(jointMesh->VAO, jointMesh->indexCount, white,
+                     model * jointInstances[i].model, normalMatrix * jointInstances[i].normalMatrix);
+    }
+    for (size_t i = 0; i < boneInstances.size(); ++i) {
+        queue.submit(boneMesh->VAO, boneMesh->indexCount, white,
+                     model * boneInstances[i].model, normalMatrix * boneInstances[i].normalMatrix);
+    }
+    return true;
 }
 
 
+// Skeleton the crowd poses: the character's compiled order and bind transforms,
+// and its current local transforms for the joints the clip does not animate
+void ImportCharacter::snapshotCrowdSkeleton() {
+    const size_t jointCount = m_skeletalModel.getJointCount();
+    std::vector<glm::mat4> restLocalTransforms(jointCount);
+    std::vector<glm::mat4> bindWorldToJoint(jointCount);
+    for (size_t j = 0; j < jointCount; ++j) {
+        restLocalTransforms[j] = m_skeletalModel.getJoints()[j]->getTransform();
+        bindWorldToJoint[j] = m_skeletalModel.getBindWorldToJointTransform(j);
+    }
+    crowd.setSkeleton(m_skeletalModel.getSlotJoints(), m_skeletalModel.getParentSlots(),
+                      restLocalTransforms, bindWorldToJoint);
+}
 
-void ImportCharacter::generateSphere(float radius, glm::vec3 center,
-                                      std::vector<glm::vec3>& jointVertices,
-                                      std::vector<glm::vec3>& jointNormals,
-                                      std::vector<glm::uvec3>& jointFaces) {
-                         
-// Extra credit - Helper utility to generate a sphere instead of a point for joints
-    int sectorCount = 16; 
-    int stackCount = 16; 
 
-    for (int i = 0; i <= stackCount; ++i) {
-        float stackAngle = glm::pi<float>() / 2 - i * glm::pi<float>() / stackCount; 
-        float xy = radius * cosf(stackAngle);
-        float z = radius * sinf(stackAngle);
+// Three RGBA32F texels per joint per instance, orphaned and refilled like
+// the render queue's instance buffer
+void ImportCharacter::uploadCrowdPalette() {
+    PROFILE_SCOPE("ImportCharacter::uploadCrowdPalette");
 
-        for (int j = 0; j <= sectorCount; ++j) {
-            float sectorAngle = j * 2 * glm::pi<float>() / sectorCount;
+    const std::vector<float>& rows = crowd.getPaletteRows();
+    const size_t texelsPerInstance = crowd.getJointCount() * 3;
+    if (texelsPerInstance == 0 || rows.size() != crowd.getInstanceCount() * texelsPerInstance * 4) {
+        crowdDrawCount = 0;
+        return;
+    }
 
-            float x = xy * cosf(sectorAngle);
-            float y = xy * sinf(sectorAngle);
+    const bool created = (crowdPaletteBuffer == 0);
+    if (created) {
+        glGenBuffers(1, &crowdPaletteBuffer);
+        glGenTextures(1, &crowdPaletteTexture);
+    }
 
-            glm::vec3 pos = glm::vec3(x, y, z) + center;
-            glm::vec3 normal = glm::normalize(glm::vec3(x, y, z));
+    // Texture buffers may be as small as 65536 texels
+    static GLint maxTexels = 0;
+    if (maxTexels == 0) {
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    }
+    const size_t drawCount = std::min(crowd.getInstanceCount(), static_cast<size_t>(maxTexels) / texelsPerInstance);
+    if (drawCount < crowd.getInstanceCount() && static_cast<GLsizei>(drawCount) != crowdDrawCount) {
+        std::cerr << "Crowd palette exceeds the texture buffer limit; drawing " << drawCount << " of "
+                  << crowd.getInstanceCount() << " instances" << std::endl;
+    }
 
-            jointVertices.push_back(pos);
-            jointNormals.push_back(normal);
-        }
+    const GLsizeiptr bytes = static_cast<GLsizeiptr>(drawCount * texelsPerInstance * 4 * sizeof(float));
+    glBindBuffer(GL_TEXTURE_BUFFER, crowdPaletteBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, rows.data());
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    if (created) {
+        glActiveTexture(GL_TEXTURE0 + CROWD_PALETTE_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_BUFFER, crowdPaletteTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, crowdPaletteBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
     }
 
-    
-    for (int i = 0; i < stackCount; ++i) {
-        int k1 = i * (sectorCount + 1);
-        int k2 = k1 + sectorCount + 1;
+    crowdDrawCount = static_cast<GLsizei>(drawCount);
+}
 
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2) {
-            if (i != 0) {
-                jointFaces.push_back(glm::uvec3(k1, k2, k1 + 1));
-            }
-            if (i != (stackCount - 1)) {
-                jointFaces.push_back(glm::uvec3(k1 + 1, k2, k2 + 1));
-            }
-        }
+
+// Skin the affected blocks straight into the mapped position buffer, front to
+// back. When every block is re-skinned the old contents are invalidated, so
+// the driver can hand back fresh storage instead of waiting on the previous
+// frame's draw; a partial update must keep the other slots and may wait.
+void ImportCharacter::writeSkinnedPositions() {
+    PROFILE_SCOPE("ImportCharacter::writeSkinnedPositions");
+
+    const size_t cornerCount = skinningBind.corners.size();
+    if (cornerCount == 0) return;
+
+    const bool everyBlock = skinnedBlocks.size() == skinningBind.paddedCount / Skinning::SIMD_WIDTH;
+    glBindBuffer(GL_ARRAY_BUFFER, meshPositionVBO);
+    float* mapped = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, cornerCount * 3 * sizeof(float),
+                                                         GL_MAP_WRITE_BIT | (everyBlock ? GL_MAP_INVALIDATE_BUFFER_BIT : 0)));
+    if (!mapped) {
+        std::cerr << "Failed to map the character position buffer" << std::endl;
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        streamedPositionsLost = true;
+        return;
     }
+
+    Skinning::skinBlocks(skinningBind, skinningRows.data(), skinnedBlocks, mapped);
+    streamedPositionsLost = false;
+
+    if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE) {
+        std::cerr << "Character position buffer was corrupted while mapped" << std::endl;
+        streamedPositionsLost = true;
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
 
+void ImportCharacter::draw(GLuint shaderProgram) {
 
-void ImportCharacter::generateCuboid(const glm::vec3& parentPos, const glm::vec3& childPos,
-                                      std::vector<glm::vec3>& boneVertices,
-                                      std::vector<glm::vec3>& boneNormals,
-                                      std::vector<glm::uvec3>& boneFaces) {
+    // Critical fix: Apply transforms AFTER updating vertices
+    updateMeshVertices();
 
-    // Extra credit - Helper utility to generate a cube or cuboid instead of a line for bones
-    glm::vec3 z = glm::normalize(childPos - parentPos);
-    float length = glm::length(childPos - parentPos);
+    // A mesh holding the bind pose is blended by the SKINNED variant
+    const bool skinOnGpu = (displayMode == MESH && meshMode == MESH_GPU_SKINNED);
+    const GLuint program = skinOnGpu ? skinnedShaderProgram : shaderProgram;
+    glUseProgram(program);
+    
+    // Lighting setup
+    GLint lightingLoc = glGetUniformLocation(program, "useLighting");
+    if (lightingLoc != -1) glUniform1i(lightingLoc, 1);
 
-   
-    glm::vec3 rnd(0, 0, 1);
-    if (glm::abs(glm::dot(z, rnd)) > 0.99f)
-        rnd = glm::vec3(0, 1, 0); 
+    applyTransform(program); // Applies to current geometry
 
-    glm::vec3 y = glm::normalize(glm::cross(z, rnd));
-    glm::vec3 x = glm::normalize(glm::cross(y, z));
+    // Material properties
+    GLint colorLoc = glGetUniformLocation(program, "material.color");
+    if (colorLoc != -1) {
+        glUniform3fv(colorLoc, 1, (colorIndex == 31) ? customColor : colorPresets[colorIndex].color);
+    }
+
+    if (displayMode == MESH) {
+        VertexCompression::setDecodeUniforms(program, meshDecodeOffset, meshDecodeScale);
 
-    glm::mat4 transform(1.0f);
-    transform[0] = glm::vec4(x * 0.01f, 0.0f);
-    transform[1] = glm::vec4(y * 0.01f, 0.0f);
-    transform[2] = glm::vec4(z * length, 0.0f);
-    transform[3] = glm::vec4(parentPos, 1.0f);
+        GLint crowdJointCountLoc = -1;
+        if (skinOnGpu) {
+            GLuint blockIndex = glGetUniformBlockIndex(program, "SkinningPalette");
+            if (blockIndex != GL_INVALID_INDEX) {
+                glUniformBlockBinding(program, blockIndex, SKINNING_PALETTE_BINDING);
+            }
+            glBindBufferBase(GL_UNIFORM_BUFFER, SKINNING_PALETTE_BINDING, paletteUBO);
+
+            // The sampler always names the palette unit, crowd or not
+            GLint crowdPaletteLoc = glGetUniformLocation(program, "crowdPalette");
+            if (crowdPaletteLoc != -1) glUniform1i(crowdPaletteLoc, CROWD_PALETTE_TEXTURE_UNIT);
+            crowdJointCountLoc = glGetUniformLocation(program, "crowdJointCount");
+        }
+
+        // A crowd reads each instance's palette from the texture buffer instead
+        const bool drawCrowd = (skinOnGpu && isCrowd() && crowdDrawCount > 0);
+        if (drawCrowd) {
+            glActiveTexture(GL_TEXTURE0 + CROWD_PALETTE_TEXTURE_UNIT);
+            glBindTexture(GL_TEXTURE_BUFFER, crowdPaletteTexture);
+            glActiveTexture(GL_TEXTURE0);
+
+            if (crowdJointCountLoc != -1) glUniform1i(crowdJointCountLoc, static_cast<GLint>(crowd.getJointCount()));
+        }
 
-    std::vector<glm::vec3> unitCube = {
-        {-0.5f, -0.5f, 0.0f}, {0.5f, -0.5f, 0.0f}, {0.5f, 0.5f, 0.0f}, {-0.5f, 0.5f, 0.0f},
-        {-0.5f, -0.5f, 1.0f}, {0.5f, -0.5f, 1.0f}, {0.5f, 0.5f, 1.0f}, {-0.5f, 0.5f, 1.0f}
-    };
+        glBindVertexArray(meshVAO);
+        if (drawCrowd) {
+            glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0, crowdDrawCount);
+        } else {
+            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0);
+        }
+        glBindVertexArray(0);
 
-    for (const auto& v : unitCube) {
-        glm::vec4 worldV = transform * glm::vec4(v, 1.0f);
-        boneVertices.push_back(glm::vec3(worldV));
+        if (drawCrowd && crowdJointCountLoc != -1) glUniform1i(crowdJointCountLoc, 0);
+        if (meshCompact) {
+            VertexCompression::clearDecodeUniforms(program);
+        }
     }
 
-    std::vector<glm::vec3> cubeNormals = {
-        {0, 0, -1}, {0, 0, -1}, {0, 0, -1}, {0, 0, -1},
-        {0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0, 1}
-    };
-    for (const auto& n : cubeNormals) {
-        boneNormals.push_back(n);
+    if (lightingLoc != -1) glUniform1i(lightingLoc, 0);
+
+    // Callers expect the regular program to stay current
+    if (program != shaderProgram) {
+        glUseProgram(shaderProgram);
     }
+}
 
-    std::vector<glm::uvec3> faces = {
-        {0, 1, 2}, {2, 3, 0}, // bottom
-        {4, 5, 6}, {6, 7, 4}, // top
-        {0, 1, 5}, {5, 4, 0}, // side
-        {1, 2, 6}, {6, 5, 1},
-        {2, 3, 7}, {7, 6, 2},
-        {3, 0, 4}, {4, 7, 3}
-    };
-    for (auto f : faces) {
-        boneFaces.push_back(f);
+
+void ImportCharacter::resetPose() {
+    for (size_t i = 0; i < m_skeletalModel.getJoints().size(); ++i) {
+        m_skeletalModel.setJointTransform(i, 0.0f, 0.0f, 0.0f);
     }
-    
 
+    updateMeshVertices();
 }
\ No newline at end of file
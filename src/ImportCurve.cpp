@@ -1,8 +1,10 @@
 #include "ImportCurve.h"
+#include "CompactVertex.h"
 
 ImportCurve::ImportCurve(float x, float y, float z, float scale, int colorIndex, int id)
     : Shape(x, y, z, scale, colorIndex, id), showControlPoints(true), curveVisibilityMode(1), surfaceVisibilityMode(2), 
-       controlPointsVAO(0), controlPointsVBO(0), curveVAO(0), curveVBO(0), vectorVAO(0), vectorVBO(0), surfaceVAO(0), surfaceVBO(0), surfaceEBO(0), wireframeVAO(0), wireframeVBO(0), normalVAO(0), normalVBO(0) {
+       controlPointsVAO(0), controlPointsVBO(0), curveVAO(0), curveVBO(0), vectorVAO(0), vectorVBO(0), surfaceVAO(0), surfaceVBO(0), surfaceEBO(0),
+       surfaceCompact(false), surfaceDecodeOffset(0.0f), surfaceDecodeScale(0.0f), wireframeVAO(0), wireframeVBO(0), normalVAO(0), normalVBO(0) {
 }
 
 ImportCurve::~ImportCurve() {
@@ -87,8 +89,31 @@ void ImportCurve::setSurfaceVisibilityMode(int mode) {
     surfaceVisibilityMode = mode;
 }
 
+// Fit the local bounds around everything the curve shape can draw
+void ImportCurve::fitBounds() {
+    std::vector<glm::vec3> points;
+
+    for (const auto& curve : curves) {
+        const std::vector<glm::vec3>& controlPoints = curve.getControlPoints();
+        points.insert(points.end(), controlPoints.begin(), controlPoints.end());
+        for (const auto& point : curve.getCurvePoints()) {
+            points.push_back(point.V);
+        }
+    }
+
+    for (const auto& surface : surfaces) {
+        points.insert(points.end(), surface.VV.begin(), surface.VV.end());
+    }
+
+    computeLocalBounds(points);
+}
+
+
 void ImportCurve::setupCurveBuffer() {
 
+    // Local bounds for frustum culling
+    fitBounds();
+
     // Clear existing data
     glDeleteVertexArrays(1, &controlPointsVAO);
     glDeleteBuffers(1, &controlPointsVBO);
@@ -208,6 +233,9 @@ void ImportCurve::setupCurveBuffer() {
 
 void ImportCurve::setupSurfaceBuffer() {
 
+    // Local bounds for frustum culling
+    fitBounds();
+
     // Clear existing data
     if (surfaceVAO) glDeleteVertexArrays(1, &surfaceVAO);
     if (surfaceVBO) glDeleteBuffers(1, &surfaceVBO);
@@ -263,19 +291,37 @@ void ImportCurve::setupSurfaceBuffer() {
 
     // Vertex and Color Data
     glBindBuffer(GL_ARRAY_BUFFER, surfaceVBO);
-    glBufferData(GL_ARRAY_BUFFER, surfaceVertices.size() * sizeof(float), surfaceVertices.data(), GL_STATIC_DRAW);
-
-    // Positions -> location 0
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Normals -> location 1
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Colors -> location 2
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    surfaceCompact = VertexCompression::isEnabled() && hasBounds();
+    if (surfaceCompact) {
+        // The surface is only drawn lit, so the per-vertex color can be dropped: 12 bytes instead of 36
+        const glm::vec3& boundsMin = getLocalBoundsMin();
+        const glm::vec3& boundsMax = getLocalBoundsMax();
+        std::vector<CompactVertex> compactVertices;
+        VertexCompression::compress(surfaceVertices.data(), 9, 3, surfaceVertices.size() / 9,
+                                    boundsMin, boundsMax, compactVertices);
+        surfaceDecodeOffset = VertexCompression::getDecodeOffset(boundsMin);
+        surfaceDecodeScale = VertexCompression::getDecodeScale(boundsMin, boundsMax);
+
+        glBufferData(GL_ARRAY_BUFFER, compactVertices.size() * sizeof(CompactVertex), compactVertices.data(), GL_STATIC_DRAW);
+        VertexCompression::configureAttributes();
+    } else {
+        surfaceDecodeOffset = glm::vec3(0.0f);
+        surfaceDecodeScale = glm::vec3(0.0f);
+
+        glBufferData(GL_ARRAY_BUFFER, surfaceVertices.size() * sizeof(float), surfaceVertices.data(), GL_STATIC_DRAW);
+
+        // Positions -> location 0
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // Normals -> location 1
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        // Colors -> location 2
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+    }
 
     // Indices
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, surfaceEBO);
@@ -441,6 +487,8 @@ void ImportCurve::draw(GLuint shaderProgram) {
             glUniform3fv(colorLoc, 1, (colorIndex == 31) ? customColor : colorPresets[colorIndex].color);
         }
 
+        VertexCompression::setDecodeUniforms(shaderProgram, surfaceDecodeOffset, surfaceDecodeScale);
+
         // Loop through each surface and draw
         for (const auto& surface : surfaces) {
             glBindVertexArray(surfaceVAO);
@@ -460,10 +508,13 @@ void ImportCurve::draw(GLuint shaderProgram) {
             glBindVertexArray(0);
         }
 
-        // Disable lighting after drawing the surface (for axis rendering)
+        // Disable lighting and decoding after drawing the surface (for axis rendering)
         if (lightingLoc != -1) {
             glUniform1i(lightingLoc, 0);
         }
+        if (surfaceCompact) {
+            VertexCompression::clearDecodeUniforms(shaderProgram);
+        }
     } 
 }
 
@@ -1,7 +1,13 @@
 #include "ImportShape.h"
+#include "MeshOptimizer.h"
+
+const size_t ImportShape::VERTEX_STRIDE;
+const float ImportShape::LOD_PIXEL_ERROR = 1.0f;
+const float ImportShape::LOD_HYSTERESIS = 0.5f;
 
 ImportShape::ImportShape(float x, float y, float z, float scale, int colorIndex, int id)
-	: Shape(x, y, z, scale, colorIndex, id), VAO(0), VBO(0), EBO(0) {
+	: Shape(x, y, z, scale, colorIndex, id), VAO(0), VBO(0), EBO(0), indexCount(0),
+	  compact(false), decodeOffset(0.0f), decodeScale(0.0f), currentLod(0) {
 	
 //    setupShape();  // Prepare OpenGL buffers
 	
@@ -14,31 +20,76 @@ ImportShape::~ImportShape() {
     glDeleteBuffers(1, &EBO);
 }
 
-void ImportShape::setupShape() {
-    vertexData.clear();
-    indexData.clear();
+void ImportShape::buildVertexData() {
+    // Local bounds for frustum culling
+    computeLocalBounds(vertices);
 
-    // Populate vertex and normal data
-    for (size_t i = 0; i < faces.size(); ++i) {
+    // One (position, normal) corner per face vertex
+    std::vector<float> corners;
+    corners.reserve(faceIndices.size() / 2 * VERTEX_STRIDE);
+    for (size_t i = 0; i + 6 <= faceIndices.size(); i += 6) {
         for (int j = 0; j < 3; ++j) { // Each face has 3 vertices
-            int vertexIndex = faces[i][j * 2];  // Access vertex index
-            int normalIndex = faces[i][j * 2 + 1]; // Access normal index
+            int vertexIndex = faceIndices[i + j * 2];  // Access vertex index
+            int normalIndex = faceIndices[i + j * 2 + 1]; // Access normal index
             
             const glm::vec3& position = vertices[vertexIndex];
             const glm::vec3& normal = normals[normalIndex];
 
-            // Append position, normal, and placeholder for texture coordinates
-            vertexData.insert(vertexData.end(), {position.x, position.y, position.z});
-            vertexData.insert(vertexData.end(), {normal.x, normal.y, normal.z});
-            vertexData.insert(vertexData.end(), {0.0f, 0.0f}); // Placeholder texture coords
+            corners.insert(corners.end(), {position.x, position.y, position.z});
+            corners.insert(corners.end(), {normal.x, normal.y, normal.z});
         }
+    }
+
+    // Shared corners become one vertex; then order triangles for the
+    // post-transform cache and vertices for fetch locality
+    MeshOptimizer::weldVertices(corners, VERTEX_STRIDE, vertexData, indexData);
+    MeshOptimizer::optimizeVertexCache(indexData, vertexData.size() / VERTEX_STRIDE);
+    MeshOptimizer::optimizeVertexFetch(vertexData, VERTEX_STRIDE, indexData);
+
+    // Coarser levels go after the full mesh in the same index buffer
+    MeshSimplifier::buildLodChain(vertexData, VERTEX_STRIDE, indexData, lods);
+}
+
+
+void ImportShape::setCachedMesh(std::unique_ptr<CachedMesh> mesh) {
+    cachedMesh = std::move(mesh);
+}
+
 
-        // Add indices for this triangle
-        indexData.insert(indexData.end(), {static_cast<unsigned int>(i * 3), 
-                                           static_cast<unsigned int>(i * 3 + 1), 
-                                           static_cast<unsigned int>(i * 3 + 2)});
+void ImportShape::setFaceIndices(std::vector<int>&& indices) {
+    faceIndices = std::move(indices);
+}
+
+
+void ImportShape::setupShape() {
+    // Cached blob: bounds and buffers come straight from the mapping
+    const float* vertexSource = nullptr;
+    const unsigned int* indexSource = nullptr;
+    size_t vertexFloatCount = 0;
+    if (cachedMesh) {
+        setLocalBounds(cachedMesh->boundsMin, cachedMesh->boundsMax);
+        vertexSource = cachedMesh->vertexData;
+        vertexFloatCount = cachedMesh->vertexFloatCount;
+        indexSource = cachedMesh->indexData;
+        indexCount = static_cast<GLsizei>(cachedMesh->indexCount);
+        lods = cachedMesh->lods;
+    } else {
+        if (vertexData.empty()) {
+            buildVertexData();
+        }
+        vertexSource = vertexData.data();
+        vertexFloatCount = vertexData.size();
+        indexSource = indexData.data();
+        indexCount = static_cast<GLsizei>(indexData.size());
     }
 
+    // Meshes without a chain draw the whole buffer as their only level
+    if (lods.empty()) {
+        MeshLod full = { 0, static_cast<size_t>(indexCount), 0.0f };
+        lods.push_back(full);
+    }
+    currentLod = 0;
+
     // Generate OpenGL buffers
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
@@ -46,23 +97,41 @@ void ImportShape::setupShape() {
 
     glBindVertexArray(VAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * sizeof(unsigned int), indexSource, GL_STATIC_DRAW);
 
-    // Configure vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0); // Position
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float))); // Texture Coord (not used)
-    glEnableVertexAttribArray(2);
+    // Configure vertex attributes; color (location 2) stays disabled and reads as black
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    compact = VertexCompression::isEnabled() && hasBounds();
+    if (compact) {
+        // 12 bytes per vertex instead of 24, quantized against the local bounds
+        const glm::vec3& boundsMin = getLocalBoundsMin();
+        const glm::vec3& boundsMax = getLocalBoundsMax();
+        std::vector<CompactVertex> compactData;
+        VertexCompression::compress(vertexSource, VERTEX_STRIDE, 3, vertexFloatCount / VERTEX_STRIDE,
+                                    boundsMin, boundsMax, compactData);
+        decodeOffset = VertexCompression::getDecodeOffset(boundsMin);
+        decodeScale = VertexCompression::getDecodeScale(boundsMin, boundsMax);
+
+        glBufferData(GL_ARRAY_BUFFER, compactData.size() * sizeof(CompactVertex), compactData.data(), GL_STATIC_DRAW);
+        VertexCompression::configureAttributes();
+    } else {
+        decodeOffset = glm::vec3(0.0f);
+        decodeScale = glm::vec3(0.0f);
+
+        glBufferData(GL_ARRAY_BUFFER, vertexFloatCount * sizeof(float), vertexSource, GL_STATIC_DRAW);
+
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_STRIDE * sizeof(float), (void*)0); // Position
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_STRIDE * sizeof(float), (void*)(3 * sizeof(float))); // Normal
+        glEnableVertexAttribArray(1);
+    }
 
     glBindVertexArray(0); // Unbind VAO
+
+    // The GL has its own copy now
+    cachedMesh.reset();
 }
 
 void ImportShape::draw(GLuint shaderProgram) {
@@ -86,12 +155,51 @@ void ImportShape::draw(GLuint shaderProgram) {
     }
 
     // Render the cube
+    VertexCompression::setDecodeUniforms(shaderProgram, decodeOffset, decodeScale);
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0);
+    const MeshLod& lod = lods[currentLod];
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.indexCount), GL_UNSIGNED_INT,
+                   (void*)(lod.firstIndex * sizeof(unsigned int)));
     glBindVertexArray(0);
 
-    // Disable lighting after drawing the cube (for axis rendering)
+    // Disable lighting and decoding after drawing the cube (for axis rendering)
     if (lightingLoc != -1) {
         glUniform1i(lightingLoc, 0);
     }
+    if (compact) {
+        VertexCompression::clearDecodeUniforms(shaderProgram);
+    }
+}
+
+
+// Queue the shape for batched rendering
+bool ImportShape::submit(RenderQueue& queue) {
+    const MeshLod& lod = lods[currentLod];
+    queue.submitRange(VAO, static_cast<GLsizei>(lod.firstIndex), static_cast<GLsizei>(lod.indexCount),
+                      getMaterialColor(), getModelMatrix(), getNormalMatrix(), decodeOffset, decodeScale);
+    return true;
+}
+
+
+// Level errors are in mesh units; relative to the bounding sphere they scale
+// with its projected radius into an error in pixels
+void ImportShape::selectLod(float projectedRadius) {
+    if (lods.size() < 2 || boundingSphereRadius <= 0.0f) {
+        return;
+    }
+    const float pixelsPerUnit = projectedRadius / boundingSphereRadius;
+
+    // Too coarse for the current size: refine to the coarsest level that fits
+    if (lods[currentLod].error * pixelsPerUnit > LOD_PIXEL_ERROR) {
+        while (currentLod > 0 && lods[currentLod].error * pixelsPerUnit > LOD_PIXEL_ERROR) {
+            --currentLod;
+        }
+        return;
+    }
+
+    // Coarsen only with margin, so a shape near a threshold does not flicker between levels
+    while (currentLod + 1 < lods.size() &&
+           lods[currentLod + 1].error * pixelsPerUnit <= LOD_PIXEL_ERROR * LOD_HYSTERESIS) {
+        ++currentLod;
+    }
 }
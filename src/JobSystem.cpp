@@ -0,0 +1,296 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+// Per-worker deques plus the injection queue used by non-worker threads
+struct JobSystem::Scheduler {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Task>> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    Queue injection;
+    std::vector<std::thread> workers;
+
+    // Sleeping workers wake when a job is queued or on shutdown
+    std::atomic<bool> stopping;
+    std::atomic<int> queued;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+
+    Scheduler() : stopping(false), queued(0) {}
+};
+
+JobSystem::Scheduler* JobSystem::scheduler = nullptr;
+
+namespace {
+
+// Index of the calling worker, or -1 on any other thread
+thread_local int workerIndex = -1;
+
+// Cheap per-thread generator for picking steal victims
+thread_local unsigned stealSeed = 0x9E3779B9u;
+
+unsigned nextVictim() {
+    stealSeed ^= stealSeed << 13;
+    stealSeed ^= stealSeed >> 17;
+    stealSeed ^= stealSeed << 5;
+    return stealSeed;
+}
+
+// Chunk counters of one parallelFor, shared with its helper jobs; a helper
+// that starts after the loop returned finds no chunk left and exits
+struct ParallelRange {
+    std::atomic<size_t> nextChunk;
+    std::atomic<size_t> doneChunks;
+
+    ParallelRange() : nextChunk(0), doneChunks(0) {}
+};
+
+}
+
+
+void JobSystem::start(unsigned workerCount) {
+    if (scheduler) {
+        return;
+    }
+
+    // Leave one core for the thread that called start()
+    if (workerCount == 0) {
+        unsigned cores = std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    scheduler = new Scheduler();
+    for (unsigned i = 0; i < workerCount; ++i) {
+        scheduler->queues.push_back(std::unique_ptr<Scheduler::Queue>(new Scheduler::Queue()));
+    }
+
+    for (unsigned i = 0; i < workerCount; ++i) {
+        scheduler->workers.push_back(std::thread([i]() {
+            workerIndex = static_cast<int>(i);
+            stealSeed += i * 7919u;
+
+            while (!scheduler->stopping) {
+                if (runOne()) {
+                    continue;
+                }
+
+                // Nothing to run or steal; sleep until something is queued
+                std::unique_lock<std::mutex> lock(scheduler->sleepMutex);
+                scheduler->wake.wait(lock, []() { return scheduler->stopping || scheduler->queued > 0; });
+            }
+        }));
+    }
+}
+
+
+void JobSystem::shutdown() {
+    if (!scheduler) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+        scheduler->stopping = true;
+    }
+    scheduler->wake.notify_all();
+    for (std::thread& worker : scheduler->workers) {
+        worker.join();
+    }
+
+    // Finish whatever was still queued before dropping the queues
+    while (runOne()) {
+    }
+
+    delete scheduler;
+    scheduler = nullptr;
+}
+
+
+unsigned JobSystem::getWorkerCount() {
+    return scheduler ? static_cast<unsigned>(scheduler->workers.size()) : 0;
+}
+
+
+JobSystem::JobHandle JobSystem::run(const std::function<void()>& job) {
+    return run(job, std::vector<JobHandle>());
+}
+
+
+JobSystem::JobHandle JobSystem::run(const std::function<void()>& job, const std::vector<JobHandle>& dependencies) {
+    std::shared_ptr<Task> task(new Task());
+    task->function = job;
+    task->state = JobHandle(new JobState());
+
+    // One extra count guards against scheduling before every dependency is registered
+    task->unresolved = static_cast<int>(dependencies.size()) + 1;
+    for (const JobHandle& dependency : dependencies) {
+        if (!dependency) {
+            --task->unresolved;
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(dependency->mutex);
+        if (dependency->finished) {
+            --task->unresolved;
+        } else {
+            dependency->dependents.push_back(task);
+        }
+    }
+
+    JobHandle handle = task->state;
+    if (--task->unresolved == 0) {
+        schedule(task);
+    }
+    return handle;
+}
+
+
+void JobSystem::wait(const JobHandle& handle) {
+    while (handle && !handle->isFinished()) {
+        if (workerIndex < 0 || !runOne()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+
+void JobSystem::parallelFor(size_t first, size_t last, size_t grainSize,
+                            const std::function<void(size_t, size_t)>& body) {
+    if (first >= last) {
+        return;
+    }
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    const size_t chunkCount = (last - first + grainSize - 1) / grainSize;
+    if (!scheduler || chunkCount == 1) {
+        body(first, last);
+        return;
+    }
+
+    // Helpers and this thread claim chunks until none are left. `body` is only
+    // touched for a claimed chunk, which cannot happen once every chunk is done.
+    std::shared_ptr<ParallelRange> range(new ParallelRange());
+    const std::function<void(size_t, size_t)>* function = &body;
+    const std::function<void()> runChunks = [range, function, first, last, grainSize, chunkCount]() {
+        for (size_t chunk = range->nextChunk++; chunk < chunkCount; chunk = range->nextChunk++) {
+            const size_t begin = first + chunk * grainSize;
+            (*function)(begin, std::min(last, begin + grainSize));
+            range->doneChunks.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    const size_t helperCount = std::min<size_t>(chunkCount - 1, scheduler->workers.size());
+    for (size_t i = 0; i < helperCount; ++i) {
+        run(runChunks);
+    }
+    runChunks();
+
+    // The remaining chunks are already running on workers; waiting for them
+    // must not pick up unrelated jobs
+    while (range->doneChunks.load(std::memory_order_acquire) < chunkCount) {
+        std::this_thread::yield();
+    }
+}
+
+
+void JobSystem::schedule(const std::shared_ptr<Task>& task) {
+    if (!scheduler) {
+        execute(task); // Not started: run inline
+        return;
+    }
+
+    // Workers push onto their own deque; everyone else uses the injection queue
+    Scheduler::Queue& queue = workerIndex >= 0 ? *scheduler->queues[workerIndex] : scheduler->injection;
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(task);
+    }
+    ++scheduler->queued;
+
+    // Taking the sleep mutex orders this wake-up after a worker's predicate check
+    {
+        std::lock_guard<std::mutex> lock(scheduler->sleepMutex);
+    }
+    scheduler->wake.notify_one();
+}
+
+
+void JobSystem::execute(const std::shared_ptr<Task>& task) {
+    task->function();
+
+    // Mark finished and release the jobs that were waiting on this one
+    std::vector<std::shared_ptr<Task>> ready;
+    {
+        std::lock_guard<std::mutex> lock(task->state->mutex);
+        task->state->finished.store(true, std::memory_order_release);
+        ready.swap(task->state->dependents);
+    }
+
+    for (const std::shared_ptr<Task>& dependent : ready) {
+        if (--dependent->unresolved == 0) {
+            schedule(dependent);
+        }
+    }
+}
+
+
+// Run one queued job if there is any; returns false when every queue is empty
+bool JobSystem::runOne() {
+    if (!scheduler) {
+        return false;
+    }
+
+    std::shared_ptr<Task> task;
+
+    // Own deque first, newest job (still warm in cache)
+    if (workerIndex >= 0) {
+        Scheduler::Queue& own = *scheduler->queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            task = own.jobs.back();
+            own.jobs.pop_back();
+        }
+    }
+
+    // Then work submitted from outside the pool
+    if (!task) {
+        std::lock_guard<std::mutex> lock(scheduler->injection.mutex);
+        if (!scheduler->injection.jobs.empty()) {
+            task = scheduler->injection.jobs.front();
+            scheduler->injection.jobs.pop_front();
+        }
+    }
+
+    // Then steal the oldest job of another worker, starting from a random victim
+    if (!task) {
+        const size_t count = scheduler->queues.size();
+        const size_t start = nextVictim() % count;
+        for (size_t i = 0; i < count && !task; ++i) {
+            const size_t victim = (start + i) % count;
+            if (static_cast<int>(victim) == workerIndex) {
+                continue;
+            }
+
+            Scheduler::Queue& queue = *scheduler->queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                task = queue.jobs.front();
+                queue.jobs.pop_front();
+            }
+        }
+    }
+
+    if (!task) {
+        return false;
+    }
+
+    --scheduler->queued;
+    execute(task);
+    return true;
+}
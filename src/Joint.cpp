@@ -3,8 +3,6 @@
 // Constructor initializing with identity matrices
 Joint::Joint()
     : transform(glm::mat4(1.0f)),
-      bindWorldToJointTransform(glm::mat4(1.0f)),
-      currentJointToWorldTransform(glm::mat4(1.0f)),
       rotation(glm::vec3(0.0f)) {}
 
 // Destructor to ensure children are deleted
@@ -23,24 +21,6 @@ void Joint::setTransform(const glm::mat4& newTransform) {
     transform = newTransform;
 }
 
-// Getter and setter for bindWorldToJointTransform
-glm::mat4 Joint::getBindWorldToJointTransform() const {
-    return bindWorldToJointTransform;
-}
-
-void Joint::setBindWorldToJointTransform(const glm::mat4& newTransform) {
-    bindWorldToJointTransform = newTransform;
-}
-
-// Getter and setter for currentJointToWorldTransform
-glm::mat4 Joint::getCurrentJointToWorldTransform() const {
-    return currentJointToWorldTransform;
-}
-
-void Joint::setCurrentJointToWorldTransform(const glm::mat4& newTransform) {
-    currentJointToWorldTransform = newTransform;
-}
-
 
 // Getter for rotation
 glm::vec3 Joint::getRotation() const {
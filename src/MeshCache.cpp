@@ -0,0 +1,150 @@
+#include "MeshCache.h"
+#include "CpuProfiler.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const char MAGIC[4] = { 'M', 'E', 'S', 'H' };
+
+}
+
+const uint32_t MeshCache::VERSION;
+const size_t MeshCache::VERTEX_FLOATS;
+
+
+std::string MeshCache::getCachePath(const std::string& sourcePath) {
+    return sourcePath + ".meshcache";
+}
+
+
+uint64_t MeshCache::hashBytes(const char* begin, const char* end) {
+    const uint64_t prime = 0x100000001B3ull;
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    // FNV-1a over 8-byte words, then the tail byte by byte
+    const char* p = begin;
+    for (; end - p >= 8; p += 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        hash = (hash ^ word) * prime;
+        hash ^= hash >> 29;
+    }
+    for (; p < end; ++p) {
+        hash = (hash ^ static_cast<unsigned char>(*p)) * prime;
+    }
+
+    // Length last, so inputs that differ only in trailing zero bytes differ
+    return (hash ^ static_cast<uint64_t>(end - begin)) * prime;
+}
+
+
+bool MeshCache::load(const std::string& cachePath, uint64_t sourceHash, CachedMesh& out) {
+    PROFILE_SCOPE("MeshCache::load");
+
+    if (!out.file.open(cachePath) || out.file.getSize() < sizeof(Header)) {
+        out.file.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, out.file.begin(), sizeof(header));
+
+    const size_t vertexBytes = static_cast<size_t>(header.vertexFloatCount) * sizeof(float);
+    const size_t indexBytes = static_cast<size_t>(header.indexCount) * sizeof(unsigned int);
+    const size_t lodBytes = static_cast<size_t>(header.lodCount) * sizeof(LodEntry);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+        header.sourceHash != sourceHash ||
+        out.file.getSize() != sizeof(Header) + vertexBytes + indexBytes + lodBytes) {
+        out.file.close();
+        return false;
+    }
+
+    // The header is a multiple of 8 bytes and the mapping page-aligned, so both arrays are aligned
+    const char* payload = out.file.begin() + sizeof(Header);
+    out.vertexData = reinterpret_cast<const float*>(payload);
+    out.vertexFloatCount = static_cast<size_t>(header.vertexFloatCount);
+    out.indexData = reinterpret_cast<const unsigned int*>(payload + vertexBytes);
+    out.indexCount = static_cast<size_t>(header.indexCount);
+
+    // Indices must name whole vertices inside the vertex buffer
+    const size_t vertexCount = out.vertexFloatCount / VERTEX_FLOATS;
+    if (out.vertexFloatCount % VERTEX_FLOATS != 0) {
+        out.file.close();
+        return false;
+    }
+    for (size_t i = 0; i < out.indexCount; ++i) {
+        if (out.indexData[i] >= vertexCount) {
+            out.file.close();
+            return false;
+        }
+    }
+
+    // Levels must stay inside the index buffer
+    out.lods.resize(header.lodCount);
+    for (size_t i = 0; i < out.lods.size(); ++i) {
+        LodEntry entry;
+        std::memcpy(&entry, payload + vertexBytes + indexBytes + i * sizeof(LodEntry), sizeof(entry));
+        if (static_cast<uint64_t>(entry.firstIndex) + entry.indexCount > header.indexCount) {
+            out.file.close();
+            return false;
+        }
+        out.lods[i].firstIndex = entry.firstIndex;
+        out.lods[i].indexCount = entry.indexCount;
+        out.lods[i].error = entry.error;
+    }
+    out.boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+    out.boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+    return true;
+}
+
+
+bool MeshCache::store(const std::string& cachePath, uint64_t sourceHash,
+                      const std::vector<float>& vertexData, const std::vector<unsigned int>& indexData,
+                      const std::vector<MeshLod>& lods, const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    PROFILE_SCOPE("MeshCache::store");
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.sourceHash = sourceHash;
+    header.vertexFloatCount = vertexData.size();
+    header.indexCount = indexData.size();
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.reserved = 0;
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = boundsMin[i];
+        header.boundsMax[i] = boundsMax[i];
+    }
+
+    const std::string temporaryPath = cachePath + ".tmp";
+    {
+        std::ofstream file(temporaryPath.c_str(), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(vertexData.data()), vertexData.size() * sizeof(float));
+        file.write(reinterpret_cast<const char*>(indexData.data()), indexData.size() * sizeof(unsigned int));
+        for (size_t i = 0; i < lods.size(); ++i) {
+            LodEntry entry = { static_cast<uint32_t>(lods[i].firstIndex), static_cast<uint32_t>(lods[i].indexCount),
+                               lods[i].error };
+            file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        }
+        if (!file) {
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+
+    // Replace any stale blob in one step
+    std::remove(cachePath.c_str());
+    if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,252 @@
+#include "MeshOptimizer.h"
+#include "CpuProfiler.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+const size_t MeshOptimizer::VERTEX_CACHE_SIZE;
+
+namespace {
+
+// Forsyth's tuning constants
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+const unsigned int NO_TRIANGLE = ~0u;
+
+// Vertices in the cache score by recency (the last triangle's three a flat bonus);
+// vertices with few triangles left score higher so stragglers are finished early
+float vertexScore(int cachePosition, unsigned int remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            const float scaler = 1.0f / (MeshOptimizer::VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+        }
+    }
+
+    return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+}
+
+// Hashes and compares vertices in place by their bit patterns
+struct CornerHash {
+    const float* data;
+    size_t stride;
+
+    size_t operator()(size_t corner) const {
+        const float* vertex = data + corner * stride;
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (size_t i = 0; i < stride; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, vertex + i, sizeof(bits));
+            hash = (hash ^ bits) * 0x100000001B3ull;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+struct CornerEqual {
+    const float* data;
+    size_t stride;
+
+    bool operator()(size_t a, size_t b) const {
+        return std::memcmp(data + a * stride, data + b * stride, stride * sizeof(float)) == 0;
+    }
+};
+
+}
+
+
+void MeshOptimizer::weldVertices(const std::vector<float>& corners, size_t stride,
+                                 std::vector<float>& vertices, std::vector<unsigned int>& indices) {
+    PROFILE_SCOPE("MeshOptimizer::weldVertices");
+
+    const size_t cornerCount = stride ? corners.size() / stride : 0;
+    vertices.clear();
+    indices.clear();
+    indices.reserve(cornerCount);
+
+    // Corner -> first corner with the same bits -> its vertex
+    CornerHash hash = { corners.data(), stride };
+    CornerEqual equal = { corners.data(), stride };
+    std::unordered_map<size_t, unsigned int, CornerHash, CornerEqual> unique(cornerCount, hash, equal);
+
+    for (size_t corner = 0; corner < cornerCount; ++corner) {
+        const unsigned int next = static_cast<unsigned int>(vertices.size() / stride);
+        std::pair<std::unordered_map<size_t, unsigned int, CornerHash, CornerEqual>::iterator, bool> entry =
+            unique.insert(std::make_pair(corner, next));
+        if (entry.second) {
+            vertices.insert(vertices.end(), corners.begin() + corner * stride, corners.begin() + (corner + 1) * stride);
+        }
+        indices.push_back(entry.first->second);
+    }
+}
+
+
+void MeshOptimizer::optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexCache");
+
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return;
+    }
+
+    // Triangles around each vertex (compressed rows); the first `remaining[v]`
+    // entries of a row are the triangles not yet emitted
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++remaining[indices[i]];
+    }
+    std::vector<unsigned int> rowStart(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        rowStart[v + 1] = rowStart[v] + remaining[v];
+    }
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    {
+        std::vector<unsigned int> fill(rowStart.begin(), rowStart.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) {
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        score[v] = vertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<char> emitted(triangleCount, 0);
+    unsigned int best = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (triangleScore[t] > triangleScore[best]) {
+            best = static_cast<unsigned int>(t);
+        }
+    }
+
+    std::vector<unsigned int> order;
+    order.reserve(triangleCount * 3);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    nextCache.reserve(VERTEX_CACHE_SIZE + 3);
+    size_t scanCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        // Nothing in the cache has triangles left: continue with the next unemitted one
+        if (best == NO_TRIANGLE) {
+            while (emitted[scanCursor]) {
+                ++scanCursor;
+            }
+            best = static_cast<unsigned int>(scanCursor);
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        order.insert(order.end(), triangle, triangle + 3);
+        emitted[best] = 1;
+
+        // Retire the triangle from its vertices' rows
+        for (int k = 0; k < 3; ++k) {
+            const unsigned int v = triangle[k];
+            unsigned int* row = &adjacency[rowStart[v]];
+            for (unsigned int i = 0; i < remaining[v]; ++i) {
+                if (row[i] == best) {
+                    row[i] = row[remaining[v] - 1];
+                    --remaining[v];
+                    break;
+                }
+            }
+        }
+
+        // LRU update: the triangle's vertices move to the front
+        nextCache.assign(triangle, triangle + 3);
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        for (size_t i = 0; i < nextCache.size(); ++i) {
+            const unsigned int v = nextCache[i];
+            cachePosition[v] = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        // Rescore triangles around every vertex whose score changed; the best
+        // of those touching the cache is next
+        best = NO_TRIANGLE;
+        float bestScore = -1.0f;
+        for (unsigned int v : nextCache) {
+            const unsigned int* row = &adjacency[rowStart[v]];
+            for (unsigned int i = 0; i < remaining[v]; ++i) {
+                const unsigned int t = row[i];
+                triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > VERTEX_CACHE_SIZE) {
+            nextCache.resize(VERTEX_CACHE_SIZE);
+        }
+        cache.swap(nextCache);
+    }
+
+    indices.swap(order);
+}
+
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<float>& vertices, size_t stride,
+                                        std::vector<unsigned int>& indices) {
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexFetch");
+
+    const size_t vertexCount = stride ? vertices.size() / stride : 0;
+    std::vector<unsigned int> remap(vertexCount, NO_TRIANGLE);
+    std::vector<float> reordered;
+    reordered.reserve(vertices.size());
+
+    // Unreferenced vertices are dropped
+    for (unsigned int& index : indices) {
+        if (remap[index] == NO_TRIANGLE) {
+            remap[index] = static_cast<unsigned int>(reordered.size() / stride);
+            reordered.insert(reordered.end(), vertices.begin() + index * stride, vertices.begin() + (index + 1) * stride);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+
+float MeshOptimizer::averageCacheMissRatio(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                           size_t cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    // FIFO: a vertex is resident while fewer than `cacheSize` misses followed its own
+    std::vector<size_t> insertedAt(vertexCount, 0);
+    std::vector<char> seen(vertexCount, 0);
+    size_t misses = 0;
+    for (unsigned int v : indices) {
+        if (!seen[v] || misses - insertedAt[v] >= cacheSize) {
+            seen[v] = 1;
+            insertedAt[v] = misses;
+            ++misses;
+        }
+    }
+
+    return static_cast<float>(misses) / triangleCount;
+}
@@ -0,0 +1,88 @@
+#include "MeshRegistry.h"
+
+// Static members
+std::map<MeshRegistry::MeshKey, std::weak_ptr<Mesh>> MeshRegistry::meshes;
+
+
+void MeshData::addVertex(const glm::vec3& position, const glm::vec3& normal) {
+    vertexData.insert(vertexData.end(), {position.x, position.y, position.z});
+    vertexData.insert(vertexData.end(), {normal.x, normal.y, normal.z});
+}
+
+
+Mesh::Mesh() : VAO(0), VBO(0), EBO(0), indexCount(0), boundsMin(0.0f), boundsMax(0.0f) {}
+
+Mesh::~Mesh() {
+    // Cleanup OpenGL resources
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+
+MeshHandle MeshRegistry::acquire(const std::string& primitiveType, int lod, MeshBuilder builder) {
+    MeshKey key(primitiveType, lod);
+
+    // Reuse the mesh while any shape still holds it
+    auto it = meshes.find(key);
+    if (it != meshes.end()) {
+        if (MeshHandle existing = it->second.lock()) {
+            return existing;
+        }
+    }
+
+    MeshHandle mesh = upload(builder(lod));
+    meshes[key] = mesh;
+    return mesh;
+}
+
+
+int MeshRegistry::getLiveMeshCount() {
+    int count = 0;
+    for (auto it = meshes.begin(); it != meshes.end(); ) {
+        if (it->second.expired()) {
+            it = meshes.erase(it);
+        } else {
+            ++count;
+            ++it;
+        }
+    }
+    return count;
+}
+
+
+MeshHandle MeshRegistry::upload(const MeshData& data) {
+    MeshHandle mesh = std::make_shared<Mesh>();
+    mesh->indexCount = static_cast<GLsizei>(data.indexData.size());
+
+    // Bounds of the positions (first three floats of every six)
+    for (size_t i = 0; i + 2 < data.vertexData.size(); i += 6) {
+        glm::vec3 position(data.vertexData[i], data.vertexData[i + 1], data.vertexData[i + 2]);
+        mesh->boundsMin = (i == 0) ? position : glm::min(mesh->boundsMin, position);
+        mesh->boundsMax = (i == 0) ? position : glm::max(mesh->boundsMax, position);
+    }
+
+    // Create and bind VAO, VBO, and EBO
+    glGenVertexArrays(1, &mesh->VAO);
+    glGenBuffers(1, &mesh->VBO);
+    glGenBuffers(1, &mesh->EBO);
+
+    glBindVertexArray(mesh->VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->VBO);
+    glBufferData(GL_ARRAY_BUFFER, data.vertexData.size() * sizeof(float), data.vertexData.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.indexData.size() * sizeof(unsigned int), data.indexData.data(), GL_STATIC_DRAW);
+
+    // Configure vertex attributes; color comes from the material uniform
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0); // Position
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
+    glEnableVertexAttribArray(1);
+
+    glBindVertexArray(0); // Unbind VAO
+
+    return mesh;
+}
@@ -0,0 +1,407 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+const size_t MeshSimplifier::MAX_LOD_COUNT;
+const float MeshSimplifier::LOD_REDUCTION = 0.5f;
+const size_t MeshSimplifier::MIN_LOD_TRIANGLES;
+
+namespace {
+
+// Weight of the planes that hold open borders in place
+const double BOUNDARY_WEIGHT = 10.0;
+
+// A coarser level must drop at least this share of the previous level's triangles
+const float MIN_LOD_GAIN = 0.15f;
+
+// Symmetric 4x4 error quadric, upper triangle only
+struct Quadric {
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+    Quadric() : a2(0), ab(0), ac(0), ad(0), b2(0), bc(0), bd(0), c2(0), cd(0), d2(0) {}
+
+    // Squared distance to the plane ax + by + cz + d = 0, scaled by `weight`
+    void addPlane(double a, double b, double c, double d, double weight) {
+        a2 += weight * a * a; ab += weight * a * b; ac += weight * a * c; ad += weight * a * d;
+        b2 += weight * b * b; bc += weight * b * c; bd += weight * b * d;
+        c2 += weight * c * c; cd += weight * c * d;
+        d2 += weight * d * d;
+    }
+
+    void add(const Quadric& q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+    }
+
+    double evaluate(const float* p) const {
+        const double x = p[0], y = p[1], z = p[2];
+        return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+             + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+             + c2 * z * z + 2.0 * cd * z
+             + d2;
+    }
+};
+
+// Moving group `from` onto group `to`; the versions go stale when either changes
+struct Collapse {
+    float cost;
+    unsigned int from, to;
+    unsigned int fromVersion, toVersion;
+
+    bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+// Hashes and compares vertex positions (the first three floats) by their bit patterns
+struct PositionHash {
+    const float* data;
+    size_t stride;
+
+    size_t operator()(unsigned int vertex) const {
+        const float* position = data + vertex * stride;
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (int i = 0; i < 3; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, position + i, sizeof(bits));
+            hash = (hash ^ bits) * 0x100000001B3ull;
+        }
+        return static_cast<size_t>(hash ^ (hash >> 32));
+    }
+};
+
+struct PositionEqual {
+    const float* data;
+    size_t stride;
+
+    bool operator()(unsigned int a, unsigned int b) const {
+        return std::memcmp(data + a * stride, data + b * stride, 3 * sizeof(float)) == 0;
+    }
+};
+
+// Unnormalized normal of the triangle (p0, p1, p2)
+void triangleNormal(const float* p0, const float* p1, const float* p2, double normal[3]) {
+    const double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+// Squared distance between the attributes after the position
+float attributeDistance(const float* a, const float* b, size_t stride) {
+    float distance = 0.0f;
+    for (size_t i = 3; i < stride; ++i) {
+        const float delta = a[i] - b[i];
+        distance += delta * delta;
+    }
+    return distance;
+}
+
+inline uint64_t edgeKey(unsigned int a, unsigned int b) {
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+}
+
+}
+
+
+float MeshSimplifier::simplify(const std::vector<float>& vertices, size_t stride,
+                               const std::vector<unsigned int>& indices, size_t targetIndexCount,
+                               std::vector<unsigned int>& out) {
+    PROFILE_SCOPE("MeshSimplifier::simplify");
+
+    const size_t vertexCount = stride ? vertices.size() / stride : 0;
+    if (stride < 3 || indices.size() <= targetIndexCount) {
+        out = indices;
+        return 0.0f;
+    }
+
+    // Vertices sharing a position (split only by their normal) collapse together as one group
+    std::vector<unsigned int> groupOf(vertexCount);
+    std::vector<unsigned int> groupVertex;
+    {
+        PositionHash hash = { vertices.data(), stride };
+        PositionEqual equal = { vertices.data(), stride };
+        std::unordered_map<unsigned int, unsigned int, PositionHash, PositionEqual> unique(vertexCount, hash, equal);
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            const unsigned int next = static_cast<unsigned int>(groupVertex.size());
+            std::pair<std::unordered_map<unsigned int, unsigned int, PositionHash, PositionEqual>::iterator, bool> entry =
+                unique.insert(std::make_pair(v, next));
+            if (entry.second) {
+                groupVertex.push_back(v);
+            }
+            groupOf[v] = entry.first->second;
+        }
+    }
+    const size_t groupCount = groupVertex.size();
+
+    // Members of each group (compressed rows)
+    std::vector<unsigned int> memberStart(groupCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        ++memberStart[groupOf[v] + 1];
+    }
+    for (size_t g = 0; g < groupCount; ++g) {
+        memberStart[g + 1] += memberStart[g];
+    }
+    std::vector<unsigned int> members(vertexCount);
+    {
+        std::vector<unsigned int> fill(memberStart.begin(), memberStart.end() - 1);
+        for (unsigned int v = 0; v < vertexCount; ++v) {
+            members[fill[groupOf[v]]++] = v;
+        }
+    }
+
+    auto position = [&](unsigned int group) {
+        return &vertices[groupVertex[group] * stride];
+    };
+
+    // Vertex of `group` whose normal best matches `vertex`, for corners that move across a seam
+    auto closestMember = [&](unsigned int group, unsigned int vertex) {
+        unsigned int best = members[memberStart[group]];
+        float bestDistance = attributeDistance(&vertices[best * stride], &vertices[vertex * stride], stride);
+        for (unsigned int i = memberStart[group] + 1; i < memberStart[group + 1]; ++i) {
+            const float distance = attributeDistance(&vertices[members[i] * stride], &vertices[vertex * stride], stride);
+            if (distance < bestDistance) {
+                best = members[i];
+                bestDistance = distance;
+            }
+        }
+        return best;
+    };
+
+    // Triangles in group ids, and the vertex each corner will be emitted with
+    std::vector<unsigned int> triangleGroups;
+    std::vector<unsigned int> triangleCorners;
+    triangleGroups.reserve(indices.size());
+    triangleCorners.reserve(indices.size());
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const unsigned int g0 = groupOf[indices[i]], g1 = groupOf[indices[i + 1]], g2 = groupOf[indices[i + 2]];
+        if (g0 == g1 || g1 == g2 || g0 == g2) {
+            continue;
+        }
+        triangleGroups.insert(triangleGroups.end(), { g0, g1, g2 });
+        triangleCorners.insert(triangleCorners.end(), { indices[i], indices[i + 1], indices[i + 2] });
+    }
+    const size_t triangleCount = triangleGroups.size() / 3;
+    std::vector<char> triangleLive(triangleCount, 1);
+    size_t liveTriangles = triangleCount;
+
+    // Quadrics from the face planes; edges used by one triangle add a
+    // perpendicular plane so open borders keep their outline
+    std::vector<Quadric> quadrics(groupCount);
+    std::vector<std::vector<unsigned int> > groupTriangles(groupCount);
+    std::unordered_map<uint64_t, std::pair<unsigned int, unsigned int> > edgeUse; // (uses, triangle)
+    for (unsigned int t = 0; t < triangleCount; ++t) {
+        const unsigned int* g = &triangleGroups[t * 3];
+        double normal[3];
+        triangleNormal(position(g[0]), position(g[1]), position(g[2]), normal);
+        const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if (length > 0.0) {
+            const float* p0 = position(g[0]);
+            const double a = normal[0] / length, b = normal[1] / length, c = normal[2] / length;
+            const double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+            for (int k = 0; k < 3; ++k) {
+                quadrics[g[k]].addPlane(a, b, c, d, 1.0);
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            groupTriangles[g[k]].push_back(t);
+            std::pair<unsigned int, unsigned int>& use = edgeUse[edgeKey(g[k], g[(k + 1) % 3])];
+            ++use.first;
+            use.second = t;
+        }
+    }
+    for (std::unordered_map<uint64_t, std::pair<unsigned int, unsigned int> >::const_iterator it = edgeUse.begin();
+         it != edgeUse.end(); ++it) {
+        if (it->second.first != 1) {
+            continue;
+        }
+        const unsigned int* g = &triangleGroups[it->second.second * 3];
+        const unsigned int ga = static_cast<unsigned int>(it->first >> 32);
+        const unsigned int gb = static_cast<unsigned int>(it->first & 0xFFFFFFFFu);
+        const float* pa = position(ga);
+        const float* pb = position(gb);
+
+        double faceNormal[3];
+        triangleNormal(position(g[0]), position(g[1]), position(g[2]), faceNormal);
+        const double edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+        double m[3] = { edge[1] * faceNormal[2] - edge[2] * faceNormal[1],
+                        edge[2] * faceNormal[0] - edge[0] * faceNormal[2],
+                        edge[0] * faceNormal[1] - edge[1] * faceNormal[0] };
+        const double length = std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]);
+        if (length == 0.0) {
+            continue;
+        }
+        m[0] /= length; m[1] /= length; m[2] /= length;
+        const double d = -(m[0] * pa[0] + m[1] * pa[1] + m[2] * pa[2]);
+        quadrics[ga].addPlane(m[0], m[1], m[2], d, BOUNDARY_WEIGHT);
+        quadrics[gb].addPlane(m[0], m[1], m[2], d, BOUNDARY_WEIGHT);
+    }
+
+    // Cheapest collapse first; entries whose groups changed since are skipped when popped
+    std::vector<unsigned int> version(groupCount, 0);
+    std::vector<char> removed(groupCount, 0);
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> > heap;
+
+    auto pushEdge = [&](unsigned int a, unsigned int b) {
+        Quadric combined = quadrics[a];
+        combined.add(quadrics[b]);
+        const double costAB = combined.evaluate(position(b)); // a moves onto b
+        const double costBA = combined.evaluate(position(a));
+
+        Collapse collapse;
+        collapse.from = costAB <= costBA ? a : b;
+        collapse.to = costAB <= costBA ? b : a;
+        collapse.cost = static_cast<float>(std::max(0.0, std::min(costAB, costBA)));
+        collapse.fromVersion = version[collapse.from];
+        collapse.toVersion = version[collapse.to];
+        heap.push(collapse);
+    };
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const unsigned int* g = &triangleGroups[t * 3];
+        for (int k = 0; k < 3; ++k) {
+            pushEdge(g[k], g[(k + 1) % 3]);
+        }
+    }
+
+    float maxError = 0.0f;
+    std::vector<unsigned int> neighbours;
+    while (liveTriangles * 3 > targetIndexCount && !heap.empty()) {
+        const Collapse collapse = heap.top();
+        heap.pop();
+        if (removed[collapse.from] || removed[collapse.to] ||
+            version[collapse.from] != collapse.fromVersion || version[collapse.to] != collapse.toVersion) {
+            continue;
+        }
+
+        // Reject collapses that would flip or flatten a surviving triangle; the
+        // edge is queued again once its neighbourhood changes
+        const float* target = position(collapse.to);
+        bool flips = false;
+        const std::vector<unsigned int>& around = groupTriangles[collapse.from];
+        for (size_t i = 0; i < around.size() && !flips; ++i) {
+            const unsigned int t = around[i];
+            const unsigned int* g = &triangleGroups[t * 3];
+            if (!triangleLive[t] || g[0] == collapse.to || g[1] == collapse.to || g[2] == collapse.to) {
+                continue;
+            }
+            const float* before[3];
+            const float* after[3];
+            for (int k = 0; k < 3; ++k) {
+                before[k] = position(g[k]);
+                after[k] = (g[k] == collapse.from) ? target : before[k];
+            }
+            double normalBefore[3], normalAfter[3];
+            triangleNormal(before[0], before[1], before[2], normalBefore);
+            triangleNormal(after[0], after[1], after[2], normalAfter);
+            flips = normalBefore[0] * normalAfter[0] + normalBefore[1] * normalAfter[1] +
+                    normalBefore[2] * normalAfter[2] <= 0.0;
+        }
+        if (flips) {
+            continue;
+        }
+
+        maxError = std::max(maxError, std::sqrt(collapse.cost));
+        quadrics[collapse.to].add(quadrics[collapse.from]);
+        removed[collapse.from] = 1;
+        ++version[collapse.to];
+
+        // Triangles on the collapsed edge vanish; the rest move onto the survivor
+        std::vector<unsigned int>& survivor = groupTriangles[collapse.to];
+        for (size_t i = 0; i < around.size(); ++i) {
+            const unsigned int t = around[i];
+            unsigned int* g = &triangleGroups[t * 3];
+            if (!triangleLive[t]) {
+                continue;
+            }
+            if (g[0] == collapse.to || g[1] == collapse.to || g[2] == collapse.to) {
+                triangleLive[t] = 0;
+                --liveTriangles;
+                continue;
+            }
+            for (int k = 0; k < 3; ++k) {
+                if (g[k] == collapse.from) {
+                    g[k] = collapse.to;
+                    triangleCorners[t * 3 + k] = closestMember(collapse.to, triangleCorners[t * 3 + k]);
+                }
+            }
+            survivor.push_back(t);
+        }
+        std::vector<unsigned int>().swap(groupTriangles[collapse.from]);
+
+        // Drop dead triangles from the survivor and requeue its edges with the merged quadric
+        neighbours.clear();
+        size_t kept = 0;
+        for (size_t i = 0; i < survivor.size(); ++i) {
+            const unsigned int t = survivor[i];
+            if (!triangleLive[t]) {
+                continue;
+            }
+            survivor[kept++] = t;
+            for (int k = 0; k < 3; ++k) {
+                if (triangleGroups[t * 3 + k] != collapse.to) {
+                    neighbours.push_back(triangleGroups[t * 3 + k]);
+                }
+            }
+        }
+        survivor.resize(kept);
+
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (size_t i = 0; i < neighbours.size(); ++i) {
+            pushEdge(collapse.to, neighbours[i]);
+        }
+    }
+
+    out.clear();
+    out.reserve(liveTriangles * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (triangleLive[t]) {
+            out.insert(out.end(), triangleCorners.begin() + t * 3, triangleCorners.begin() + t * 3 + 3);
+        }
+    }
+    return maxError;
+}
+
+
+void MeshSimplifier::buildLodChain(const std::vector<float>& vertices, size_t stride,
+                                   std::vector<unsigned int>& indices, std::vector<MeshLod>& lods) {
+    PROFILE_SCOPE("MeshSimplifier::buildLodChain");
+
+    lods.clear();
+    MeshLod full = { 0, indices.size(), 0.0f };
+    lods.push_back(full);
+
+    const size_t vertexCount = stride ? vertices.size() / stride : 0;
+    std::vector<unsigned int> previous(indices);
+    std::vector<unsigned int> simplified;
+    float error = 0.0f;
+
+    while (lods.size() < MAX_LOD_COUNT) {
+        const size_t targetTriangles = static_cast<size_t>(previous.size() / 3 * LOD_REDUCTION);
+        if (targetTriangles < MIN_LOD_TRIANGLES) {
+            break;
+        }
+
+        // Each level simplifies the one before, so its error against the full mesh is at most the sum
+        error += simplify(vertices, stride, previous, targetTriangles * 3, simplified);
+        if (simplified.size() > previous.size() * (1.0f - MIN_LOD_GAIN)) {
+            break;
+        }
+
+        MeshOptimizer::optimizeVertexCache(simplified, vertexCount);
+        MeshLod lod = { indices.size(), simplified.size(), error };
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+        lods.push_back(lod);
+        previous.swap(simplified);
+    }
+}
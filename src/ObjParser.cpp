@@ -0,0 +1,394 @@
+#include "ObjParser.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Exact powers of ten representable in a double
+const double POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+const int MAX_EXACT_POWER = 22;
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline void skipBlanks(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+}
+
+// Start of the line after `p`
+inline const char* nextLine(const char* p, const char* end) {
+    const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return newline ? newline + 1 : end;
+}
+
+// Keyword test for the start of a line: "v ", "vn ", "f "
+inline bool startsWith(const char* p, const char* end, const char* keyword, size_t length) {
+    return static_cast<size_t>(end - p) > length && std::memcmp(p, keyword, length) == 0 &&
+           (p[length] == ' ' || p[length] == '\t');
+}
+
+// Skip the rest of a face corner ("/t/n" or trailing garbage)
+inline void skipToken(const char*& p, const char* end) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+        ++p;
+    }
+}
+
+// Chunks smaller than this are not worth a job of their own
+const size_t MIN_CHUNK_BYTES = 256 * 1024;
+const size_t CHUNKS_PER_THREAD = 4;
+
+// A newline-aligned slice of the file, its line counts and their prefix sums
+struct Chunk {
+    const char* begin;
+    const char* end;
+    size_t vertexCount, normalCount, faceCount;
+    size_t vertexBase, normalBase, faceBase;
+
+    Chunk() : begin(nullptr), end(nullptr), vertexCount(0), normalCount(0), faceCount(0),
+              vertexBase(0), normalBase(0), faceBase(0) {}
+};
+
+// Where this parse starts writing in each output array (non-zero when appending)
+struct ChunkOutput {
+    size_t vertexStart, normalStart, faceStart;
+};
+
+void countChunk(Chunk& chunk) {
+    for (const char* line = chunk.begin; line < chunk.end; line = nextLine(line, chunk.end)) {
+        const char* p = line;
+        skipBlanks(p, chunk.end);
+        if (startsWith(p, chunk.end, "v", 1)) {
+            ++chunk.vertexCount;
+        } else if (startsWith(p, chunk.end, "vn", 2)) {
+            ++chunk.normalCount;
+        } else if (startsWith(p, chunk.end, "f", 1)) {
+            ++chunk.faceCount;
+        }
+    }
+}
+
+// OBJ indices are 1-based and global to the file; negative ones count back
+// from the last element defined so far, which needs the chunk's prefix sum
+inline int resolveIndex(int index, size_t definedSoFar) {
+    return index < 0 ? static_cast<int>(definedSoFar) + index : index - 1;
+}
+
+void parseChunk(const Chunk& chunk, const ChunkOutput& target, ObjParser::FaceFormat format, ObjData& out) {
+    const char* end = chunk.end;
+
+    // Running counts within the whole file, for relative indices
+    size_t vertices = chunk.vertexBase;
+    size_t normals = chunk.normalBase;
+    size_t faces = chunk.faceBase;
+
+    for (const char* line = chunk.begin; line < end; line = nextLine(line, end)) {
+        const char* p = line;
+        skipBlanks(p, end);
+
+        if (startsWith(p, end, "v", 1) || startsWith(p, end, "vn", 2)) {
+            const bool isNormal = p[1] == 'n';
+            p += isNormal ? 2 : 1;
+
+            glm::vec3& value = isNormal ? out.normals[target.normalStart + normals++]
+                                        : out.vertices[target.vertexStart + vertices++];
+            for (int i = 0; i < 3; ++i) {
+                skipBlanks(p, end);
+                value[i] = ObjParser::parseFloat(p, end);
+            }
+
+        } else if (startsWith(p, end, "f", 1)) {
+            ++p;
+
+            // First three corners, written in place
+            int* face = &out.faceIndices[(target.faceStart + faces++) * out.faceStride];
+            for (int i = 0; i < 3; ++i) {
+                skipBlanks(p, end);
+                const int vertexIndex = resolveIndex(ObjParser::parseInt(p, end), vertices);
+                int normalIndex = vertexIndex; // "v" and "v/t" corners reuse the vertex index
+
+                if (format == ObjParser::VertexNormalPairs && p < end && *p == '/') {
+                    // The second '/' must be in this corner, not a later one
+                    const char* tokenEnd = p;
+                    skipToken(tokenEnd, end);
+                    const char* slash = static_cast<const char*>(std::memchr(p + 1, '/', tokenEnd - p - 1));
+                    if (slash) {
+                        p = slash + 1;
+                        normalIndex = resolveIndex(ObjParser::parseInt(p, end), normals);
+                    }
+                }
+                skipToken(p, end);
+
+                if (format == ObjParser::VertexNormalPairs) {
+                    face[i * 2] = vertexIndex;
+                    face[i * 2 + 1] = normalIndex;
+                } else {
+                    face[i] = vertexIndex;
+                }
+            }
+        }
+    }
+}
+
+}
+
+
+MappedFile::MappedFile() : data(nullptr), size(0), mapped(false) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            madvise(address, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            data = static_cast<const char*>(address);
+            size = static_cast<size_t>(info.st_size);
+            mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+
+    // Read the whole file instead
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    fallback.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    data = fallback.empty() ? nullptr : fallback.data();
+    size = fallback.size();
+    return true;
+}
+
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped) {
+        munmap(const_cast<char*>(data), size);
+    }
+#endif
+    data = nullptr;
+    size = 0;
+    mapped = false;
+    fallback.clear();
+}
+
+
+bool ObjParser::parseFile(const std::string& path, FaceFormat format, ObjData& out,
+                          const ProgressCallback& progress) {
+    MappedFile file;
+    if (!file.open(path)) {
+        return false;
+    }
+
+    return parseBuffer(file.begin(), file.end(), format, out, progress);
+}
+
+
+bool ObjParser::parseBuffer(const char* begin, const char* end, FaceFormat format, ObjData& out,
+                            const ProgressCallback& progress) {
+    PROFILE_SCOPE("ObjParser::parseBuffer");
+
+    if (!begin || begin >= end) {
+        return true;
+    }
+
+    // Split at newline boundaries, a few chunks per core so stealing can balance them
+    const size_t size = static_cast<size_t>(end - begin);
+    const size_t maxChunks = (JobSystem::getWorkerCount() + 1) * CHUNKS_PER_THREAD;
+    const size_t chunkCount = std::max<size_t>(1, std::min(maxChunks, size / MIN_CHUNK_BYTES));
+
+    std::vector<Chunk> chunks(chunkCount);
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* start = begin + size * i / chunkCount;
+        chunks[i].begin = i == 0 ? begin : nextLine(start - 1, end);
+    }
+    for (size_t i = 0; i < chunkCount; ++i) {
+        chunks[i].end = i + 1 < chunkCount ? chunks[i + 1].begin : end;
+    }
+
+    // Both passes read every byte once; report progress over their sum
+    std::atomic<size_t> bytesDone(0);
+    std::atomic<bool> cancelled(false);
+    auto chunkDone = [&](const Chunk& chunk) {
+        const size_t done = bytesDone += static_cast<size_t>(chunk.end - chunk.begin);
+        if (progress && !progress(static_cast<float>(done) / (2.0f * size))) {
+            cancelled = true;
+        }
+    };
+
+    // Counting pass over every chunk in parallel
+    JobSystem::parallelFor(0, chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last && !cancelled; ++i) {
+            countChunk(chunks[i]);
+            chunkDone(chunks[i]);
+        }
+    });
+    if (cancelled) {
+        return false;
+    }
+
+    // Prefix sums give each chunk its place in the output and its index base
+    size_t vertexTotal = 0, normalTotal = 0, faceTotal = 0;
+    for (Chunk& chunk : chunks) {
+        chunk.vertexBase = vertexTotal;
+        chunk.normalBase = normalTotal;
+        chunk.faceBase = faceTotal;
+        vertexTotal += chunk.vertexCount;
+        normalTotal += chunk.normalCount;
+        faceTotal += chunk.faceCount;
+    }
+
+    // Size the arrays once; chunks then write disjoint ranges directly
+    out.faceStride = format == VertexNormalPairs ? 6 : 3;
+    const ChunkOutput target = { out.vertices.size(), out.normals.size(), out.getFaceCount() };
+    out.vertices.resize(target.vertexStart + vertexTotal);
+    out.normals.resize(target.normalStart + normalTotal);
+    out.faceIndices.resize((target.faceStart + faceTotal) * out.faceStride);
+
+    JobSystem::parallelFor(0, chunkCount, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last && !cancelled; ++i) {
+            parseChunk(chunks[i], target, format, out);
+            chunkDone(chunks[i]);
+        }
+    });
+
+    return !cancelled;
+}
+
+
+// Decimal float with optional sign, fraction and exponent; anything else goes to strtof
+float ObjParser::parseFloat(const char*& p, const char* end) {
+    const char* start = p;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    if (p >= end || !(isDigit(*p) || *p == '.')) {
+        // inf, nan, or malformed: defer to the C library on a bounded copy
+        char buffer[64];
+        size_t length = 0;
+        p = start;
+        while (p < end && length < sizeof(buffer) - 1 && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+            buffer[length++] = *p++;
+        }
+        buffer[length] = '\0';
+        return std::strtof(buffer, nullptr);
+    }
+
+    // Up to 19 significant digits fit in the mantissa; later ones only shift the exponent
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    while (p < end && isDigit(*p)) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa) ++digits;
+        } else {
+            ++exponent;
+        }
+        ++p;
+    }
+    if (p < end && *p == '.') {
+        ++p;
+        while (p < end && isDigit(*p)) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa) ++digits;
+                --exponent;
+            }
+            ++p;
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char* exponentStart = p;
+        ++p;
+        bool negativeExponent = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negativeExponent = *p == '-';
+            ++p;
+        }
+        if (p < end && isDigit(*p)) {
+            int value = 0;
+            while (p < end && isDigit(*p)) {
+                if (value < 10000) value = value * 10 + (*p - '0');
+                ++p;
+            }
+            exponent += negativeExponent ? -value : value;
+        } else {
+            p = exponentStart; // Not an exponent after all
+        }
+    }
+
+    // Exact power-of-ten scaling in double, rounded once to float
+    double result = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        while (exponent < -MAX_EXACT_POWER) {
+            result /= POWERS_OF_TEN[MAX_EXACT_POWER];
+            exponent += MAX_EXACT_POWER;
+        }
+        result /= POWERS_OF_TEN[-exponent];
+    } else {
+        while (exponent > MAX_EXACT_POWER) {
+            result *= POWERS_OF_TEN[MAX_EXACT_POWER];
+            exponent -= MAX_EXACT_POWER;
+        }
+        result *= POWERS_OF_TEN[exponent];
+    }
+
+    return static_cast<float>(negative ? -result : result);
+}
+
+
+int ObjParser::parseInt(const char*& p, const char* end) {
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    int value = 0;
+    while (p < end && isDigit(*p)) {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+
+    return negative ? -value : value;
+}
@@ -18,6 +18,25 @@ void ParticleSystem::reset() {
     m_state = m_initialState;
 }
 
+void ParticleSystem::updateBounds() {
+    if (m_state.empty()) {
+        boundsValid = false;
+        return;
+    }
+
+    // Positions are the even entries of the interleaved state
+    glm::vec3 minCorner = m_state[0];
+    glm::vec3 maxCorner = m_state[0];
+    for (size_t i = 2; i < m_state.size(); i += 2) {
+        minCorner = glm::min(minCorner, m_state[i]);
+        maxCorner = glm::max(maxCorner, m_state[i]);
+    }
+
+    // Pad by the radius of the rendered particle spheres
+    const glm::vec3 padding(0.05f);
+    setLocalBounds(minCorner - padding, maxCorner + padding);
+}
+
 std::vector<glm::vec3> ParticleSystem::getState() const {
     return m_state;
 }
@@ -25,3 +44,7 @@ std::vector<glm::vec3> ParticleSystem::getState() const {
 void ParticleSystem::setState(const std::vector<glm::vec3>& newState) {
     m_state = newState;
 }
+
+const std::vector<glm::vec3>& ParticleSystem::getInitialState() const {
+    return m_initialState;
+}
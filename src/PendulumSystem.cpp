@@ -1,5 +1,7 @@
 #include "PendulumSystem.h"
 #include "SimpleCloth.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
 #include <cmath> // For math functions like sin, cos, sqrt
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -370,6 +372,7 @@ void PendulumSystem::setupFaces() {
 
 
 void PendulumSystem::updateParticles() {
+    PROFILE_SCOPE("PendulumSystem::updateParticles");
 
     particleVertices.clear(); // Reset
 
@@ -401,6 +404,7 @@ void PendulumSystem::updateParticles() {
 
 
 void PendulumSystem::updateSprings() {
+    PROFILE_SCOPE("PendulumSystem::updateSprings");
 
     springVertices.clear();
 
@@ -430,6 +434,7 @@ void PendulumSystem::updateSprings() {
 }
 
 void PendulumSystem::updateWireframe() {
+    PROFILE_SCOPE("PendulumSystem::updateWireframe");
 
     wireVertices.clear();
 
@@ -482,6 +487,7 @@ void PendulumSystem::updateWireframe() {
 
 
 void PendulumSystem::updateFaces() {
+    PROFILE_SCOPE("PendulumSystem::updateFaces");
 
     faceVertices.clear();
     faceIndices.clear();
@@ -573,6 +579,7 @@ void PendulumSystem::updateFaces() {
 // for a given state, evaluate f(X,t)
 
 std::vector<glm::vec3> PendulumSystem::evalF(const std::vector<glm::vec3>& state) {
+    PROFILE_SCOPE("PendulumSystem::evalF");
     std::vector<glm::vec3> f;
     int clothSize = static_cast<int>(sqrt(m_numParticles));
 
@@ -593,75 +600,81 @@ std::vector<glm::vec3> PendulumSystem::evalF(const std::vector<glm::vec3>& state
         n = glm::normalize(n);
     }
 
-    for (unsigned int i = 0; i < m_numParticles; i++) {
-        glm::vec3 pos = state[2 * i];
-        glm::vec3 vel = state[2 * i + 1];
-        f.push_back(vel);
-
-        // GRAVITY
-        glm::vec3 f_Gravity = glm::vec3(0.0f, m_gravity * m_mass, 0.0f);
-
-        // DRAG
-        glm::vec3 f_Drag = -m_drag * vel;
-
-        // NET FORCE
-        glm::vec3 f_Net = f_Gravity + f_Drag;
-
-        // SPRING FORCES
-        for (const auto& spring : springs) {
-            int i0 = static_cast<int>(spring[0]);
-            int i1 = static_cast<int>(spring[1]);
-            if (i0 != i && i1 != i) continue;
-
-            glm::vec3 p0 = state[2 * i0];
-            glm::vec3 p1 = state[2 * i1];
-            float restLength = spring[2], stiffness = spring[3];
-
-            glm::vec3 dir = p1 - p0;
-            float len = glm::length(dir);
-
-            if (len > 0.0f) {
-                glm::vec3 springForce = -stiffness * (len - restLength) * glm::normalize(dir);
-                if (i0 == i) f_Net -= springForce;
-                if (i1 == i) f_Net += springForce;
+    // Per-frame values shared by every particle
+    f.resize(2 * m_numParticles);
+    SimpleCloth* cloth = dynamic_cast<SimpleCloth*>(this);
+    const float time = glfwGetTime();
+
+    // Each particle's derivative only depends on the input state, so particles are split across the job system
+    JobSystem::parallelFor(0, m_numParticles, 64, [&](size_t first, size_t last) {
+        for (int i = static_cast<int>(first); i < static_cast<int>(last); i++) {
+            glm::vec3 pos = state[2 * i];
+            glm::vec3 vel = state[2 * i + 1];
+            f[2 * i] = vel;
+
+            // GRAVITY
+            glm::vec3 f_Gravity = glm::vec3(0.0f, m_gravity * m_mass, 0.0f);
+
+            // DRAG
+            glm::vec3 f_Drag = -m_drag * vel;
+
+            // NET FORCE
+            glm::vec3 f_Net = f_Gravity + f_Drag;
+
+            // SPRING FORCES
+            for (const auto& spring : springs) {
+                int i0 = static_cast<int>(spring[0]);
+                int i1 = static_cast<int>(spring[1]);
+                if (i0 != i && i1 != i) continue;
+
+                glm::vec3 p0 = state[2 * i0];
+                glm::vec3 p1 = state[2 * i1];
+                float restLength = spring[2], stiffness = spring[3];
+
+                glm::vec3 dir = p1 - p0;
+                float len = glm::length(dir);
+
+                if (len > 0.0f) {
+                    glm::vec3 springForce = -stiffness * (len - restLength) * glm::normalize(dir);
+                    if (i0 == i) f_Net -= springForce;
+                    if (i1 == i) f_Net += springForce;
+                }
             }
-        }
 
-        // wind forces
-        SimpleCloth* cloth = dynamic_cast<SimpleCloth*>(this);
-        if (isCloth && cloth && particles[i].w != 1.0f) {
-            float time = glfwGetTime();
-            int row = i / clothSize;
-            int col = i % clothSize;
+            // wind forces
+            if (isCloth && cloth && particles[i].w != 1.0f) {
+                int row = i / clothSize;
+                int col = i % clothSize;
 
-            float waveFrequency = 10.0f;   
-            float waveAmplitude = 4.0f;   
-            float waveLength = 3.0f;     
+                float waveFrequency = 10.0f;   
+                float waveAmplitude = 4.0f;   
+                float waveLength = 3.0f;     
 
-            float flutterFrequency = 8.0f;
-            float flutterAmplitude = 0.08f;
+                float flutterFrequency = 8.0f;
+                float flutterAmplitude = 0.08f;
 
-            if (cloth->getMovement()) {
-                float sidewaysWave = sin(time * waveFrequency + col / waveLength + row * 0.1f) * waveAmplitude;
+                if (cloth->getMovement()) {
+                    float sidewaysWave = sin(time * waveFrequency + col / waveLength + row * 0.1f) * waveAmplitude;
                 
-                float verticalFlutter = sin(time * flutterFrequency + col * 0.4f + row * 0.8f) * flutterAmplitude;
+                    float verticalFlutter = sin(time * flutterFrequency + col * 0.4f + row * 0.8f) * flutterAmplitude;
 
-                f_Net += glm::vec3(sidewaysWave, verticalFlutter, 0.0f);
-            }
+                    f_Net += glm::vec3(sidewaysWave, verticalFlutter, 0.0f);
+                }
 
-            if (cloth->getWind()) {
-                glm::vec3 windDirNorm = glm::normalize(cloth->getWindDirection());
-                glm::vec3 windForce = cloth->getWindIntensity() * windDirNorm;
-                f_Net += windForce;
+                if (cloth->getWind()) {
+                    glm::vec3 windDirNorm = glm::normalize(cloth->getWindDirection());
+                    glm::vec3 windForce = cloth->getWindIntensity() * windDirNorm;
+                    f_Net += windForce;
+                }
             }
-        }
 
-        if (particles[i].w == 1.0f) {
-            f.push_back(glm::vec3(0.0f));
-        } else {
-            f.push_back(f_Net / m_mass);
+            if (particles[i].w == 1.0f) {
+                f[2 * i + 1] = glm::vec3(0.0f);
+            } else {
+                f[2 * i + 1] = f_Net / m_mass;
+            }
         }
-    }
+    });
 
     return f;
 }
@@ -0,0 +1,266 @@
+#include "RenderQueue.h"
+#include "CompactVertex.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Order by mesh first, then material, so identical state ends up adjacent
+bool drawItemLess(const DrawItem& a, const DrawItem& b) {
+    if (a.VAO != b.VAO) return a.VAO < b.VAO;
+    if (a.firstIndex != b.firstIndex) return a.firstIndex < b.firstIndex;
+    if (a.indexCount != b.indexCount) return a.indexCount < b.indexCount;
+    if (a.color.r != b.color.r) return a.color.r < b.color.r;
+    if (a.color.g != b.color.g) return a.color.g < b.color.g;
+    return a.color.b < b.color.b;
+}
+
+bool sameMesh(const DrawItem& a, const DrawItem& b) {
+    return a.VAO == b.VAO && a.firstIndex == b.firstIndex && a.indexCount == b.indexCount;
+}
+
+}
+
+
+RenderQueue::RenderQueue()
+    : instanceVBO(0), instanceCapacity(0), drawCallCount(0), instancedBatchCount(0), triangleCount(0),
+      modelLoc(-1), normalMatrixLoc(-1), colorLoc(-1), lastColor(0.0f) {}
+
+RenderQueue::~RenderQueue() {
+    if (instanceVBO) glDeleteBuffers(1, &instanceVBO);
+}
+
+void RenderQueue::clear() {
+    items.clear();
+}
+
+void RenderQueue::submit(GLuint VAO, GLsizei indexCount, const glm::vec3& color,
+                         const glm::mat4& model, const glm::mat3& normalMatrix,
+                         const glm::vec3& positionOffset, const glm::vec3& positionScale) {
+    submitRange(VAO, 0, indexCount, color, model, normalMatrix, positionOffset, positionScale);
+}
+
+void RenderQueue::submitRange(GLuint VAO, GLsizei firstIndex, GLsizei indexCount, const glm::vec3& color,
+                              const glm::mat4& model, const glm::mat3& normalMatrix,
+                              const glm::vec3& positionOffset, const glm::vec3& positionScale) {
+    DrawItem item;
+    item.VAO = VAO;
+    item.firstIndex = firstIndex;
+    item.indexCount = indexCount;
+    item.color = color;
+    item.model = model;
+    item.normalMatrix = normalMatrix;
+    item.positionOffset = positionOffset;
+    item.positionScale = positionScale;
+    items.push_back(item);
+}
+
+
+void RenderQueue::flush(GLuint shaderProgram, GLuint instancedProgram) {
+
+    drawCallCount = 0;
+    instancedBatchCount = 0;
+    triangleCount = 0;
+
+    if (items.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        triangleCount += items[i].indexCount / 3;
+    }
+
+    std::sort(items.begin(), items.end(), drawItemLess);
+
+    // Look up the regular program's uniforms once per flush
+    modelLoc = glGetUniformLocation(shaderProgram, "model");
+    normalMatrixLoc = glGetUniformLocation(shaderProgram, "normalMatrix");
+    colorLoc = glGetUniformLocation(shaderProgram, "material.color");
+
+    // First pass: meshes used by a single item are drawn with the regular program
+    bool hasBatches = false;
+    for (size_t begin = 0; begin < items.size(); ) {
+        size_t end = begin + 1;
+        while (end < items.size() && sameMesh(items[begin], items[end])) {
+            ++end;
+        }
+
+        if (end - begin == 1 || instancedProgram == 0) {
+            drawSingles(shaderProgram, begin, end);
+        } else {
+            hasBatches = true;
+        }
+        begin = end;
+    }
+
+    // Restore the lighting and decode state the immediate-mode shapes expect
+    if (drawCallCount > 0) {
+        GLint lightingLoc = glGetUniformLocation(shaderProgram, "useLighting");
+        if (lightingLoc != -1) {
+            glUniform1i(lightingLoc, 0);
+        }
+        VertexCompression::clearDecodeUniforms(shaderProgram);
+    }
+
+    if (!hasBatches) {
+        glBindVertexArray(0);
+        return;
+    }
+
+    // Second pass: shared meshes become one instanced draw each
+    glUseProgram(instancedProgram);
+
+    GLint instancedLightingLoc = glGetUniformLocation(instancedProgram, "useLighting");
+    if (instancedLightingLoc != -1) {
+        glUniform1i(instancedLightingLoc, 1);
+    }
+
+    // Pack per-instance data in sorted order so each batch is a contiguous range
+    instanceData.resize(items.size() * INSTANCE_STRIDE);
+    for (size_t i = 0; i < items.size(); ++i) {
+        float* dst = &instanceData[i * INSTANCE_STRIDE];
+        std::memcpy(dst, glm::value_ptr(items[i].model), 16 * sizeof(float));
+        std::memcpy(dst + 16, glm::value_ptr(items[i].normalMatrix), 9 * sizeof(float));
+        std::memcpy(dst + 25, glm::value_ptr(items[i].color), 3 * sizeof(float));
+    }
+
+    if (instanceVBO == 0) {
+        glGenBuffers(1, &instanceVBO);
+    }
+
+    // Grow the buffer when needed, otherwise orphan and refill it
+    GLsizeiptr instanceBytes = static_cast<GLsizeiptr>(instanceData.size() * sizeof(float));
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (instanceBytes > instanceCapacity) {
+        instanceCapacity = instanceBytes;
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceBytes, instanceData.data());
+
+    for (size_t begin = 0; begin < items.size(); ) {
+        size_t end = begin + 1;
+        while (end < items.size() && sameMesh(items[begin], items[end])) {
+            ++end;
+        }
+
+        if (end - begin > 1) {
+            drawInstanced(instancedProgram, begin, end);
+        }
+        begin = end;
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (instancedLightingLoc != -1) {
+        glUniform1i(instancedLightingLoc, 0);
+    }
+    VertexCompression::clearDecodeUniforms(instancedProgram);
+}
+
+
+// Draw a run of items one by one, skipping redundant VAO and material updates
+void RenderQueue::drawSingles(GLuint shaderProgram, size_t begin, size_t end) {
+
+    // Only switch programs once per flush
+    bool firstDraw = (drawCallCount == 0);
+    if (firstDraw) {
+        glUseProgram(shaderProgram);
+
+        GLint lightingLoc = glGetUniformLocation(shaderProgram, "useLighting");
+        if (lightingLoc != -1) {
+            glUniform1i(lightingLoc, 1);
+        }
+    }
+
+    // One mesh per run, so one set of decode parameters
+    glBindVertexArray(items[begin].VAO);
+    VertexCompression::setDecodeUniforms(shaderProgram, items[begin].positionOffset, items[begin].positionScale);
+
+    for (size_t i = begin; i < end; ++i) {
+        const DrawItem& item = items[i];
+
+        if (firstDraw || item.color != lastColor) {
+            glUniform3fv(colorLoc, 1, glm::value_ptr(item.color));
+            lastColor = item.color;
+            firstDraw = false;
+        }
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(item.model));
+        glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(item.normalMatrix));
+
+        glDrawElements(GL_TRIANGLES, item.indexCount, GL_UNSIGNED_INT, (void*)(item.firstIndex * sizeof(unsigned int)));
+        ++drawCallCount;
+    }
+}
+
+
+// Draw a run of items sharing one mesh with a single instanced call
+void RenderQueue::drawInstanced(GLuint instancedProgram, size_t begin, size_t end) {
+    glBindVertexArray(items[begin].VAO);
+    VertexCompression::setDecodeUniforms(instancedProgram, items[begin].positionOffset, items[begin].positionScale);
+    bindInstanceAttributes(begin);
+
+    glDrawElementsInstanced(GL_TRIANGLES, items[begin].indexCount, GL_UNSIGNED_INT,
+                            (void*)(items[begin].firstIndex * sizeof(unsigned int)), static_cast<GLsizei>(end - begin));
+
+    // Leave the shared VAO as the owning shape configured it
+    unbindInstanceAttributes();
+
+    ++drawCallCount;
+    ++instancedBatchCount;
+}
+
+
+// Point the per-instance attributes at this batch's range of the instance buffer
+void RenderQueue::bindInstanceAttributes(size_t firstInstance) {
+    const GLsizei stride = INSTANCE_STRIDE * sizeof(float);
+    const size_t base = firstInstance * stride;
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+    // Model matrix -> locations 5-8 (one column each)
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + column * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    // Normal matrix -> locations 9-11 (one column each)
+    for (GLuint column = 0; column < 3; ++column) {
+        GLuint location = INSTANCE_NORMAL_MATRIX_LOCATION + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + (16 + column * 3) * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+
+    // Material color -> location 12
+    glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 3, GL_FLOAT, GL_FALSE, stride, (void*)(base + 25 * sizeof(float)));
+    glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+    glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+}
+
+void RenderQueue::unbindInstanceAttributes() {
+    for (GLuint location = INSTANCE_MODEL_LOCATION; location <= INSTANCE_COLOR_LOCATION; ++location) {
+        glDisableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 0);
+    }
+}
+
+
+int RenderQueue::getItemCount() const {
+    return static_cast<int>(items.size());
+}
+
+int RenderQueue::getDrawCallCount() const {
+    return drawCallCount;
+}
+
+int RenderQueue::getInstancedBatchCount() const {
+    return instancedBatchCount;
+}
+
+int RenderQueue::getTriangleCount() const {
+    return triangleCount;
+}
@@ -1,5 +1,6 @@
 #include "Application.h"
 #include "Renderer.h"
+#include "CompactVertex.h"
 
 #include "glad/glad.h"
 #include <GLFW/glfw3.h>
@@ -8,6 +9,8 @@
 #include <glm/gtc/matrix_transform.hpp> // Transformations (translate, rotate, scale)
 #include <glm/gtc/type_ptr.hpp>         // To pass matrices to OpenGL shaders
 
+#include <limits>
+
 
 Renderer::Renderer()
     : translateX(0.0f), translateY(0.0f), translateZ(0.0f),
@@ -15,7 +18,8 @@ Renderer::Renderer()
       cameraTarget(glm::vec3(0.0f, 0.0f, 0.0f)),
       cameraUp(glm::vec3(0.0f, 1.0f, 0.0f)),
       theta(glm::pi<float>() / 2.0f), phi(0.0f), radius(5.0f), // Default distance from origin      
-      selectedIntegrator(IntegratorType::ForwardEuler) {
+      selectedIntegrator(IntegratorType::ForwardEuler),
+      shaderProgram(0), instancedShaderProgram(0), skinnedShaderProgram(0) {
 
     // Set initial camera position
     updateCameraPosition();
@@ -34,6 +38,30 @@ void Renderer::setShaderProgram(GLuint shaderProg) {
 }
 
 
+// Getter for the instanced Shader Program
+GLuint Renderer::getInstancedShaderProgram() const {
+    return instancedShaderProgram;
+}
+
+
+// Setter for the instanced Shader Program
+void Renderer::setInstancedShaderProgram(GLuint shaderProg) {
+    instancedShaderProgram = shaderProg;
+}
+
+
+// Getter for the skinned Shader Program
+GLuint Renderer::getSkinnedShaderProgram() const {
+    return skinnedShaderProgram;
+}
+
+
+// Setter for the skinned Shader Program
+void Renderer::setSkinnedShaderProgram(GLuint shaderProg) {
+    skinnedShaderProgram = shaderProg;
+}
+
+
 void Renderer::updateCameraPosition() {
 
     // Convert spherical coordinates to Cartesian coordinates
@@ -67,70 +95,133 @@ void Renderer::setupLighting(GLuint shaderProgram) {
 
 // Function to draw axis lines
 void Renderer::drawAxis(GLuint shaderProgram) {
+    drawHelper(shaderProgram, resourceCache.getAxis());
+}
+
+
+// Function to draw the ground grid
+void Renderer::drawGrid(GLuint shaderProgram) {
+    drawHelper(shaderProgram, resourceCache.getGrid());
+}
+
+
+// Draw cached helper geometry with an identity transform and no lighting
+void Renderer::drawHelper(GLuint shaderProgram, const GpuResourceCache::HelperMesh& mesh) {
 
     // Use the shader program
     glUseProgram(shaderProgram);
     
-    // Ensure model matrix is identity for the axis
+    // Ensure model matrix is identity for the helper
     glm::mat4 model = glm::mat4(1.0f);
     GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
     glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
-    // Disable lighting for the axis
+    glm::mat3 normalMatrix = glm::mat3(1.0f);
+    GLint normalMatrixLoc = glGetUniformLocation(shaderProgram, "normalMatrix");
+    glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+
+    // Disable lighting for the helper
     GLint lightingLoc = glGetUniformLocation(shaderProgram, "useLighting");
     if (lightingLoc != -1) {
-        glUniform1i(lightingLoc, 0); // Ensure lighting is OFF for the axis
+        glUniform1i(lightingLoc, 0); // Ensure lighting is OFF for the helper
     }
 
-    // Vertex data for axis lines, including positions and colors
-    float axisVertices[] = {
-        // Positions        // Colors
-        // X-axis (Red)
-        -50.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f, // Origin
-         50.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f, // +X
-
-        // Y-axis (Green)
-        0.0f, -50.0f, 0.0f,  0.0f, 1.0f, 0.0f, // Origin
-        0.0f,  50.0f, 0.0f,  0.0f, 1.0f, 0.0f, // +Y
-
-        // Z-axis (Blue)
-        0.0f, 0.0f, -50.0f,  0.0f, 0.0f, 1.0f, // Origin
-        0.0f, 0.0f,  50.0f,  0.0f, 0.0f, 1.0f  // +Z
-    };
-
-    GLuint axisVAO, axisVBO;
-    // Generate and bind a Vertex Array Object (VAO)
-    glGenVertexArrays(1, &axisVAO);
-    glBindVertexArray(axisVAO);
-
-    // Generate and bind a Vertex Buffer Object (VBO)
-    glGenBuffers(1, &axisVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, axisVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(axisVertices), axisVertices, GL_STATIC_DRAW);
-
-    // Configure the position attribute (location 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // Configure the color attribute (location 2)
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // Draw the axis lines
-    glBindVertexArray(axisVAO);
+    // Draw the cached lines; the VAO/VBO are created once by the resource cache
+    glBindVertexArray(mesh.VAO);
     glLineWidth(1.0f); // Choose a float value > 1.0f for thicker lines
-    glDrawArrays(GL_LINES, 0, 6);
+    glDrawArrays(mesh.mode, 0, mesh.vertexCount);
 
     // Re-enable lighting for shapes
     if (lightingLoc != -1) {
         glUniform1i(lightingLoc, 1);
     }
 
-    // Unbind and clean up
     glBindVertexArray(0);
-    glDeleteBuffers(1, &axisVBO);
-    glDeleteVertexArrays(1, &axisVAO);
-    
+}
+
+
+// Runs before SimulationThread::addSystem, so the fields are still ours to read
+void Renderer::trackParticleSystem(ParticleSystem* system) {
+    ParticleControls controls = { 1.0f, false, false, 0, 1.0f };
+    if (PendulumSystem* pendulum = dynamic_cast<PendulumSystem*>(system)) {
+        controls.mass = pendulum->getMass();
+    }
+    if (SimpleCloth* cloth = dynamic_cast<SimpleCloth*>(system)) {
+        controls.movement = cloth->getMovement();
+        controls.wind = cloth->getWind();
+        controls.windIntensity = cloth->getWindIntensity();
+    }
+    particleControls[system] = controls;
+}
+
+void Renderer::forgetParticleSystem(ParticleSystem* system) {
+    particleControls.erase(system);
+}
+
+
+// Immediate draw of a shape that does not batch, optionally in its own profiler zone
+void Renderer::drawShape(Shape& shape) {
+#ifdef ENABLE_PROFILING
+    if (GpuProfiler::isPerShapeTimingEnabled()) {
+        GPU_PROFILE_SCOPE(shape.getShapeType() + " #" + std::to_string(shape.getId()));
+        shape.applyTransform(shaderProgram);
+        shape.draw(shaderProgram);
+        return;
+    }
+#endif
+
+    shape.applyTransform(shaderProgram);
+    shape.draw(shaderProgram);
+}
+
+
+// Shapes without bounds are always drawn
+bool Renderer::isShapeVisible(const Shape& shape) const {
+    if (!shape.hasBounds()) {
+        return true;
+    }
+
+    return frustum.intersectsTransformedBounds(shape.getModelMatrix(),
+                                               shape.getLocalBoundsMin(), shape.getLocalBoundsMax(),
+                                               shape.getBoundingSphereCenter(), shape.getBoundingSphereRadius());
+}
+
+
+// Bounding sphere radius in pixels; the largest float when the camera is inside it
+float Renderer::getProjectedRadius(const Shape& shape, const glm::mat4& projection, int viewportHeight) const {
+    const glm::mat4& model = shape.getModelMatrix();
+    glm::vec3 worldCenter = glm::vec3(model * glm::vec4(shape.getBoundingSphereCenter(), 1.0f));
+    float maxScale = std::max(glm::length(glm::vec3(model[0])),
+                              std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float worldRadius = shape.getBoundingSphereRadius() * maxScale;
+
+    float distance = glm::length(worldCenter - cameraPosition);
+    if (distance <= worldRadius) {
+        return std::numeric_limits<float>::max();
+    }
+    return worldRadius / distance * projection[1][1] * 0.5f * static_cast<float>(viewportHeight);
+}
+
+
+// Overlay window listing per-frame render statistics
+void Renderer::drawRenderStats() {
+    ImGui::SetNextWindowPos(ImVec2(10, 30), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Render Stats", &showRenderStats, ImGuiWindowFlags_AlwaysAutoResize);
+
+    ImGui::Text("Frame time: %.2f ms", 1000.0f / ImGui::GetIO().Framerate);
+    ImGui::Text("Simulation: %.0f steps/s", Application::getSimulation().getStepsPerSecond());
+    ImGui::Text("GL objects created: %d", GpuResourceCache::getObjectsCreatedLastFrame());
+    ImGui::Text("GL objects deleted: %d", GpuResourceCache::getObjectsDeletedLastFrame());
+
+    ImGui::Separator();
+    ImGui::Text("Culled shapes: %d / %d", culledShapeCount, consideredShapeCount);
+    ImGui::Text("Queued shapes: %d", renderQueue.getItemCount());
+    ImGui::Text("Queue draw calls: %d", renderQueue.getDrawCallCount());
+    ImGui::Text("Instanced batches: %d", renderQueue.getInstancedBatchCount());
+    ImGui::Text("Queued triangles: %d", renderQueue.getTriangleCount());
+    ImGui::Text("Shared meshes: %d", MeshRegistry::getLiveMeshCount());
+
+    ImGui::End();
 }
 
 
@@ -253,24 +344,15 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 	    {
 
 	        if (ImGui::MenuItem("Import Shape")) {
-	            FileImporter fileImporter;  // This creates an instance of the FileImporter class
-	            if (fileImporter.importObjFile(shapeManager)) {  // Function to import .obj files
-	                shapeManager.setSelectedShapeByLastAdded();
-		    }
+	            Application::getFileImporter().importObjFile(shapeManager);  // Loads in the background
 	        }
 
 	        if (ImGui::MenuItem("Import Curve")) {
-	            FileImporter fileImporter;  // This creates an instance of the FileImporter class
-	            if (fileImporter.importSwpFile(shapeManager)) {  // Function to import .obj files
-		        shapeManager.setSelectedShapeByLastAdded();
-		    }
+	            Application::getFileImporter().importSwpFile(shapeManager);  // Loads in the background
 	        }
 
 	        if (ImGui::MenuItem("Import Character")) {
-	            FileImporter fileImporter;  // This creates an instance of the FileImporter class
-	            if (fileImporter.importCharacterFile(shapeManager)) {  // Function to import .obj files
-		        shapeManager.setSelectedShapeByLastAdded();
-		    }
+	            Application::getFileImporter().importCharacterFile(shapeManager);  // Loads in the background
 	        }
 
 	        ImGui::EndMenu();
@@ -350,6 +432,20 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
                 showAxis = !showAxis;
             }
 
+            ImGui::MenuItem("Show Grid", nullptr, &showGrid);
+            ImGui::MenuItem("Show Render Stats", nullptr, &showRenderStats);
+            ImGui::MenuItem("Frustum Culling", nullptr, &frustumCulling);
+            ImGui::MenuItem("Level of Detail", nullptr, &levelOfDetail);
+
+            // Applies to meshes uploaded after the change
+            bool compactVertices = VertexCompression::isEnabled();
+            if (ImGui::MenuItem("Compact Vertex Formats", nullptr, &compactVertices)) {
+                VertexCompression::setEnabled(compactVertices);
+            }
+#ifdef ENABLE_PROFILING
+            ImGui::MenuItem("Show GPU Profiler", nullptr, &showProfiler);
+#endif
+
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Animation"))
@@ -368,9 +464,16 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 				// Get all ParticleSystem shapes
 				std::vector<ParticleSystem*> particleSystems = shapeManager.getParticleSystems();
 
-				// Reset each ParticleSystem
+				// Reset each ParticleSystem, on both the render and the simulation thread
 				for (ParticleSystem* ps : particleSystems) {
-					ps->reset();  // Calls the reset function implemented in ParticleSystem
+					Application::getSimulation().resetSystem(ps);
+				}
+
+				// Rewind keyframed characters to the start of their clips
+				for (Shape* shape : shapeManager.getShapes()) {
+					if (ImportCharacter* importChar = dynamic_cast<ImportCharacter*>(shape)) {
+						importChar->resetAnimation();
+					}
 				}
 
 
@@ -426,6 +529,28 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
         }
     }
 
+#ifdef ENABLE_PROFILING
+    // F9 dumps the recent CPU scopes as a Chrome trace, even over a window
+    if (ImGui::IsKeyPressed(ImGuiKey_F9, false)) {
+        CpuProfiler::dumpRecent();
+    }
+#endif
+
+    // Small overlay with per-frame render statistics
+    if (showRenderStats) {
+        drawRenderStats();
+    }
+
+    // Progress and cancel buttons for imports still loading
+    Application::getFileImporter().drawProgress();
+
+#ifdef ENABLE_PROFILING
+    // CPU/GPU zone timings from a few frames ago
+    if (showProfiler) {
+        GpuProfiler::drawPanel(&showProfiler);
+    }
+#endif
+
     // Right-side ImGui panel for shape selection and properties
     ImGui::SetNextWindowPos(ImVec2(io.DisplaySize.x - 280, 20), ImGuiCond_Always);
     ImGui::SetNextWindowSize(ImVec2(280, io.DisplaySize.y - 20), ImGuiCond_Always);
@@ -574,13 +699,30 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 				importCharacter->setDisplayMode(static_cast<ImportCharacter::DisplayMode>(currentMode));  // Cast to DisplayMode
 			}
 
+			// Blend the mesh in the vertex shader instead of rebuilding it on the CPU every frame
+			bool gpuSkinning = ImportCharacter::isGpuSkinningEnabled();
+			if (ImGui::Checkbox("GPU Skinning", &gpuSkinning)) {
+				ImportCharacter::setGpuSkinningEnabled(gpuSkinning);
+			}
+
+			// Copies of this character sharing its buffers, drawn in one instanced call
+			int crowdSize = static_cast<int>(importCharacter->getCrowdSize());
+			float crowdSpacing = importCharacter->getCrowdSpacing();
+			bool crowdChanged = ImGui::SliderInt("Crowd Size", &crowdSize, 1, static_cast<int>(Crowd::MAX_INSTANCES));
+			crowdChanged |= ImGui::DragFloat("Crowd Spacing", &crowdSpacing, 0.01f, 0.1f, 5.0f);
+			if (crowdChanged) {
+				importCharacter->setCrowd(static_cast<size_t>(crowdSize), crowdSpacing);
+			}
+			if (crowdSize > 1 && !gpuSkinning) {
+				ImGui::TextDisabled("Crowds are drawn with GPU skinning only");
+			}
+
             ImGui::Separator();
             ImGui::Text("Joint Rotations (x, y, z)");
 
 			// Get references to vertices and bindVertices
 			std::vector<glm::vec3>& currentVertices = importCharacter->getVertices();  // Direct access to vertices from Shape
 			const std::vector<glm::vec3>& bindVertices = importCharacter->getBindVertices();
-			const std::vector<std::vector<float>>& attachments = importCharacter->getAttachments();
 
 
 
@@ -603,9 +745,8 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 					jointRotation[1] = (jointRotation[1] < 0) ? 360.0f + fmod(jointRotation[1], 360.0f) : fmod(jointRotation[1], 360.0f);
 					jointRotation[2] = (jointRotation[2] < 0) ? 360.0f + fmod(jointRotation[2], 360.0f) : fmod(jointRotation[2], 360.0f);
 
-					// Set joint transform with updated rotations
+					// Set joint transform with updated rotations; the next draw re-poses only its subtree
 					importCharacter->getSkeletalModel().setJointTransform(i, jointRotation[0], jointRotation[1], jointRotation[2]);
-					importCharacter->getSkeletalModel().updateCurrentJointToWorldTransforms();
 
 				}
 			}
@@ -614,13 +755,21 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 
 		// For SimplePendulum only
 
-		if (PendulumSystem* simplePendulum = dynamic_cast<PendulumSystem*>(shapeManager.getSelectedShape())) {
+		PendulumSystem* simplePendulum = dynamic_cast<PendulumSystem*>(shapeManager.getSelectedShape());
+		std::map<const ParticleSystem*, ParticleControls>::iterator controls = particleControls.end();
+		if (simplePendulum) {
+			controls = particleControls.find(simplePendulum);
+		}
+
+		if (controls != particleControls.end()) {
 			ImGui::Text("Pendulum System Properties");
 
 			// Mass adjustment slider
-			float mass = simplePendulum->getMass();
+			float& mass = controls->second.mass;
 			if (ImGui::SliderFloat("Mass", &mass, 0.1f, 10.0f, "%.2f")) {
-				simplePendulum->setMass(mass);
+				// evalF reads the mass, so change it between simulation steps
+				const float newMass = mass;
+				Application::getSimulation().enqueue([simplePendulum, newMass]() { simplePendulum->setMass(newMass); });
 			}
 		}
 
@@ -628,7 +777,9 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 
 		// For SimpleCloth only
 
-		if (SimpleCloth* simpleCloth = dynamic_cast<SimpleCloth*>(shapeManager.getSelectedShape())) {
+		SimpleCloth* simpleCloth = dynamic_cast<SimpleCloth*>(shapeManager.getSelectedShape());
+		if (simpleCloth && controls != particleControls.end()) {
+			ParticleControls& clothControls = controls->second;
 
 			ImGui::Text("Simple Cloth Properties");
 
@@ -657,25 +808,31 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 			}
 
 			// Toggle for movement
-			bool isMovementOn = simpleCloth->getMovement(); // Get current state
+			bool& isMovementOn = clothControls.movement; // Render-side copy of the state
 			if (ImGui::Checkbox("Enable Movement", &isMovementOn)) {
-				if (isMovementOn) {
-					simpleCloth->enableMovement(); // Turn on movement
-				} else {
-					simpleCloth->disableMovement(); // Turn off movement
-				}
+				const bool movementOn = isMovementOn;
+				Application::getSimulation().enqueue([simpleCloth, movementOn]() {
+					if (movementOn) {
+						simpleCloth->enableMovement(); // Turn on movement
+					} else {
+						simpleCloth->disableMovement(); // Turn off movement
+					}
+				});
 			}
 
 
 			// Toggle for wind
-			bool isWindOn = simpleCloth->getWind();
+			bool& isWindOn = clothControls.wind;
 			if (ImGui::Checkbox("Enable Wind", &isWindOn)) {
-				// Update the wind state based on the checkbox's value
-				if (isWindOn) {
-					simpleCloth->enableWind();
-				} else {
-					simpleCloth->disableWind();
-				}
+				// Update the wind state based on the checkbox's value, between simulation steps
+				const bool windOn = isWindOn;
+				Application::getSimulation().enqueue([simpleCloth, windOn]() {
+					if (windOn) {
+						simpleCloth->enableWind();
+					} else {
+						simpleCloth->disableWind();
+					}
+				});
 			}
 
 			// Wind Direction
@@ -687,26 +844,29 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
                             "Right", "Left", "Forward", "Backward",
                             "Forward-Right", "Forward-Left", "Backward-Right", "Backward-Left"
                         };
-                        static int currentDirection = 0; // Default: +X
+                        int& currentDirection = clothControls.windDirection; // Default: +X
 
                         if (ImGui::Combo("Wind Direction", &currentDirection, directions, IM_ARRAYSIZE(directions))) {
+                            glm::vec3 windDirection(1.0f, 0.0f, 0.0f);
                             switch (currentDirection) {
-                                case 0: simpleCloth->setWindDirection(glm::vec3(1.0f, 0.0f, 0.0f)); break;  // +X
-                                case 1: simpleCloth->setWindDirection(glm::vec3(-1.0f, 0.0f, 0.0f)); break; // -X
-                                case 2: simpleCloth->setWindDirection(glm::vec3(0.0f, 0.0f, 1.0f)); break;  // +Z
-                                case 3: simpleCloth->setWindDirection(glm::vec3(0.0f, 0.0f, -1.0f)); break; // -Z
-                                case 4: simpleCloth->setWindDirection(glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f))); break;   // +X +Z
-                                case 5: simpleCloth->setWindDirection(glm::normalize(glm::vec3(-1.0f, 0.0f, 1.0f))); break;  // -X +Z
-                                case 6: simpleCloth->setWindDirection(glm::normalize(glm::vec3(1.0f, 0.0f, -1.0f))); break;  // +X -Z
-                                case 7: simpleCloth->setWindDirection(glm::normalize(glm::vec3(-1.0f, 0.0f, -1.0f))); break; // -X -Z
+                                case 0: windDirection = glm::vec3(1.0f, 0.0f, 0.0f); break;  // +X
+                                case 1: windDirection = glm::vec3(-1.0f, 0.0f, 0.0f); break; // -X
+                                case 2: windDirection = glm::vec3(0.0f, 0.0f, 1.0f); break;  // +Z
+                                case 3: windDirection = glm::vec3(0.0f, 0.0f, -1.0f); break; // -Z
+                                case 4: windDirection = glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)); break;   // +X +Z
+                                case 5: windDirection = glm::normalize(glm::vec3(-1.0f, 0.0f, 1.0f)); break;  // -X +Z
+                                case 6: windDirection = glm::normalize(glm::vec3(1.0f, 0.0f, -1.0f)); break;  // +X -Z
+                                case 7: windDirection = glm::normalize(glm::vec3(-1.0f, 0.0f, -1.0f)); break; // -X -Z
                             }
+                            Application::getSimulation().enqueue([simpleCloth, windDirection]() { simpleCloth->setWindDirection(windDirection); });
                         }
 
 
 			// Wind Intensity
-			float intensity = simpleCloth->getWindIntensity();
+			float& intensity = clothControls.windIntensity;
 			if (ImGui::SliderFloat("Wind Intensity", &intensity, 0.5f, 10.0f, "%.1f")) {
-				simpleCloth->setWindIntensity(intensity);
+				const float newIntensity = intensity;
+				Application::getSimulation().enqueue([simpleCloth, newIntensity]() { simpleCloth->setWindIntensity(newIntensity); });
 			}
 
 			ImGui::PopItemWidth(); // Restore the default width
@@ -791,27 +951,68 @@ void Renderer::renderScene(ShapeManager& shapeManager, TimeStepper* timeStepper)
 
     // Get the shader program and activate it
     GLuint shaderProgram = getShaderProgram();
-    glUseProgram(shaderProgram);
 
-    // Pass matrices to shader
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    // Pass per-frame uniforms to every shader variant
+    GLuint programs[] = { shaderProgram, instancedShaderProgram, skinnedShaderProgram };
+    for (GLuint program : programs) {
+        if (program == 0) {
+            continue;
+        }
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(viewMatrix));
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+
+        // Setup lighting
+        setupLighting(program);
+    }
+    glUseProgram(shaderProgram);
 
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // Setup lighting
-    setupLighting(shaderProgram);
-
-    // Draw axis only if enabled
-    if (showAxis) {
-        drawAxis(getShaderProgram());
+    // Draw axis and ground grid only if enabled
+    {
+        GPU_PROFILE_SCOPE("Helpers");
+        if (showAxis) {
+            drawAxis(getShaderProgram());
+        }
+        if (showGrid) {
+            drawGrid(getShaderProgram());
+        }
     }
 
-    // Draw all shapes
+    // Frustum planes for culling this frame
+    frustum.extractPlanes(projection * viewMatrix);
+    culledShapeCount = 0;
+    consideredShapeCount = static_cast<int>(shapeManager.getShapes().size());
+
+    // Collect batchable shapes into the render queue; the rest draw themselves
+    GPU_PROFILE_SCOPE("Shapes");
+    renderQueue.clear();
     for (Shape* shape : shapeManager.getShapes()) {
-        shape->applyTransform(shaderProgram);
-        shape->draw(shaderProgram);
+
+        // Skip shapes whose bounds are entirely outside the view
+        shape->updateBounds();
+        if (frustumCulling && !isShapeVisible(*shape)) {
+            ++culledShapeCount;
+            continue;
+        }
+
+        // Full detail when LOD selection is off
+        if (shape->hasBounds()) {
+            shape->selectLod(levelOfDetail ? getProjectedRadius(*shape, projection, height)
+                                           : std::numeric_limits<float>::max());
+        }
+
+        if (!shape->submit(renderQueue)) {
+            drawShape(*shape);
+        }
+    }
+
+    // Sorted, instanced submission of the queued shapes
+    {
+        GPU_PROFILE_SCOPE("Render queue flush");
+        renderQueue.flush(shaderProgram, instancedShaderProgram);
     }
 
     // Render ImGui
@@ -4,6 +4,29 @@
 #include <iostream>
 
 GLuint ShaderLoader::loadShaderFromFile(const char* vertexPath, const char* fragmentPath) {
+    return loadShaderFromFile(vertexPath, fragmentPath, "");
+}
+
+std::string ShaderLoader::injectDefines(const std::string& source, const std::string& defines) {
+    if (defines.empty()) {
+        return source;
+    }
+
+    // #version must stay the first statement, so the defines go on the line after it
+    size_t versionPos = source.find("#version");
+    if (versionPos == std::string::npos) {
+        return defines + source;
+    }
+
+    size_t lineEnd = source.find('\n', versionPos);
+    if (lineEnd == std::string::npos) {
+        return source + "\n" + defines;
+    }
+
+    return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+GLuint ShaderLoader::loadShaderFromFile(const char* vertexPath, const char* fragmentPath, const std::string& defines) {
     std::string vertexCode, fragmentCode;
     try {
         std::ifstream vShaderFile(vertexPath);
@@ -13,8 +36,8 @@ GLuint ShaderLoader::loadShaderFromFile(const char* vertexPath, const char* frag
         vShaderStream << vShaderFile.rdbuf();
         fShaderStream << fShaderFile.rdbuf();
 
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();
+        vertexCode = injectDefines(vShaderStream.str(), defines);
+        fragmentCode = injectDefines(fShaderStream.str(), defines);
     } catch (std::ifstream::failure& e) {
         std::cerr << "ERROR: Shader file not successfully read" << std::endl;
         return 0;
@@ -8,11 +8,13 @@ Shape::Shape(float x, float y, float z, float uniformScale, int colorIndex, int
              float scaleX, float scaleY, float scaleZ, bool useUniformScale) 
     : x(x), y(y), z(z), scale(uniformScale), scaleX(scaleX), scaleY(scaleY), scaleZ(scaleZ),
       useUniformScale(useUniformScale), colorIndex(colorIndex), angleX(0.0f), angleY(0.0f), angleZ(0.0f), id(id),
+      localBoundsMin(0.0f), localBoundsMax(0.0f), boundingSphereCenter(0.0f), boundingSphereRadius(0.0f), boundsValid(false),
       defaultX(x), defaultY(y), defaultZ(z),
       defaultScale(uniformScale), defaultScaleX(scaleX), defaultScaleY(scaleY), defaultScaleZ(scaleZ),
       defaultUseUniformScale(useUniformScale),
       defaultRotationX(0.0f), defaultRotationY(0.0f), defaultRotationZ(0.0f),
-      defaultColorIndex(colorIndex) {
+      defaultColorIndex(colorIndex),
+      cachedModelMatrix(1.0f), cachedNormalMatrix(1.0f), transformDirty(true) {
 
     if (colorIndex == 31) {  // If custom color, initialize default custom color
         defaultCustomColor[0] = 1.0f;  // Example default value
@@ -23,7 +25,23 @@ Shape::Shape(float x, float y, float z, float uniformScale, int colorIndex, int
 
 // Apply transformations using the model matrix
 
-glm::mat4 Shape::getModelMatrix() const {
+const glm::mat4& Shape::getModelMatrix() const {
+    if (transformDirty) {
+        updateTransformCache();
+    }
+    return cachedModelMatrix;
+}
+
+// Inverse-transpose of the upper 3x3, used by the shader to transform normals
+const glm::mat3& Shape::getNormalMatrix() const {
+    if (transformDirty) {
+        updateTransformCache();
+    }
+    return cachedNormalMatrix;
+}
+
+// Rebuild the cached matrices from the current position, rotation and scale
+void Shape::updateTransformCache() const {
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(x, y, z));
     model = glm::rotate(model, glm::radians(angleX), glm::vec3(1.0f, 0.0f, 0.0f));
@@ -95,13 +113,17 @@ glm::mat4 Shape::getModelMatrix() const {
 	
 */
 
+    cachedModelMatrix = model;
+
+    // Computed once per transform change instead of once per vertex in the shader
+    cachedNormalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
 
-    return model;
+    transformDirty = false;
 }
 
 // Apply the model matrix to the shader
 void Shape::applyTransform(GLuint shaderProgram) const {
-    glm::mat4 modelMatrix = getModelMatrix();
+    const glm::mat4& modelMatrix = getModelMatrix();
 
     // Pass the model matrix to the shader
     GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
@@ -110,6 +132,12 @@ void Shape::applyTransform(GLuint shaderProgram) const {
     } else {
         std::cerr << "Warning: 'model' uniform not found in shader program." << std::endl;
     }
+
+    // Pass the normal matrix to the shader
+    GLint normalMatrixLoc = glGetUniformLocation(shaderProgram, "normalMatrix");
+    if (normalMatrixLoc != -1) {
+        glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, glm::value_ptr(getNormalMatrix()));
+    }
 }
 
 
@@ -119,6 +147,7 @@ void Shape::setRotation(float ax, float ay, float az) {
     angleX = (ax < 0) ? 360.0f + fmod(ax, 360.0f) : fmod(ax, 360.0f);
     angleY = (ay < 0) ? 360.0f + fmod(ay, 360.0f) : fmod(ay, 360.0f);
     angleZ = (az < 0) ? 360.0f + fmod(az, 360.0f) : fmod(az, 360.0f);
+    transformDirty = true;
 
 }
 
@@ -126,17 +155,20 @@ void Shape::rotate(float dAngleX, float dAngleY, float dAngleZ) {
     angleX += dAngleX;
     angleY += dAngleY;
     angleZ += dAngleZ;
+    transformDirty = true;
 }
 
 void Shape::setPosition(float nx, float ny, float nz) {
     x = nx;
     y = ny;
     z = nz;
+    transformDirty = true;
 }
 
 void Shape::setScale(float s) {
     scale = s;
     useUniformScale = true;
+    transformDirty = true;
 }
 
 void Shape::setScale(float sx, float sy, float sz) {
@@ -148,10 +180,12 @@ void Shape::setScale(float sx, float sy, float sz) {
     scaleY = sy;
     scaleZ = sz;
     useUniformScale = false;
+    transformDirty = true;
 }
 
 void Shape::useUniformScaling(bool flag) {
     useUniformScale = flag;
+    transformDirty = true;
     // std::cout << "Scaling mode set to: " << (useUniformScale ? "Uniform" : "Non-Uniform") << std::endl;
 }
 
@@ -174,7 +208,14 @@ void Shape::setCustomColor(float r, float g, float b) {
 }
 
 void Shape::calculateNormals() {
-    normals.clear(); // Clear existing normals
+    normals = calculateFaceNormals(vertices, faces);
+}
+
+// One normal per face, shared by the primitive mesh builders
+std::vector<glm::vec3> Shape::calculateFaceNormals(const std::vector<glm::vec3>& vertices,
+                                                   const std::vector<std::vector<int>>& faces) {
+    std::vector<glm::vec3> faceNormals;
+    faceNormals.reserve(faces.size());
 
     for (const auto& face : faces) {
         // Calculate two edges of the triangle
@@ -185,8 +226,10 @@ void Shape::calculateNormals() {
         glm::vec3 normal = glm::normalize(glm::cross(v1, v2));
 
         // Store the calculated normal
-        normals.push_back(normal);
+        faceNormals.push_back(normal);
     }
+
+    return faceNormals;
 }
 
 
@@ -199,6 +242,17 @@ float Shape::getAngleZ() const { return angleZ; }
 float Shape::getScale() const { return scale; }
 int Shape::getColorIndex() const { return colorIndex; }
 const float* Shape::getCustomColor() const { return customColor; }
+
+// Color passed to the shader as material.color
+glm::vec3 Shape::getMaterialColor() const {
+    const float* color = (colorIndex == 31) ? customColor : colorPresets[colorIndex].color;
+    return glm::vec3(color[0], color[1], color[2]);
+}
+
+// By default shapes draw themselves; batched shapes override this
+bool Shape::submit(RenderQueue& queue) {
+    return false;
+}
 int Shape::getId() const { return id; }
 std::string Shape::getShapeType() const { return shapeType; }
 
@@ -239,6 +293,39 @@ const std::vector<glm::vec3>& Shape::getNormals() const {
     return normals;
 }
 
+// Set the local-space AABB and derive the bounding sphere from it
+void Shape::setLocalBounds(const glm::vec3& minCorner, const glm::vec3& maxCorner) {
+    localBoundsMin = minCorner;
+    localBoundsMax = maxCorner;
+    boundingSphereCenter = 0.5f * (minCorner + maxCorner);
+    boundingSphereRadius = 0.5f * glm::length(maxCorner - minCorner);
+    boundsValid = true;
+}
+
+// Fit the local-space bounds around a set of points
+void Shape::computeLocalBounds(const std::vector<glm::vec3>& points) {
+    if (points.empty()) {
+        boundsValid = false;
+        return;
+    }
+
+    glm::vec3 minCorner = points[0];
+    glm::vec3 maxCorner = points[0];
+    for (const glm::vec3& point : points) {
+        minCorner = glm::min(minCorner, point);
+        maxCorner = glm::max(maxCorner, point);
+    }
+
+    setLocalBounds(minCorner, maxCorner);
+}
+
+bool Shape::hasBounds() const { return boundsValid; }
+const glm::vec3& Shape::getLocalBoundsMin() const { return localBoundsMin; }
+const glm::vec3& Shape::getLocalBoundsMax() const { return localBoundsMax; }
+const glm::vec3& Shape::getBoundingSphereCenter() const { return boundingSphereCenter; }
+float Shape::getBoundingSphereRadius() const { return boundingSphereRadius; }
+
+
 // Reset to default
 void Shape::resetToDefault() {
     setPosition(defaultX, defaultY, defaultZ);
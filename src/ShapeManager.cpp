@@ -16,11 +16,17 @@ ShapeManager::~ShapeManager() {
 
 void ShapeManager::addShape(Shape* shape) {
     shapes.push_back(shape);
+    if (shapeAdded) {
+        shapeAdded(shape);
+    }
 }
 
 void ShapeManager::deleteShape(Shape* shape) {
     auto it = std::find(shapes.begin(), shapes.end(), shape);
     if (it != shapes.end()) {
+        if (shapeRemoved) {
+            shapeRemoved(*it);   // Let observers release the shape first
+        }
         delete *it;              // Free the memory
         shapes.erase(it);        // Remove shape from the list
         if (selectedShape == shape) {
@@ -87,3 +93,8 @@ std::vector<ParticleSystem*> ShapeManager::getParticleSystems() {
     }
     return particleSystems;
 }
+
+void ShapeManager::setShapeListeners(const std::function<void(Shape*)>& onAdded, const std::function<void(Shape*)>& onRemoved) {
+    shapeAdded = onAdded;
+    shapeRemoved = onRemoved;
+}
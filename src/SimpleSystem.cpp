@@ -1,5 +1,6 @@
 
 #include "SimpleSystem.h"
+#include "CpuProfiler.h"
 #include <iostream>
 
 SimpleSystem::SimpleSystem(float x, float y, float z, float scale, int colorIndex, int id)
@@ -122,6 +123,7 @@ void SimpleSystem::setupParticles() {
 
 
 void SimpleSystem::updateParticles() {
+    PROFILE_SCOPE("SimpleSystem::updateParticles");
     int vertexOffset = 0;
     int sphereVertexCount = static_cast<int>(unitSphereVertices.size());
 
@@ -145,6 +147,7 @@ void SimpleSystem::updateParticles() {
 
 
 std::vector<glm::vec3> SimpleSystem::evalF(const std::vector<glm::vec3>& state) {
+    PROFILE_SCOPE("SimpleSystem::evalF");
 
     std::vector<glm::vec3> f;
 
@@ -0,0 +1,262 @@
+#include "SimulationThread.h"
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+SimulationThread::SimulationThread()
+    : integratorType(IntegratorType::ForwardEuler),
+      running(false), playing(false), stepSize(0.02f),
+      requestedIntegrator(static_cast<int>(IntegratorType::ForwardEuler)), stepsPerSecond(0.0f),
+      simulatedTime(0.0) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+
+void SimulationThread::start() {
+    if (running) {
+        return;
+    }
+
+    running = true;
+    worker = std::thread(&SimulationThread::threadMain, this);
+}
+
+
+void SimulationThread::stop() {
+    if (!running) {
+        return;
+    }
+
+    // Wake the thread so it notices the flag instead of sleeping out its tick
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        running = false;
+    }
+    commandSignal.notify_one();
+    worker.join();
+}
+
+
+void SimulationThread::addSystem(ParticleSystem* system) {
+    if (channels.count(system)) {
+        return;
+    }
+
+    std::shared_ptr<Channel> channel(new Channel());
+    channels[system] = channel;
+
+    // The simulation keeps its own copy of the state from here on
+    const std::vector<glm::vec3> initialState = system->getState();
+    const unsigned generation = channel->generation;
+    enqueue([this, system, initialState, generation, channel]() {
+        SimEntry entry;
+        entry.system = system;
+        entry.state = initialState;
+        entry.generation = generation;
+        entry.channel = channel;
+        entries.push_back(entry);
+    });
+}
+
+
+void SimulationThread::removeSystem(ParticleSystem* system) {
+    if (!channels.erase(system)) {
+        return;
+    }
+
+    std::function<void()> drop = [this, system]() {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [system](const SimEntry& entry) { return entry.system == system; }),
+                      entries.end());
+    };
+
+    if (!running) {
+        drop();
+        return;
+    }
+
+    // The caller deletes the system next, so wait until the simulation has let go of it
+    std::promise<void> dropped;
+    std::future<void> done = dropped.get_future();
+    enqueue([&drop, &dropped]() {
+        drop();
+        dropped.set_value();
+    });
+    done.wait();
+}
+
+
+void SimulationThread::resetSystem(ParticleSystem* system) {
+    std::map<ParticleSystem*, std::shared_ptr<Channel>>::iterator it = channels.find(system);
+    if (it == channels.end()) {
+        return;
+    }
+
+    // Snapshots stepped from the old state are ignored once the generation moves on
+    const unsigned generation = ++it->second->generation;
+    const std::vector<glm::vec3> initialState = system->getInitialState();
+    enqueue([this, system, initialState, generation]() {
+        for (SimEntry& entry : entries) {
+            if (entry.system == system) {
+                entry.state = initialState;
+                entry.generation = generation;
+            }
+        }
+    });
+
+    // Rebuild the render-side buffers right away
+    system->reset();
+}
+
+
+void SimulationThread::enqueue(const std::function<void()>& command) {
+    if (!running) {
+        command(); // No simulation thread to race with
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        commands.push_back(command);
+    }
+    commandSignal.notify_one();
+}
+
+
+void SimulationThread::setPlaying(bool isPlaying) {
+    playing = isPlaying;
+}
+
+
+void SimulationThread::setStepSize(float newStepSize) {
+    stepSize = newStepSize;
+}
+
+
+void SimulationThread::setIntegrator(IntegratorType type) {
+    requestedIntegrator = static_cast<int>(type);
+}
+
+
+void SimulationThread::syncToRenderer() {
+    PROFILE_SCOPE("SimulationThread::syncToRenderer");
+
+    for (std::map<ParticleSystem*, std::shared_ptr<Channel>>::iterator it = channels.begin(); it != channels.end(); ++it) {
+        Channel& channel = *it->second;
+        if (!channel.handoff.update()) {
+            continue; // Nothing new since the last frame
+        }
+
+        const Snapshot& snapshot = channel.handoff.readBuffer();
+        if (snapshot.generation != channel.generation) {
+            continue; // Stepped from a state that has since been reset
+        }
+
+        // GL uploads stay on the render thread
+        it->first->setState(snapshot.state);
+        it->first->updateParticles();
+    }
+}
+
+
+float SimulationThread::getStepsPerSecond() const {
+    return stepsPerSecond;
+}
+
+
+double SimulationThread::getSimulatedTime() const {
+    return simulatedTime;
+}
+
+
+void SimulationThread::threadMain() {
+#ifdef ENABLE_PROFILING
+    CpuProfiler::setThreadName("Simulation");
+#endif
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / STEP_RATE));
+
+    Clock::time_point nextTick = Clock::now();
+    Clock::time_point windowStart = nextTick;
+    int stepsInWindow = 0;
+
+    while (running) {
+        runCommands();
+
+        if (playing) {
+            step();
+            ++stepsInWindow;
+        }
+
+        // Measured rate, refreshed once a second
+        Clock::time_point now = Clock::now();
+        const double windowSeconds = std::chrono::duration<double>(now - windowStart).count();
+        if (windowSeconds >= 1.0) {
+            stepsPerSecond = static_cast<float>(stepsInWindow / windowSeconds);
+            stepsInWindow = 0;
+            windowStart = now;
+        }
+
+        // Fixed rate; if a step overran, start the next one immediately rather than catching up
+        nextTick += period;
+        if (nextTick < now) {
+            nextTick = now;
+        }
+
+        // Sleep until the next tick, running commands as they arrive
+        while (running) {
+            std::unique_lock<std::mutex> lock(commandMutex);
+            if (!commandSignal.wait_until(lock, nextTick, [this]() { return !running || !commands.empty(); })) {
+                break;
+            }
+            lock.unlock();
+            runCommands();
+        }
+    }
+
+    // Anything still queued (e.g. a blocking removal) must not be left waiting
+    runCommands();
+}
+
+
+void SimulationThread::runCommands() {
+    std::deque<std::function<void()>> pending;
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pending.swap(commands);
+    }
+
+    for (std::function<void()>& command : pending) {
+        command();
+    }
+}
+
+
+void SimulationThread::step() {
+    PROFILE_SCOPE("SimulationThread::step");
+
+    // Integrator changes are picked up between steps
+    const IntegratorType requested = static_cast<IntegratorType>(requestedIntegrator.load());
+    if (!integrator || requested != integratorType) {
+        integrator.reset(TimeStepper::createIntegrator(requested));
+        integratorType = requested;
+    }
+
+    const float h = stepSize;
+    for (SimEntry& entry : entries) {
+        entry.state = integrator->integrate(entry.system, entry.state, h);
+
+        // Hand the new state to the render thread
+        Snapshot& snapshot = entry.channel->handoff.writeBuffer();
+        snapshot.state = entry.state;
+        snapshot.generation = entry.generation;
+        entry.channel->handoff.publish();
+    }
+
+    simulatedTime = simulatedTime + h;
+}
@@ -1,23 +1,23 @@
 #include "SkeletalModel.h"
+#include <algorithm>
 #include <iostream>
-#include <functional>
+#include <map>
 
-SkeletalModel::SkeletalModel() {}
+SkeletalModel::SkeletalModel() : m_rootJoint(nullptr), m_compiled(false) {}
 
 // Getters and setters for root joint
 Joint* SkeletalModel::getRootJoint() const { return m_rootJoint; }
-void SkeletalModel::setRootJoint(Joint* rootJoint) { m_rootJoint = rootJoint; }
+void SkeletalModel::setRootJoint(Joint* rootJoint) { m_rootJoint = rootJoint; m_compiled = false; }
 
 // Getters and setters for all joints
 const std::vector<Joint*>& SkeletalModel::getJoints() const { return m_joints; }
-void SkeletalModel::setJoints(const std::vector<Joint*>& joints) { m_joints = joints; }
+void SkeletalModel::setJoints(const std::vector<Joint*>& joints) { m_joints = joints; m_compiled = false; }
+size_t SkeletalModel::getJointCount() const { return m_joints.size(); }
 
 // Getter for joint centers and bone pairs
 const std::vector<glm::vec3>& SkeletalModel::getJointCenters() const { return jointCenters; }
 const std::vector<std::pair<glm::vec3, glm::vec3>> SkeletalModel::getBonePairs() const { return bonePairs; }
 
-MatrixStack& SkeletalModel::getMatrixStack() { return m_matrixStack; }
-
 void SkeletalModel::addJointChild(int parentIndex, Joint* child) {
     if (parentIndex < 0 || parentIndex >= static_cast<int>(m_joints.size())) {
         std::cerr << "Error: Invalid parent index provided." << std::endl;
@@ -27,6 +27,7 @@ void SkeletalModel::addJointChild(int parentIndex, Joint* child) {
     Joint* parent = m_joints[parentIndex];
     parent->addChild(child);
     m_joints.push_back(child);
+    m_compiled = false;
 }
 
 void SkeletalModel::setJointTransform(int jointIndex, float rX, float rY, float rZ) {
@@ -63,31 +64,124 @@ void SkeletalModel::setJointTransform(int jointIndex, float rX, float rY, float
     glm::mat4 localTransform = glm::translate(glm::mat4(1.0f), translation);
     localTransform *= rotationMat;
 
-    joint->setTransform(localTransform);
+    setLocalTransform(jointIndex, localTransform);
 }
 
+// Pose a joint from a clip sample; the slider angles are left as they were
+void SkeletalModel::setJointRotation(int jointIndex, const glm::quat& rotation) {
+    if (jointIndex < 0 || jointIndex >= static_cast<int>(m_joints.size())) {
+        std::cerr << "Error: Invalid joint index!" << std::endl;
+        return;
+    }
 
+    glm::vec3 translation = glm::vec3(m_joints[jointIndex]->getTransform()[3]);
+    setLocalTransform(jointIndex, glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation));
+}
 
+void SkeletalModel::setLocalTransform(int jointIndex, const glm::mat4& localTransform) {
+    m_joints[jointIndex]->setTransform(localTransform);
+
+    // Only a transform that actually changed dirties the joint's subtree
+    if (m_compiled) {
+        int slot = m_jointSlots[jointIndex];
+        if (m_localTransforms[slot] != localTransform) {
+            m_localTransforms[slot] = localTransform;
+            m_dirty[slot] = 1;
+        }
+    }
+}
 
-void SkeletalModel::bindWorldToJointTransformRecursive(Joint* joint, MatrixStack& myStack) {
 
-    // 4.4.1.1. Recursive function for computeBindWorldToJointTransforms()
-    //
-    //
-    // Push the full local bind transform
-    myStack.push(joint->getTransform());
 
-    // Compute and store the inverse world-to-joint transform in bind pose
-    glm::mat4 jointToWorld = myStack.top();
-    glm::mat4 worldToJoint = glm::inverse(jointToWorld);
-    joint->setBindWorldToJointTransform(worldToJoint);
 
-    for (Joint* child : joint->getChildren()) {
-        bindWorldToJointTransformRecursive(child, myStack);
+// Flatten the Joint tree into parent-first arrays. A depth-first preorder
+// keeps each subtree contiguous; joints the root cannot reach become extra roots.
+void SkeletalModel::compile() {
+    const size_t jointCount = m_joints.size();
+    m_jointSlots.assign(jointCount, -1);
+    m_slotJoints.clear();
+    m_parentSlots.clear();
+    m_localTransforms.clear();
+    m_slotJoints.reserve(jointCount);
+    m_parentSlots.reserve(jointCount);
+    m_localTransforms.reserve(jointCount);
+
+    std::map<const Joint*, int> jointIndices;
+    for (size_t i = 0; i < jointCount; ++i) {
+        jointIndices[m_joints[i]] = static_cast<int>(i);
+    }
+
+    // (joint index, parent slot) pairs still to be placed
+    std::vector<std::pair<int, int>> pending;
+    std::map<const Joint*, int>::const_iterator root = jointIndices.find(m_rootJoint);
+
+    // The root's tree first, then each joint still unplaced starts a tree of its own
+    for (size_t i = 0; i <= jointCount; ++i) {
+        int treeRoot = (i == 0) ? (root != jointIndices.end() ? root->second : -1)
+                                : static_cast<int>(i - 1);
+        if (treeRoot < 0 || m_jointSlots[treeRoot] != -1) continue;
+
+        pending.push_back(std::make_pair(treeRoot, -1));
+        while (!pending.empty()) {
+            int jointIndex = pending.back().first;
+            int parentSlot = pending.back().second;
+            pending.pop_back();
+            if (m_jointSlots[jointIndex] != -1) continue;
+
+            int slot = static_cast<int>(m_slotJoints.size());
+            m_jointSlots[jointIndex] = slot;
+            m_slotJoints.push_back(jointIndex);
+            m_parentSlots.push_back(parentSlot);
+            m_localTransforms.push_back(m_joints[jointIndex]->getTransform());
+
+            // Reversed so the first child is placed first
+            const std::vector<Joint*>& children = m_joints[jointIndex]->getChildren();
+            for (size_t c = children.size(); c-- > 0;) {
+                std::map<const Joint*, int>::const_iterator child = jointIndices.find(children[c]);
+                if (child != jointIndices.end()) {
+                    pending.push_back(std::make_pair(child->second, slot));
+                }
+            }
+        }
     }
 
-    myStack.pop();
+    // Children follow their parents, so walking backwards folds each subtree into its parent's
+    m_subtreeEnds.resize(m_slotJoints.size());
+    for (size_t slot = 0; slot < m_subtreeEnds.size(); ++slot) {
+        m_subtreeEnds[slot] = static_cast<int>(slot) + 1;
+    }
+    for (size_t slot = m_subtreeEnds.size(); slot-- > 0;) {
+        int parentSlot = m_parentSlots[slot];
+        if (parentSlot >= 0) {
+            m_subtreeEnds[parentSlot] = std::max(m_subtreeEnds[parentSlot], m_subtreeEnds[slot]);
+        }
+    }
 
+    m_dirty.assign(jointCount, 1);
+    m_jointToWorld.assign(jointCount, glm::mat4(1.0f));
+    m_bindWorldToJoint.resize(jointCount, glm::mat4(1.0f));
+    m_compiled = true;
+}
+
+// Forward kinematics over the dirty subtrees: parents come first, so each
+// joint's parent is already done, and a dirty slot extends the recomputed
+// range to the end of its subtree
+void SkeletalModel::evaluateJointToWorld() {
+    m_updatedJoints.clear();
+
+    int dirtyEnd = 0;
+    for (size_t slot = 0; slot < m_localTransforms.size(); ++slot) {
+        if (m_dirty[slot]) {
+            dirtyEnd = std::max(dirtyEnd, m_subtreeEnds[slot]);
+            m_dirty[slot] = 0;
+        }
+        if (static_cast<int>(slot) >= dirtyEnd) continue;
+
+        int parentSlot = m_parentSlots[slot];
+        m_jointToWorld[slot] = (parentSlot < 0) ? m_localTransforms[slot]
+                                                : m_jointToWorld[parentSlot] * m_localTransforms[slot];
+        m_updatedJoints.push_back(m_slotJoints[slot]);
+    }
 }
 
 void SkeletalModel::computeBindWorldToJointTransforms() {
@@ -97,41 +191,18 @@ void SkeletalModel::computeBindWorldToJointTransforms() {
     //
     // Note that this needs to be computed only once since there is only
     // a single bind pose.
-    //
-    // This method should update each joint's bindWorldToJointTransform.
-    // You will need to add a recursive helper function to traverse the joint hierarchy.
 
     if (!m_rootJoint) {
         std::cerr << "Error: Root joint not set!" << std::endl;
         return;
     }
 
-    m_matrixStack.clear();
-    m_matrixStack.push(glm::mat4(1.0f));
-
-    bindWorldToJointTransformRecursive(m_rootJoint, m_matrixStack);
-
+    compile();
+    evaluateJointToWorld();
 
-}
-
-void SkeletalModel::currentJointToWorldTransformsRecursive(Joint* joint, MatrixStack& myStack) {
-
-    // 4.4.1.2. Recursive function for updateCurrentJointToWorldTransforms()
-    //
-    //
-     // Push the current joint’s local transform (setJointTransform must have set this)
-     myStack.push(joint->getTransform());
-
-    glm::mat4 jointToWorld = myStack.top();
-    joint->setCurrentJointToWorldTransform(jointToWorld);
-
-    for (Joint* child : joint->getChildren()) {
-        currentJointToWorldTransformsRecursive(child, myStack);
+    for (size_t slot = 0; slot < m_jointToWorld.size(); ++slot) {
+        m_bindWorldToJoint[m_slotJoints[slot]] = glm::inverse(m_jointToWorld[slot]);
     }
-
-    myStack.pop();
-    
-
 }
 
 void SkeletalModel::updateCurrentJointToWorldTransforms() {
@@ -141,20 +212,50 @@ void SkeletalModel::updateCurrentJointToWorldTransforms() {
     //
     // The current pose is defined by the rotations you've applied to the
     // joints and hence needs to be *updated* every time the joint angles change.
-    //
-    // This method should update each joint's bindWorldToJointTransform.
-    // You will need to add a recursive helper function to traverse the joint hierarchy.
-	
 
     if (!m_rootJoint) {
         std::cerr << "Error: Root joint not set!" << std::endl;
         return;
     }
 
-    m_matrixStack.clear();
-    currentJointToWorldTransformsRecursive(m_rootJoint, m_matrixStack);
+    if (!m_compiled) {
+        compile();
+    }
+    evaluateJointToWorld();
+}
+
+const glm::mat4& SkeletalModel::getBindWorldToJointTransform(int jointIndex) const {
+    static const glm::mat4 identity(1.0f);
+    if (!m_compiled || jointIndex < 0 || jointIndex >= static_cast<int>(m_jointSlots.size())) {
+        return identity;
+    }
+    return m_bindWorldToJoint[jointIndex];
+}
 
+const glm::mat4& SkeletalModel::getCurrentJointToWorldTransform(int jointIndex) const {
+    static const glm::mat4 identity(1.0f);
+    if (!m_compiled || jointIndex < 0 || jointIndex >= static_cast<int>(m_jointSlots.size())) {
+        return identity;
+    }
+    return m_jointToWorld[m_jointSlots[jointIndex]];
+}
 
+int SkeletalModel::getParentIndex(int jointIndex) const {
+    if (!m_compiled || jointIndex < 0 || jointIndex >= static_cast<int>(m_jointSlots.size())) {
+        return -1;
+    }
+    int parentSlot = m_parentSlots[m_jointSlots[jointIndex]];
+    return parentSlot < 0 ? -1 : m_slotJoints[parentSlot];
 }
 
+const std::vector<int>& SkeletalModel::getUpdatedJoints() const {
+    return m_updatedJoints;
+}
 
+const std::vector<int>& SkeletalModel::getSlotJoints() const {
+    return m_slotJoints;
+}
+
+const std::vector<int>& SkeletalModel::getParentSlots() const {
+    return m_parentSlots;
+}
@@ -0,0 +1,326 @@
+#include "Skinning.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SKINNING_SSE 1
+#endif
+
+const int SkinInfluences::COUNT;
+const size_t Skinning::SIMD_WIDTH;
+
+namespace {
+
+// Vertices per job; big enough to amortize scheduling, small enough to balance
+const size_t SKINNING_GRAIN = 2048;
+
+const size_t PALETTE_ROW_FLOATS = 12;
+
+// Skin the SIMD_WIDTH vertices starting at `i` (a block boundary) into x, y and z
+inline void skinBlock(const SkinningBindData& bind, const float* paletteRows, size_t i, float* x, float* y, float* z) {
+    const size_t stride = bind.paddedCount;
+#ifdef SKINNING_SSE
+
+    // Blend each lane's weighted palette rows into one affine matrix
+    __m128 blended[3][Skinning::SIMD_WIDTH];
+    for (size_t lane = 0; lane < Skinning::SIMD_WIDTH; ++lane) {
+        __m128 row0 = _mm_setzero_ps();
+        __m128 row1 = _mm_setzero_ps();
+        __m128 row2 = _mm_setzero_ps();
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            const float* m = paletteRows + bind.joints[k * stride + i + lane] * PALETTE_ROW_FLOATS;
+            const __m128 w = _mm_set1_ps(bind.weights[k * stride + i + lane]);
+            row0 = _mm_add_ps(row0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+            row1 = _mm_add_ps(row1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+            row2 = _mm_add_ps(row2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+        }
+        blended[0][lane] = row0;
+        blended[1][lane] = row1;
+        blended[2][lane] = row2;
+    }
+
+    // Transpose each row so a register holds one matrix entry for all
+    // four vertices, then transform the four bind positions at once
+    const __m128 bindX = _mm_loadu_ps(&bind.x[i]);
+    const __m128 bindY = _mm_loadu_ps(&bind.y[i]);
+    const __m128 bindZ = _mm_loadu_ps(&bind.z[i]);
+    float* outputs[3] = { x, y, z };
+    for (int r = 0; r < 3; ++r) {
+        __m128 c0 = blended[r][0];
+        __m128 c1 = blended[r][1];
+        __m128 c2 = blended[r][2];
+        __m128 c3 = blended[r][3];
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+        _mm_storeu_ps(outputs[r], _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, bindX), _mm_mul_ps(c1, bindY)),
+                                             _mm_add_ps(_mm_mul_ps(c2, bindZ), c3)));
+    }
+#else
+    for (size_t lane = 0; lane < Skinning::SIMD_WIDTH; ++lane) {
+        const size_t v = i + lane;
+        x[lane] = y[lane] = z[lane] = 0.0f;
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            const float* m = paletteRows + bind.joints[k * stride + v] * PALETTE_ROW_FLOATS;
+            const float w = bind.weights[k * stride + v];
+            x[lane] += w * (m[0] * bind.x[v] + m[1] * bind.y[v] + m[2] * bind.z[v] + m[3]);
+            y[lane] += w * (m[4] * bind.x[v] + m[5] * bind.y[v] + m[6] * bind.z[v] + m[7]);
+            z[lane] += w * (m[8] * bind.x[v] + m[9] * bind.y[v] + m[10] * bind.z[v] + m[11]);
+        }
+    }
+#endif
+}
+
+}
+
+
+SkinInfluences Skinning::compressAttachment(const std::vector<float>& weights) {
+    SkinInfluences result = {};
+
+    // Insertion into a short list sorted by weight, largest first
+    float strongest[SkinInfluences::COUNT] = {};
+    const size_t jointLimit = std::min<size_t>(weights.size(), 256);
+    for (size_t j = 0; j < jointLimit; ++j) {
+        float weight = weights[j];
+        if (weight <= strongest[SkinInfluences::COUNT - 1]) continue;
+
+        int slot = SkinInfluences::COUNT - 1;
+        while (slot > 0 && strongest[slot - 1] < weight) {
+            strongest[slot] = strongest[slot - 1];
+            result.joints[slot] = result.joints[slot - 1];
+            --slot;
+        }
+        strongest[slot] = weight;
+        result.joints[slot] = static_cast<uint8_t>(j);
+    }
+
+    float total = 0.0f;
+    for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+        total += strongest[k];
+    }
+    if (total <= 0.0f) {
+        return result;
+    }
+
+    // Quantize and hand the rounding remainder to the strongest slot so the weights sum to 255
+    int quantizedTotal = 0;
+    for (int k = 1; k < SkinInfluences::COUNT; ++k) {
+        result.weights[k] = static_cast<uint8_t>(strongest[k] / total * 255.0f + 0.5f);
+        quantizedTotal += result.weights[k];
+    }
+    result.weights[0] = static_cast<uint8_t>(255 - quantizedTotal);
+    return result;
+}
+
+
+void Skinning::prepare(const std::vector<glm::vec3>& bindVertices, const std::vector<SkinInfluences>& influences,
+                       size_t jointCount, SkinningBindData& out) {
+    const size_t vertexCount = std::min(bindVertices.size(), influences.size());
+    const size_t paddedCount = (vertexCount + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+    out.vertexCount = vertexCount;
+    out.paddedCount = paddedCount;
+    out.x.assign(paddedCount, 0.0f);
+    out.y.assign(paddedCount, 0.0f);
+    out.z.assign(paddedCount, 0.0f);
+    out.joints.assign(SkinInfluences::COUNT * paddedCount, 0);
+    out.weights.assign(SkinInfluences::COUNT * paddedCount, 0.0f);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        out.x[i] = bindVertices[i].x;
+        out.y[i] = bindVertices[i].y;
+        out.z[i] = bindVertices[i].z;
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            const size_t joint = influences[i].joints[k];
+            if (joint >= jointCount) continue;
+            out.joints[k * paddedCount + i] = static_cast<uint8_t>(joint);
+            out.weights[k * paddedCount + i] = influences[i].weights[k] / 255.0f;
+        }
+    }
+
+    // Joint -> block lists in two passes (count, then fill); blocks arrive in
+    // order, so comparing with the joint's last block removes duplicates
+    const size_t blockCount = paddedCount / SIMD_WIDTH;
+    std::vector<uint32_t> lastBlock(jointCount, UINT32_MAX);
+    out.jointBlockOffsets.assign(jointCount + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::fill(lastBlock.begin(), lastBlock.end(), UINT32_MAX);
+        std::vector<uint32_t> cursor(out.jointBlockOffsets.begin(), out.jointBlockOffsets.end() - 1);
+        if (pass == 1) {
+            out.jointBlocks.resize(out.jointBlockOffsets[jointCount]);
+        }
+
+        for (size_t block = 0; block < blockCount; ++block) {
+            for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+                for (size_t lane = 0; lane < SIMD_WIDTH; ++lane) {
+                    const size_t vertex = block * SIMD_WIDTH + lane;
+                    if (out.weights[k * paddedCount + vertex] == 0.0f) continue;
+
+                    const size_t joint = out.joints[k * paddedCount + vertex];
+                    if (lastBlock[joint] == block) continue;
+                    lastBlock[joint] = static_cast<uint32_t>(block);
+
+                    if (pass == 0) {
+                        ++out.jointBlockOffsets[joint + 1];
+                    } else {
+                        out.jointBlocks[cursor[joint]++] = static_cast<uint32_t>(block);
+                    }
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (size_t j = 0; j < jointCount; ++j) {
+                out.jointBlockOffsets[j + 1] += out.jointBlockOffsets[j];
+            }
+        }
+    }
+}
+
+
+void Skinning::mapCorners(const std::vector<std::vector<int>>& faces, SkinningBindData& bind) {
+    const size_t vertexCount = bind.vertexCount;
+
+    // Count each vertex's corners; the prefix sums are the start of its slots
+    bind.cornerOffsets.assign(vertexCount + 1, 0);
+    for (size_t f = 0; f < faces.size(); ++f) {
+        for (size_t c = 0; c < 3 && c < faces[f].size(); ++c) {
+            const int vertex = faces[f][c];
+            if (vertex >= 0 && static_cast<size_t>(vertex) < vertexCount) {
+                ++bind.cornerOffsets[vertex + 1];
+            }
+        }
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        bind.cornerOffsets[v + 1] += bind.cornerOffsets[v];
+    }
+
+    bind.corners.resize(bind.cornerOffsets[vertexCount]);
+    std::vector<uint32_t> cursor(bind.cornerOffsets.begin(), bind.cornerOffsets.end() - 1);
+    for (size_t f = 0; f < faces.size(); ++f) {
+        for (size_t c = 0; c < 3 && c < faces[f].size(); ++c) {
+            const int vertex = faces[f][c];
+            if (vertex >= 0 && static_cast<size_t>(vertex) < vertexCount) {
+                bind.corners[cursor[vertex]++] = static_cast<uint32_t>(f * 3 + c);
+            }
+        }
+    }
+}
+
+
+void Skinning::packPalette(const std::vector<glm::mat4>& palette, std::vector<float>& rows) {
+    rows.resize(palette.size() * PALETTE_ROW_FLOATS);
+    for (size_t j = 0; j < palette.size(); ++j) {
+        float* row = &rows[j * PALETTE_ROW_FLOATS];
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                row[r * 4 + c] = palette[j][c][r]; // glm is column-major
+            }
+        }
+    }
+}
+
+
+void Skinning::skinRangeScalar(const SkinningBindData& bind, const float* paletteRows, size_t first, size_t last,
+                               float* outX, float* outY, float* outZ) {
+    const size_t stride = bind.paddedCount;
+    for (size_t i = first; i < last; ++i) {
+        const float x = bind.x[i], y = bind.y[i], z = bind.z[i];
+        float skinnedX = 0.0f, skinnedY = 0.0f, skinnedZ = 0.0f;
+
+        for (int k = 0; k < SkinInfluences::COUNT; ++k) {
+            const float* m = paletteRows + bind.joints[k * stride + i] * PALETTE_ROW_FLOATS;
+            const float w = bind.weights[k * stride + i];
+            skinnedX += w * (m[0] * x + m[1] * y + m[2] * z + m[3]);
+            skinnedY += w * (m[4] * x + m[5] * y + m[6] * z + m[7]);
+            skinnedZ += w * (m[8] * x + m[9] * y + m[10] * z + m[11]);
+        }
+
+        outX[i] = skinnedX;
+        outY[i] = skinnedY;
+        outZ[i] = skinnedZ;
+    }
+}
+
+
+void Skinning::skinRange(const SkinningBindData& bind, const float* paletteRows, size_t first, size_t last,
+                         float* outX, float* outY, float* outZ) {
+#ifdef SKINNING_SSE
+    for (size_t i = first; i < last; i += SIMD_WIDTH) {
+        skinBlock(bind, paletteRows, i, outX + i, outY + i, outZ + i);
+    }
+#else
+    skinRangeScalar(bind, paletteRows, first, last, outX, outY, outZ);
+#endif
+}
+
+
+void Skinning::skin(const SkinningBindData& bind, const float* paletteRows,
+                    float* outX, float* outY, float* outZ) {
+    PROFILE_SCOPE("Skinning::skin");
+
+    // Chunks are whole SIMD blocks
+    const size_t blockCount = bind.paddedCount / SIMD_WIDTH;
+    JobSystem::parallelFor(0, blockCount, SKINNING_GRAIN / SIMD_WIDTH,
+                           [&bind, paletteRows, outX, outY, outZ](size_t firstBlock, size_t lastBlock) {
+        skinRange(bind, paletteRows, firstBlock * SIMD_WIDTH, lastBlock * SIMD_WIDTH, outX, outY, outZ);
+    });
+}
+
+
+void Skinning::findAffectedBlocks(const SkinningBindData& bind, const std::vector<int>& joints,
+                                  std::vector<uint32_t>& blocks) {
+    blocks.clear();
+    std::vector<uint8_t> affected(bind.paddedCount / SIMD_WIDTH, 0);
+    const size_t jointCount = bind.jointBlockOffsets.empty() ? 0 : bind.jointBlockOffsets.size() - 1;
+
+    for (size_t i = 0; i < joints.size(); ++i) {
+        if (joints[i] < 0 || static_cast<size_t>(joints[i]) >= jointCount) continue;
+        for (uint32_t b = bind.jointBlockOffsets[joints[i]]; b < bind.jointBlockOffsets[joints[i] + 1]; ++b) {
+            affected[bind.jointBlocks[b]] = 1;
+        }
+    }
+
+    for (size_t block = 0; block < affected.size(); ++block) {
+        if (affected[block]) {
+            blocks.push_back(static_cast<uint32_t>(block));
+        }
+    }
+}
+
+
+void Skinning::skinBlocks(const SkinningBindData& bind, const float* paletteRows, const std::vector<uint32_t>& blocks,
+                          float* cornerSlots) {
+    PROFILE_SCOPE("Skinning::skinBlocks");
+
+    // A vertex's slots belong to it alone, so chunks write disjoint ranges
+    JobSystem::parallelFor(0, blocks.size(), SKINNING_GRAIN / SIMD_WIDTH,
+                           [&bind, &blocks, paletteRows, cornerSlots](size_t first, size_t last) {
+        float x[SIMD_WIDTH], y[SIMD_WIDTH], z[SIMD_WIDTH];
+        for (size_t b = first; b < last; ++b) {
+            const size_t firstVertex = blocks[b] * SIMD_WIDTH;
+            skinBlock(bind, paletteRows, firstVertex, x, y, z);
+
+            const size_t laneCount = std::min(SIMD_WIDTH, bind.vertexCount - firstVertex);
+            for (size_t lane = 0; lane < laneCount; ++lane) {
+                const size_t vertex = firstVertex + lane;
+                float* slot = cornerSlots + bind.cornerOffsets[vertex] * 3;
+                for (uint32_t s = bind.cornerOffsets[vertex]; s < bind.cornerOffsets[vertex + 1]; ++s, slot += 3) {
+                    slot[0] = x[lane];
+                    slot[1] = y[lane];
+                    slot[2] = z[lane];
+                }
+            }
+        }
+    });
+}
+
+
+bool Skinning::hasSimd() {
+#ifdef SKINNING_SSE
+    return true;
+#else
+    return false;
+#endif
+}
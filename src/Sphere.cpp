@@ -2,26 +2,27 @@
 
 #include <vector>
 #include <cmath>
+#include <algorithm>
 
 Sphere::Sphere(float x, float y, float z, float scale, int colorIndex, int id)
-    : Shape(x, y, z, scale, colorIndex, id), VAO(0), VBO(0), EBO(0) {
+    : Shape(x, y, z, scale, colorIndex, id) {
     shapeType = "Sphere";  // Set the type as "Sphere"
     
-    setupSphere(); // Initialize OpenGL objects for the sphere
+    mesh = MeshRegistry::acquire("Sphere", 0, &Sphere::buildMesh); // Shared geometry, uploaded once per primitive type
+    setLocalBounds(mesh->boundsMin, mesh->boundsMax);
 }
 
-Sphere::~Sphere() {
-    // Cleanup OpenGL resources
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-}
-
-void Sphere::setupSphere() {
-    const unsigned int latitudeSegments = 20; // Number of latitude lines
-    const unsigned int longitudeSegments = 20; // Number of longitude lines
+MeshData Sphere::buildMesh(int lod) {
+    // Each LOD step halves the tessellation of the 20x20 base sphere
+    const unsigned int segments = std::max(4u, 20u >> lod);
+    const unsigned int latitudeSegments = segments; // Number of latitude lines
+    const unsigned int longitudeSegments = segments; // Number of longitude lines
     const float radius = 0.5f;
 
+    std::vector<glm::vec3> vertices;
+    std::vector<glm::vec3> normals;
+    std::vector<std::vector<int>> faces;
+
     // Generate sphere vertices, normals, and texture coordinates
     for (unsigned int y = 0; y <= latitudeSegments; ++y) {
         for (unsigned int x = 0; x <= longitudeSegments; ++x) {
@@ -32,7 +33,7 @@ void Sphere::setupSphere() {
             float yPos = radius * std::cos(ySegment * M_PI);
             float zPos = radius * std::sin(xSegment * 2.0f * M_PI) * std::sin(ySegment * M_PI);
 
-            // Store vertices and normals in the inherited attributes
+            // Store vertices and normals
             glm::vec3 position = glm::vec3(xPos, yPos, zPos);
             vertices.push_back(position);
             normals.push_back(glm::normalize(position));
@@ -45,69 +46,30 @@ void Sphere::setupSphere() {
     // Generate sphere faces (indices)
     for (unsigned int y = 0; y < latitudeSegments; ++y) {
         for (unsigned int x = 0; x < longitudeSegments; ++x) {
-            unsigned int first = (y * (longitudeSegments + 1)) + x;
-            unsigned int second = first + longitudeSegments + 1;
+            int first = static_cast<int>((y * (longitudeSegments + 1)) + x);
+            int second = first + static_cast<int>(longitudeSegments) + 1;
 
             faces.push_back({first, second, first + 1});
             faces.push_back({second, second + 1, first + 1});
         }
     }
 
-    // Prepare OpenGL buffers using the populated attributes
-    std::vector<float> vertexData;
-    std::vector<unsigned int> indexData;
-
-    glm::vec3 color = (colorIndex == 31) 
-        ? glm::vec3(
-            customColor[0], 
-            customColor[1], 
-            customColor[2]
-        )
-        : glm::vec3(
-            colorPresets[colorIndex].color[0], 
-            colorPresets[colorIndex].color[1], 
-            colorPresets[colorIndex].color[2]
-         );
+    // Prepare the buffers using the populated attributes
+    MeshData data;
+    data.vertexData.reserve(faces.size() * 3 * 6);
+    data.indexData.reserve(faces.size() * 3);
 
     for (const auto& face : faces) {
         for (int vertexIndex : face) {
-            const glm::vec3& position = vertices[vertexIndex];
-            const glm::vec3& normal = normals[vertexIndex];
-
-            vertexData.insert(vertexData.end(), {position.x, position.y, position.z});
-            vertexData.insert(vertexData.end(), {normal.x, normal.y, normal.z});
-            vertexData.insert(vertexData.end(), {color.r, color.g, color.b});
+            data.addVertex(vertices[vertexIndex], normals[vertexIndex]);
         }
     }
 
     for (size_t i = 0; i < faces.size(); ++i) {
-        indexData.insert(indexData.end(), {i * 3, i * 3 + 1, i * 3 + 2});
+        data.indexData.insert(data.indexData.end(), {static_cast<unsigned int>(i * 3), static_cast<unsigned int>(i * 3 + 1), static_cast<unsigned int>(i * 3 + 2)});
     }
 
-    // Create and bind VAO, VBO, and EBO
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float), vertexData.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexData.size() * sizeof(unsigned int), indexData.data(), GL_STATIC_DRAW);
-
-    // Configure vertex attributes
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)0); // Position
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(3 * sizeof(float))); // Normal
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 9 * sizeof(float), (void*)(6 * sizeof(float))); // Color
-    glEnableVertexAttribArray(2);
-
-    glBindVertexArray(0); // Unbind VAO
+    return data;
 }
 
 void Sphere::draw(GLuint shaderProgram) {
@@ -131,8 +93,8 @@ void Sphere::draw(GLuint shaderProgram) {
     }
 
     // Render the cube
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(faces.size() * 3), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(mesh->VAO);
+    glDrawElements(GL_TRIANGLES, mesh->indexCount, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 
     // Disable lighting after drawing the sphere (for axis rendering)
@@ -141,3 +103,10 @@ void Sphere::draw(GLuint shaderProgram) {
     }
 
 }
+
+
+// Queue the sphere for batched rendering
+bool Sphere::submit(RenderQueue& queue) {
+    queue.submit(mesh->VAO, mesh->indexCount, getMaterialColor(), getModelMatrix(), getNormalMatrix());
+    return true;
+}
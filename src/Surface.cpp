@@ -1,4 +1,5 @@
 #include "Surface.h"
+#include "JobSystem.h"
 
 namespace {
 // Check if the profile curve is flat on the xy-plane
@@ -27,26 +28,31 @@ Surface Surface::makeSurfRev(const Curve& profile, unsigned steps) {
 
     const CurvePoints& curvePoints = profile.getCurvePoints();
 
-    for (unsigned i = 0; i < curvePoints.size(); ++i) {
+    // Each profile point's ring is independent; rings are filled in parallel
+    surface.VV.resize(curvePoints.size() * steps);
+    surface.VN.resize(curvePoints.size() * steps);
+    JobSystem::parallelFor(0, curvePoints.size(), 16, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
 
-        for (unsigned j = 0; j < steps; ++j){
+            for (unsigned j = 0; j < steps; ++j){
 
-            float angle = 2.0f * glm::pi<float>() * static_cast<float>(j) / static_cast<float>(steps);
+                float angle = 2.0f * glm::pi<float>() * static_cast<float>(j) / static_cast<float>(steps);
 
-            glm::mat4 rotateM = glm::rotate( glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+                glm::mat4 rotateM = glm::rotate( glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f));
 
-            glm::vec4 profileVV( curvePoints[i].V, 1.0f);
+                glm::vec4 profileVV( curvePoints[i].V, 1.0f);
 
-            glm::vec3 surfaceVV = glm::vec3( rotateM * profileVV);
+                glm::vec3 surfaceVV = glm::vec3( rotateM * profileVV);
 
-            glm::vec3 surfaceVN = glm::normalize(glm::mat3(rotateM) * curvePoints[i].N);
+                glm::vec3 surfaceVN = glm::normalize(glm::mat3(rotateM) * curvePoints[i].N);
 
-            surface.VV.push_back( surfaceVV );
-            surface.VN.push_back( -surfaceVN );
+                surface.VV[i * steps + j] = surfaceVV;
+                surface.VN[i * steps + j] = -surfaceVN;
 
-        }
+            }
 
-    }
+        }
+    });
 
     for (unsigned i = 0; i < curvePoints.size() - 1; ++i) {
 
@@ -93,26 +99,30 @@ Surface Surface::makeGenCyl(const Curve& profile, const Curve& sweep) {
         return surface; // Return an empty surface
     }
 
-    // Build the surface vertices and normals
-    for (unsigned i = 0; i < sweepPoints.size(); ++i) {
-        glm::mat4 transform = glm::translate(glm::mat4(1.0f), sweepPoints[i].V);
-
-        glm::mat3 rotation(sweepPoints[i].N, sweepPoints[i].B, sweepPoints[i].T);
-        transform = transform * glm::mat4(rotation);
-
-        for (unsigned j = 0; j < profilePoints.size(); ++j) {
-            // Transform profile vertex
-            glm::vec4 profileVertex(profilePoints[j].V, 1.0f); 
-            glm::vec3 surfaceVertex = transform * profileVertex;
-
-           
-            glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(rotation))); 
-            glm::vec3 surfaceNormal = -glm::normalize(normalMatrix * profilePoints[j].N);
-            
-            surface.VV.push_back(surfaceVertex);
-            surface.VN.push_back(surfaceNormal);
+    // Build the surface vertices and normals; each sweep ring is filled in parallel
+    surface.VV.resize(sweepPoints.size() * profilePoints.size());
+    surface.VN.resize(sweepPoints.size() * profilePoints.size());
+    JobSystem::parallelFor(0, sweepPoints.size(), 16, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            glm::mat4 transform = glm::translate(glm::mat4(1.0f), sweepPoints[i].V);
+
+            glm::mat3 rotation(sweepPoints[i].N, sweepPoints[i].B, sweepPoints[i].T);
+            transform = transform * glm::mat4(rotation);
+
+            for (unsigned j = 0; j < profilePoints.size(); ++j) {
+                // Transform profile vertex
+                glm::vec4 profileVertex(profilePoints[j].V, 1.0f); 
+                glm::vec3 surfaceVertex = transform * profileVertex;
+
+               
+                glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(rotation))); 
+                glm::vec3 surfaceNormal = -glm::normalize(normalMatrix * profilePoints[j].N);
+                
+                surface.VV[i * profilePoints.size() + j] = surfaceVertex;
+                surface.VN[i * profilePoints.size() + j] = surfaceNormal;
+            }
         }
-    }
+    });
 
     // Build the faces
     for (unsigned i = 0; i < sweepPoints.size() - 1; ++i) {
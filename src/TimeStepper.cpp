@@ -1,6 +1,27 @@
 #include "ParticleSystem.h"
 #include "TimeStepper.h"
 #include "SimpleSystem.h"
+#include "CpuProfiler.h"
+#include "JobSystem.h"
+
+namespace {
+
+// State vectors are split across the job system in chunks of this many entries
+const size_t STATE_GRAIN = 2048;
+
+// Build a state whose entry i is expression(i), in parallel
+template <typename Expression>
+std::vector<glm::vec3> combineStates(size_t count, const Expression& expression) {
+    std::vector<glm::vec3> result(count);
+    JobSystem::parallelFor(0, count, STATE_GRAIN, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            result[i] = expression(i);
+        }
+    });
+    return result;
+}
+
+}
 
 // Constructor initializes the animation state
 TimeStepper::TimeStepper() : animationPlaying(false), stepSize(0.02f)  {}
@@ -36,6 +57,13 @@ void TimeStepper::setStepSize(float newStepSize) {
     stepSize = newStepSize;
 }
 
+// Advance the system's own state in place and rebuild its render data
+void TimeStepper::takeStep(ParticleSystem* particleSystem, float stepSize) {
+    PROFILE_SCOPE("TimeStepper::takeStep");
+    particleSystem->setState(integrate(particleSystem, particleSystem->getState(), stepSize));
+    particleSystem->updateParticles();
+}
+
 
 // Factory Method for Creating Integrators
 TimeStepper* TimeStepper::createIntegrator(IntegratorType type) {
@@ -54,7 +82,8 @@ TimeStepper* TimeStepper::createIntegrator(IntegratorType type) {
 }
 
 // Forward Euler Method
-void ForwardEuler::takeStep(ParticleSystem* particleSystem, float stepSize) {
+std::vector<glm::vec3> ForwardEuler::integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) {
+    PROFILE_SCOPE("ForwardEuler::integrate");
 
     // Euler's Method
     //
@@ -63,25 +92,19 @@ void ForwardEuler::takeStep(ParticleSystem* particleSystem, float stepSize) {
     // Get the current particle system state and have the particles in the state
     // take a step of size h using Forward Euler method 
 
-    std::vector<glm::vec3> currentState = particleSystem->getState();
+    const std::vector<glm::vec3>& currentState = state;
     std::vector<glm::vec3> fx = particleSystem->evalF(currentState);
 
-    std::vector<glm::vec3> newState;
-    for (size_t i = 0; i < currentState.size(); ++i) {
-
-        newState.push_back(currentState[i] + fx[i] * stepSize);
-    }
-
-    particleSystem->setState(newState);
-
-
-    // Call updateParticles() 
-    particleSystem->updateParticles();
+    std::vector<glm::vec3> newState = combineStates(currentState.size(), [&](size_t i) {
+        return currentState[i] + fx[i] * stepSize;
+    });
 
+    return newState;
 }
 
 // Trapezoidal Method
-void Trapezoidal::takeStep(ParticleSystem* particleSystem, float stepSize) {
+std::vector<glm::vec3> Trapezoidal::integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) {
+    PROFILE_SCOPE("Trapezoidal::integrate");
 
     // Trapezoid Method:
     //
@@ -92,34 +115,29 @@ void Trapezoidal::takeStep(ParticleSystem* particleSystem, float stepSize) {
     // Get the current particle system state and have the particles in the state
     // take a step of size h using Trapezoid method 
 
-    std::vector<glm::vec3> currentState = particleSystem->getState();
+    const std::vector<glm::vec3>& currentState = state;
     
     std::vector<glm::vec3> f0 = particleSystem->evalF(currentState);
 
-    std::vector<glm::vec3> intermediateState;
-    for (size_t i = 0; i < currentState.size(); ++i) {
-        intermediateState.push_back(currentState[i] + stepSize * f0[i]);
-    }
+    std::vector<glm::vec3> intermediateState = combineStates(currentState.size(), [&](size_t i) {
+        return currentState[i] + stepSize * f0[i];
+    });
 
     std::vector<glm::vec3> f1 = particleSystem->evalF(intermediateState);
 
-    std::vector<glm::vec3> newState;
-    for (size_t i = 0; i < currentState.size(); ++i) {
-        newState.push_back(currentState[i] + (stepSize / 2.0f) * (f0[i] + f1[i]));
-    }
+    std::vector<glm::vec3> newState = combineStates(currentState.size(), [&](size_t i) {
+        return currentState[i] + (stepSize / 2.0f) * (f0[i] + f1[i]);
+    });
 
     //run evalf twice, 
 
-    // Update the system state
-    particleSystem->setState(newState);
-
-    // Call updateParticles() 
-    particleSystem->updateParticles();
-
+    // The caller decides where the new state goes
+    return newState;
 }
 
 // Midpoint Method
-void Midpoint::takeStep(ParticleSystem* particleSystem, float stepSize) {
+std::vector<glm::vec3> Midpoint::integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) {
+    PROFILE_SCOPE("Midpoint::integrate");
 
     // Extra Credit: Midpoint Method
     
@@ -128,65 +146,54 @@ void Midpoint::takeStep(ParticleSystem* particleSystem, float stepSize) {
     // X(t+h) = X + h * k2
     
     // Get the current state
-    std::vector<glm::vec3> currentState = particleSystem->getState();
+    const std::vector<glm::vec3>& currentState = state;
     
     // Calculate k1 = f(X, t)
     std::vector<glm::vec3> k1 = particleSystem->evalF(currentState);
     
     // Calculate intermediate state X + h/2 * k1
-    std::vector<glm::vec3> intermediateState;
-    for (size_t i = 0; i < currentState.size(); ++i) {
-        intermediateState.push_back(currentState[i] + (stepSize / 2.0f) * k1[i]);
-    }
+    std::vector<glm::vec3> intermediateState = combineStates(currentState.size(), [&](size_t i) {
+        return currentState[i] + (stepSize / 2.0f) * k1[i];
+    });
     
     // Calculate k2 = f(X + h/2 * k1, t+h/2)
     std::vector<glm::vec3> k2 = particleSystem->evalF(intermediateState);
     
     // Calculate final state X(t+h) = X + h * k2
-    std::vector<glm::vec3> newState;
-    for (size_t i = 0; i < currentState.size(); ++i) {
-        newState.push_back(currentState[i] + stepSize * k2[i]);
-    }
+    std::vector<glm::vec3> newState = combineStates(currentState.size(), [&](size_t i) {
+        return currentState[i] + stepSize * k2[i];
+    });
     
-    // Update the system state
-    particleSystem->setState(newState);
-
-    // Call updateParticles() 
-    particleSystem->updateParticles();
+    // The caller decides where the new state goes
+    return newState;
 }
 
 
 // RK4 Method
-void RK4::takeStep(ParticleSystem* particleSystem, float stepSize) {
-    std::vector<glm::vec3> X1 = particleSystem->getState();
+std::vector<glm::vec3> RK4::integrate(ParticleSystem* particleSystem, const std::vector<glm::vec3>& state, float stepSize) {
+    PROFILE_SCOPE("RK4::integrate");
+    const std::vector<glm::vec3>& X1 = state;
     std::vector<glm::vec3> f1 = particleSystem->evalF(X1);
 
-    std::vector<glm::vec3> X2, X3, X4;
-    for (size_t i = 0; i < f1.size(); ++i) {
-        X2.push_back(X1[i] + stepSize / 2.0f * f1[i]);
-    }
+    std::vector<glm::vec3> X2 = combineStates(f1.size(), [&](size_t i) {
+        return X1[i] + stepSize / 2.0f * f1[i];
+    });
 
     std::vector<glm::vec3> f2 = particleSystem->evalF(X2);
-    for (size_t i = 0; i < f2.size(); ++i) {
-        X3.push_back(X1[i] + stepSize / 2.0f * f2[i]);
-    }
+    std::vector<glm::vec3> X3 = combineStates(f2.size(), [&](size_t i) {
+        return X1[i] + stepSize / 2.0f * f2[i];
+    });
 
     std::vector<glm::vec3> f3 = particleSystem->evalF(X3);
-    for (size_t i = 0; i < f3.size(); ++i) {
-        X4.push_back(X1[i] + stepSize * f3[i]);
-    }
+    std::vector<glm::vec3> X4 = combineStates(f3.size(), [&](size_t i) {
+        return X1[i] + stepSize * f3[i];
+    });
 
     std::vector<glm::vec3> f4 = particleSystem->evalF(X4);
 
-    std::vector<glm::vec3> newState;
-    for (size_t i = 0; i < X1.size(); ++i) {
-        newState.push_back(X1[i] + (stepSize / 6.0f) * (f1[i] + 2.0f * f2[i] + 2.0f * f3[i] + f4[i]));
-    }
+    std::vector<glm::vec3> newState = combineStates(X1.size(), [&](size_t i) {
+        return X1[i] + (stepSize / 6.0f) * (f1[i] + 2.0f * f2[i] + 2.0f * f3[i] + f4[i]);
+    });
 
-    particleSystem->setState(newState);
-    
-    // Call updateParticles() 
-    particleSystem->updateParticles();
-
-    
+    return newState;
 }